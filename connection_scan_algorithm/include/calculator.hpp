@@ -30,6 +30,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <limits>
+#include <memory>
 #include <stdlib.h>
 
 #include "json.hpp"
@@ -37,6 +38,7 @@
 #include "stop.hpp"
 #include "route.hpp"
 #include "trip.hpp"
+#include "connection_table.hpp"
 #include "point.hpp"
 #include "parameters.hpp"
 #include "routing_result.hpp"
@@ -46,6 +48,11 @@
 #include "cache_fetcher.hpp"
 #include "gtfs_fetcher.hpp"
 #include "csv_fetcher.hpp"
+#include "transit_network.hpp"
+#include "flat_network_cache.hpp"
+#include "query_context.hpp"
+#include "footpaths_cache.hpp"
+#include "perf_counters.hpp"
 
 extern int stepCount;
 
@@ -59,13 +66,21 @@ extern std::string consoleResetColor;
 namespace TrRouting
 {
   
+  // work done by a calculation, for the server metrics:
+  struct CalculationCounters {
+    long long scannedConnections   {0}; // connections between the first and the last connection of the scans
+    long long reachableConnections {0}; // scanned connections of enabled trips which could be boarded or were already boarded
+    long long osrmRequests         {0}; // osrm requests for access and egress footpaths
+  };
+  
   class Calculator {
   
   public:
     
     std::string applicationShortname;
     Calculator();
-    Calculator(Parameters& theParams);
+    Calculator(Parameters& theParams); // load a new network and context
+    Calculator(std::shared_ptr<const TransitNetwork> theNetwork, std::shared_ptr<QueryContext> theContext, Parameters& theParams); // share an already loaded network
     void                    prepare();
     void                    reset(bool resetAccessPaths = true);
     RoutingResult           calculate(bool resetAccessPaths = true);
@@ -73,20 +88,40 @@ namespace TrRouting
     std::tuple<int,int,int> reverseCalculation(); // best departure time, best access stop index, best access travel time: -1,-1,-1 if non routable, too long or all stops result
     RoutingResult           forwardJourney(int bestArrivalTime, int bestEgressStopIndex, int bestEgressTravelTime);
     RoutingResult           reverseJourney(int bestDepartureTime, int bestAccessStopIndex, int bestAccessTravelTime);
-    std::vector<Stop>                    stops;
-    std::map<unsigned long long, int>    stopIndexesById;
-    std::vector<Route>                   routes;
-    std::map<unsigned long long, int>    routeIndexesById;
+    std::vector<std::tuple<int,int,int,int,int,int>> profileCalculation(); // pareto-optimal journeys in the departure window, sorted by departure time. tuple: departure time, arrival time, access stop index, enter connection, exit connection, exit footpath
+    RoutingResult           profileJourneys(const std::vector<std::tuple<int,int,int,int,int,int>>& profile);
+    std::vector<std::tuple<int,int,int,int>> paretoCalculation(); // pareto front of arrival time and number of transfers, fewest boardings first. tuple: number of boardings, arrival time, last enter connection, last exit connection
+    RoutingResult           paretoJourneys(const std::vector<std::tuple<int,int,int,int>>& paretoFront);
+    RoutingResult           alternativesCalculation(int threadsCount); // fastest route and alternatives found by excluding combinations of the routes found, calculated by batches of threadsCount
     
+    std::shared_ptr<const TransitNetwork> network; // read-only, can be shared between calculators
+    std::shared_ptr<QueryContext>         context; // scratch arrays, only used by one calculator at a time
     
     Parameters params;
     CalculationTime algorithmCalculationTime;
-    std::vector<OdTrip>                  odTrips;
-    std::map<unsigned long long, int>    odTripIndexesById;
+    
+    // phases of a calculation, timed whether or not they are displayed (params.debugDisplay):
+    enum CalculationPhase { PHASE_RESET, PHASE_ACCESS_EGRESS, PHASE_FILTER_TRIPS, PHASE_FORWARD, PHASE_REVERSE, PHASE_PROFILE, PHASE_PARETO, PHASE_JOURNEY, PHASES_COUNT };
+    static const char * phaseName(int phase);
+    long long phasesDurationsMicroseconds[PHASES_COUNT]; // of the last calculation, -1 for the phases it did not run
+    CalculationCounters counters; // of the last calculation, zeroed by reset()
+    long long phasesHardwareCounters[PHASES_COUNT][PerfCounters::EVENTS_COUNT]; // of the last calculation when params.profileHardwareCounters, -1 for the phases it did not run and the unavailable events
 
   private:
     
-    enum connectionIndexes : short { STOP_DEP = 0, STOP_ARR = 1, TIME_DEP = 2, TIME_ARR = 3, TRIP = 4, CAN_BOARD = 5, CAN_UNBOARD = 6, SEQUENCE = 7 };
+    // profile entry of the stop with the earliest arrival at destination when ready to board at readyTime, NULL if none:
+    const std::tuple<int,int,int,int,int> * stopProfileEntry(int stopIndex, int readyTime);
+    
+    // json of a leg ridden from enter connection to exit connection (forward connections), adding its route id to routeIds:
+    nlohmann::json legJson(int enterConnection, int exitConnection, std::vector<unsigned long long>& routeIds);
+    
+    // add the time (and hardware events when profiled) since the end of the previous phase to this phase, displayed as "-- debugLabel --" in debug mode:
+    void endPhase(CalculationPhase phase, const char * debugLabel);
+    long long phaseStartHardwareCounters[PerfCounters::EVENTS_COUNT];
+    
+    // osrm footpaths from each point to the stops around it, using params.footpathsCache when set:
+    std::vector<std::vector<std::pair<int,int>>> getAccessibleStopsFootpathsFromPoints(const std::vector<Point>& points, const std::vector<int>& maxTravelTimesSeconds);
+    
     std::map<std::string,int> pickUpTypes = {
       {"regular", 0},
       {"no_pickup", 1},
@@ -103,32 +138,8 @@ namespace TrRouting
     int                                  departureTimeSeconds;
     int                                  initialDepartureTimeSeconds;
     int                                  arrivalTimeSeconds;
-    std::vector<Trip>                    trips;
-    std::map<unsigned long long, int>    tripIndexesById;
-    std::vector<std::tuple<int,int,int>> footpaths; // tuple: departingStopIndex, arrivalStopIndex, walkingTravelTimeSeconds
-    std::vector<std::pair<int,int>>      footpathsRanges; // index: stopIndex, pair: index of first footpath, index of last footpath
-    std::vector<int>                     stopsTentativeTime; // arrival time at stop (MAX_INT if not yet reached or unreachable)
-    std::vector<int>                     stopsReverseTentativeTime; // departure time at stop (MAX_INT if not yet reached or unreachable)
-    //std::vector<int>                     stopsD; // for reverse calculation with best departure time
-    ///std::vector<st::deque<std::pair<int,int>>> stopsReverseTentativeTime;
-    std::vector<int>                     stopsAccessTravelTime; // travel time from origin to accessible stops (-1 if unreachable by access mode)
-    std::vector<int>                     stopsEgressTravelTime; // travel time to reach destination (-1 if unreachable by egress mode)
-    //std::vector<int>                     stopsEgressFootpathTravelTimesSeconds; // not sure we need this...
-    std::vector<int>                     tripsEnterConnection; // index of the entering connection for each trip index 
-    std::vector<int>                     tripsEnterConnectionTransferTravelTime; // index of the entering connection for each trip index 
-    std::vector<int>                     tripsExitConnection; // index of the exiting connection for each trip index 
-    std::vector<int>                     tripsExitConnectionTransferTravelTime; // index of the exiting connection for each trip index 
-    //std::vector<int>                     tripsReverseTime;
-    std::vector<int>                     tripsEnabled; // allow/disallow use of this trip during calculation
-    std::vector<int>                     tripsUsable; // after forwarrd calculation, keep a list of usable trips in time range for reverse calculation
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> forwardConnections; // tuple: initialDepartureTimeSecondsStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> reverseConnections; // tuple: departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
     std::vector<std::pair<int,int>>      accessFootpaths; // pair: accessStopIndex, walkingTravelTimeSeconds
     std::vector<std::pair<int,int>>      egressFootpaths; // pair: egressStopIndex, walkingTravelTimeSeconds
-    std::vector<std::tuple<int,int,int,int,int,short>> forwardJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
-    std::vector<std::tuple<int,int,int,int,int,short>> forwardEgressJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
-    std::vector<std::tuple<int,int,int,int,int,short>> reverseJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
-    std::vector<std::tuple<int,int,int,int,int,short>> reverseAccessJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
     int                                  maxTimeValue;
     int                                  minAccessTravelTime;
     int                                  maxEgressTravelTime;
@@ -0,0 +1,41 @@
+#ifndef TR_FLAT_NETWORK_CACHE
+#define TR_FLAT_NETWORK_CACHE
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "transit_network.hpp"
+
+namespace TrRouting
+{
+
+  // versioned flat binary file holding a whole transit network (without od trips), loaded with mmap:
+  // every column of the connections, footpaths, trips, stops and routes tables, their string pools, id maps and the service calendars
+  // is used in place (no copy, shared between processes through the page cache).
+  //
+  // layout: FileHeader, SectionHeader table, then each section aligned on 64 bytes.
+  // The header checksum covers the header and the section table, each section has its own checksum.
+  class FlatNetworkCache {
+
+  public:
+
+    static const uint32_t formatVersion = 4;
+
+    static std::string filePath(std::string applicationShortname) { return applicationShortname + "_network.cache"; }
+
+    // write to a temporary file then rename, so processes still using the previous file are not affected:
+    static bool save(const TransitNetwork& network, std::string filePath);
+
+    // false (and network unchanged) if the file is missing, from another format version or memory layout, or corrupted:
+    static bool load(TransitNetwork& network, std::string filePath);
+
+    // true if the file exists and is newer than all these files (the caches or data it was built from):
+    static bool isUpToDate(std::string filePath, const std::vector<std::string>& sourceFilePaths);
+
+  };
+
+}
+
+#endif // TR_FLAT_NETWORK_CACHE
@@ -0,0 +1,54 @@
+#ifndef TR_QUERY_CONTEXT
+#define TR_QUERY_CONTEXT
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+
+#include "toolbox.hpp"
+#include "stamped_vector.hpp"
+#include "bit_words.hpp"
+#include "transit_network.hpp"
+
+namespace TrRouting
+{
+  
+  // per-query scratch arrays, sized for one transit network and reset (in constant time) by the calculator before each calculation.
+  // a context must only be used by one calculation at a time, but can be reused (pooled) between queries:
+  class QueryContext {
+  
+  public:
+    
+    QueryContext();
+    QueryContext(const TransitNetwork& network);
+    void prepare(const TransitNetwork& network);
+    
+    StampedVector<int>                   stopsTentativeTime; // arrival time at stop (MAX_INT if not yet reached or unreachable)
+    StampedVector<int>                   stopsReverseTentativeTime; // departure time at stop (MAX_INT if not yet reached or unreachable)
+    StampedVector<int>                   stopsAccessTravelTime; // travel time from origin to accessible stops (-1 if unreachable by access mode)
+    StampedVector<int>                   stopsEgressTravelTime; // travel time to reach destination (-1 if unreachable by egress mode)
+    StampedVector<int>                   tripsEnterConnection; // index of the entering connection for each trip index 
+    StampedVector<int>                   tripsEnterConnectionTransferTravelTime; // index of the entering connection for each trip index 
+    StampedVector<int>                   tripsExitConnection; // index of the exiting connection for each trip index 
+    StampedVector<int>                   tripsExitConnectionTransferTravelTime; // index of the exiting connection for each trip index 
+    std::vector<uint64_t>                tripsEnabledWords; // bitset of the trips allowed during calculation (date and filters), see BitWords
+    std::vector<uint64_t>                tripsFilterWords;  // scratch bitset used when applying the "only" filters
+    StampedVector<int>                   tripsUsable; // after forwarrd calculation, keep a list of usable trips in time range for reverse calculation
+    StampedVector<std::tuple<int,int,int,int,int,short>> forwardJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
+    StampedVector<std::tuple<int,int,int,int,int,short>> forwardEgressJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
+    StampedVector<std::tuple<int,int,int,int,int,short>> reverseJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
+    StampedVector<std::tuple<int,int,int,int,int,short>> reverseAccessJourneys; // index = stop index, tuple: final enter connection, final exit connection, final footpath, final exit trip index, transfer travel time, is same stop transfer (first, second, third and fourth values = -1 for access and egress journeys)
+    StampedVector<std::tuple<int,int,int>> tripsProfile; // profile query, index = trip index, tuple: arrival time at destination when on this trip, exit connection, exit footpath (-1: egress to destination)
+    std::vector<std::vector<std::tuple<int,int,int,int,int>>> stopsProfiles; // profile query, index = stop index, tuple: departure time, arrival time at destination, enter connection, exit connection, exit footpath. Sorted by descending departure and arrival times (pareto set), only the first stopsProfilesCounts entries are used
+    StampedVector<int> stopsProfilesCounts; // profile query, number of used entries in stopsProfiles, so the profiles keep their capacity between queries
+    
+    static const int maxParetoBoardings = 8; // pareto query (arrival time / number of transfers), labels kept for 0 (access) to this number of boardings, so journeys with more boardings are never found, even without max number of transfers
+    StampedVector<int> stopsTentativeTimeByBoardings; // pareto query, index = stop index * (maxParetoBoardings + 1) + number of boardings, value: arrival time ready to board. Allocated on first pareto query
+    StampedVector<std::tuple<int,int,int>> forwardJourneysByBoardings; // pareto query, same index, tuple: enter connection, exit connection, footpath (-1 for access)
+    StampedVector<int> tripsBoardingsCount; // pareto query, index = trip index, fewest boardings needed to be on this trip (MAX_INT if not reached yet)
+    
+  };
+  
+}
+
+#endif // TR_QUERY_CONTEXT
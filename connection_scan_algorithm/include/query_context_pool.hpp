@@ -0,0 +1,76 @@
+#ifndef TR_QUERY_CONTEXT_POOL
+#define TR_QUERY_CONTEXT_POOL
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "transit_network.hpp"
+#include "query_context.hpp"
+
+namespace TrRouting
+{
+  
+  // fixed set of query contexts for one network, borrowed by the server threads for the duration of a request.
+  // borrowed contexts are returned to the pool when the last shared_ptr to them is released:
+  class QueryContextPool {
+  
+  public:
+    
+    QueryContextPool(std::shared_ptr<const TransitNetwork> theNetwork, int contextsCount) : network(theNetwork)
+    {
+      for (int i = 0; i < contextsCount; i++)
+      {
+        contexts.push_back(std::unique_ptr<QueryContext>(new QueryContext(*network)));
+        availableContexts.push_back(contexts.back().get());
+      }
+    }
+    
+    // wait until a context is available if all of them are in use:
+    std::shared_ptr<QueryContext> borrow()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      contextAvailable.wait(lock, [this]{ return !availableContexts.empty(); });
+      QueryContext * context = availableContexts.back();
+      availableContexts.pop_back();
+      return std::shared_ptr<QueryContext>(context, [this](QueryContext * returnedContext) { giveBack(returnedContext); });
+    }
+    
+    // empty if all the contexts are in use, for callers which can do with fewer contexts rather than wait:
+    std::shared_ptr<QueryContext> tryBorrow()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (availableContexts.empty())
+      {
+        return std::shared_ptr<QueryContext>();
+      }
+      QueryContext * context = availableContexts.back();
+      availableContexts.pop_back();
+      return std::shared_ptr<QueryContext>(context, [this](QueryContext * returnedContext) { giveBack(returnedContext); });
+    }
+    
+    int size() const { return contexts.size(); }
+    
+  private:
+    
+    void giveBack(QueryContext * context)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        availableContexts.push_back(context);
+      }
+      contextAvailable.notify_one();
+    }
+    
+    std::shared_ptr<const TransitNetwork>      network;
+    std::vector<std::unique_ptr<QueryContext>> contexts;
+    std::vector<QueryContext *>                availableContexts;
+    std::mutex                                 mutex;
+    std::condition_variable                    contextAvailable;
+    
+  };
+  
+}
+
+#endif // TR_QUERY_CONTEXT_POOL
@@ -0,0 +1,66 @@
+#ifndef TR_ROUTING_QUERY
+#define TR_ROUTING_QUERY
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "json.hpp"
+#include "parameters.hpp"
+
+namespace TrRouting
+{
+
+  // part of the query string, parsed in place:
+  struct QuerySlice {
+
+    const char * begin;
+    const char * end;
+
+    int  size() const { return end - begin; }
+    bool equals(const char * literal) const;
+    bool isTrue()  const { return equals("true")  || equals("1"); }
+    bool isFalse() const { return equals("false") || equals("0"); }
+
+  };
+
+  // FNV-1a hash of parameter names, evaluated at compile time for the known names so they can be switch cases:
+  constexpr unsigned int queryParameterHash(const char * name, unsigned int hash = 2166136261u)
+  {
+    return *name == '\0' ? hash : queryParameterHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u);
+  }
+
+  // what a /route/v1/transit query string sets besides the calculator parameters. One query is kept by server thread and
+  // reused, so its strings and vectors keep their capacity from one request to the next:
+  struct RoutingQuery {
+
+    std::string calculationName;
+    std::string fileFormat;     // json, or csv (only with od trips)
+    bool        saveToFile;     // save result to file, it is still returned in the response
+    int         batchNumber;    // when using multiple batches (parallel calculations)
+    int         batchesCount;
+    int         odTripId;       // when calculating for only one od trip
+    bool        calculateAllOdTrips; // fetch all od trips from cache or database and calculate for all these trips
+    int         odTripsSampleSize;   // for testing only
+    int         timeHour;       // departure or arrival time, depending on calculation direction
+    int         timeMinute;
+
+    std::vector<std::pair<int,int>> odTripsPeriods; // pair: start_at_seconds, end_at_seconds
+    std::vector<std::string>        odTripsGenders;
+    std::vector<std::string>        odTripsAgeGroups;
+    std::vector<std::string>        odTripsOccupations;
+    std::vector<std::string>        odTripsActivities;
+    std::vector<std::string>        odTripsModes;
+
+    void reset(Parameters& params); // default values of the query and of the parameters a query can set
+    bool parse(const char * queryBegin, const char * queryEnd, Parameters& params); // false if a value is malformed, unknown parameters are ignored. No digit may follow queryEnd
+    
+    // query string of a query given in json (batch requests, replayed requests): the query string itself, or an object
+    // with its parameters (lists as arrays). Throws std::invalid_argument for other values:
+    static std::string queryString(const nlohmann::json& queryJson);
+
+  };
+
+}
+
+#endif // TR_ROUTING_QUERY
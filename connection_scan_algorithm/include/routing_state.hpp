@@ -0,0 +1,57 @@
+#ifndef TR_ROUTING_STATE
+#define TR_ROUTING_STATE
+
+#include <memory>
+#include <atomic>
+
+#include "transit_network.hpp"
+#include "query_context_pool.hpp"
+#include "footpaths_cache.hpp"
+#include "response_cache.hpp"
+
+namespace TrRouting
+{
+
+  // everything a request needs which depends on the loaded network: the network itself, query contexts sized for it,
+  // the footpaths cache (holding its stop indexes) and the responses cache. Never modified once published, a reload
+  // publishes a new one:
+  struct RoutingState {
+
+    std::shared_ptr<const TransitNetwork> network;
+    std::shared_ptr<QueryContextPool>     queryContextPool;
+    std::shared_ptr<QueryContextPool>     alternativesContextPool; // contexts of the alternatives workers (the requesting calculator is the first worker), shared by all requests
+    std::shared_ptr<QueryContextPool>     workersContextPool;      // one context per calculation worker thread (od trips and batches), so workers never wait for a context
+    std::shared_ptr<FootpathsCache>       footpathsCache; // empty when the footpaths cache is disabled
+    std::shared_ptr<ResponseCache>        responseCache;  // empty when the response cache is disabled, kept (but cleared) on reload
+    int                                   networkVersion; // incremented at each reload
+
+  };
+
+  // read-copy-update holder of the current routing state: requests take a reference to the current state when they start
+  // and keep using it until they finish, even if a new state is published meanwhile. The previous state (and its network)
+  // is freed when the last request using it releases its reference:
+  class RoutingStateHolder {
+
+  public:
+
+    RoutingStateHolder(std::shared_ptr<const RoutingState> initialState) : state(initialState), reloading(false) {}
+
+    std::shared_ptr<const RoutingState> current() const { return std::atomic_load(&state); }
+
+    void publish(std::shared_ptr<const RoutingState> newState) { std::atomic_store(&state, newState); }
+
+    // only one reload at a time, false if one is already running:
+    bool startReload()  { return !reloading.exchange(true); }
+    void finishReload() { reloading = false; }
+    bool isReloading() const { return reloading; }
+
+  private:
+
+    std::shared_ptr<const RoutingState> state;
+    std::atomic<bool>                   reloading;
+
+  };
+
+}
+
+#endif // TR_ROUTING_STATE
@@ -0,0 +1,67 @@
+#ifndef TR_TRANSIT_NETWORK
+#define TR_TRANSIT_NETWORK
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <iostream>
+
+#include "stop.hpp"
+#include "route.hpp"
+#include "trip.hpp"
+#include "od_trip.hpp"
+#include "stop_table.hpp"
+#include "route_table.hpp"
+#include "trip_table.hpp"
+#include "service.hpp"
+#include "service_calendar.hpp"
+#include "trips_bitsets.hpp"
+#include "id_index_map.hpp"
+#include "connection_table.hpp"
+#include "flat_column.hpp"
+#include "stops_spatial_index.hpp"
+#include "parameters.hpp"
+#include "database_fetcher.hpp"
+#include "cache_fetcher.hpp"
+#include "gtfs_fetcher.hpp"
+#include "csv_fetcher.hpp"
+
+namespace TrRouting
+{
+  
+  // timetable and od trips, loaded once in prepare() and never modified afterwards,
+  // so it can be shared (read-only) by all the calculators routing at the same time:
+  class TransitNetwork {
+  
+  public:
+    
+    TransitNetwork();
+    TransitNetwork(Parameters& params);
+    void prepare(Parameters& params);
+    
+    StopTable                            stops;
+    IdIndexMap                           stopIndexesById;
+    RouteTable                           routes;
+    IdIndexMap                           routeIndexesById;
+    TripTable                            trips;
+    IdIndexMap                           tripIndexesById;
+    ServiceCalendar                      calendar; // rules of the service calendars, giving the services running on a day
+    TripsBitsets                         routesTrips; // trips of each route id, used by the query filters
+    TripsBitsets                         routeTypesTrips;
+    TripsBitsets                         agenciesTrips;
+    TripsBitsets                         servicesTrips;
+    FlatColumn<std::tuple<int,int,int>>  footpaths; // tuple: departingStopIndex, arrivalStopIndex, walkingTravelTimeSeconds
+    FlatColumn<std::pair<int,int>>       footpathsRanges; // index: stopIndex, pair: index of first footpath, index of last footpath
+    ConnectionTable                      forwardConnections; // sorted by departure time, trip and sequence
+    ConnectionTable                      reverseConnections; // sorted by arrival time, trip and sequence, all descending
+    std::vector<OdTrip>                  odTrips;
+    IdIndexMap                           odTripIndexesById;
+    StopsSpatialIndex                    stopsSpatialIndex; // grid of stops, used to find access and egress stops around a point
+    
+  };
+  
+}
+
+#endif // TR_TRANSIT_NETWORK
@@ -0,0 +1,215 @@
+#include <set>
+
+#include "calculator.hpp"
+#include "combinations.hpp"
+#include "query_context_pool.hpp"
+#include "worker_pool.hpp"
+
+namespace TrRouting
+{
+
+  // fastest route, then routes found when excluding combinations of the routes already found. Combinations are calculated
+  // by batches, one per worker, on calculators sharing the network and the access/egress footpaths of the fastest route.
+  // Removing routes never makes a journey faster nor possible again, so combinations containing a combination without
+  // any route found (too long or no routing) are skipped: this is the travel time bound, as every calculation stops at
+  // params.maxTotalTravelTimeSeconds. Batches are made and their results used in the combinations order, so the alternatives
+  // found only depend on the number of threads when params.maxAlternatives stops the calculations. The json is the result of
+  // the last calculation, or the list of the alternatives found with params.alternativesList:
+  RoutingResult Calculator::alternativesCalculation(int threadsCount)
+  {
+    RoutingResult                                  result;
+    RoutingResult                                  fastestResult;
+    RoutingResult                                  lastResult;
+    nlohmann::json                                 json;
+    std::vector<unsigned long long>                foundRouteIds;
+    std::vector<std::vector<unsigned long long>>   allCombinations;
+    std::set<std::vector<unsigned long long>>      alreadyCalculatedCombinations;
+    std::set<std::vector<unsigned long long>>      alreadyFoundRouteIds;
+    std::vector<std::vector<unsigned long long>>   infeasibleCombinations;
+    std::vector<RoutingResult>                     alternatives;
+    int                                            maxTravelTime;
+    int                                            calculationsCount {1};
+    int                                            skippedCombinationsCount {0};
+
+    if (params.debugDisplay)
+    {
+      std::cout << "initialMaxTotalTravelTimeSeconds: " << params.maxTotalTravelTimeSeconds << std::endl;
+    }
+
+    fastestResult = calculate();
+    if (fastestResult.status != "success")
+    {
+      return fastestResult;
+    }
+
+    maxTravelTime = params.alternativesMaxTravelTimeRatio * fastestResult.travelTimeSeconds;
+    if (maxTravelTime < params.minAlternativeMaxTravelTimeSeconds)
+    {
+      params.maxTotalTravelTimeSeconds = params.minAlternativeMaxTravelTimeSeconds;
+    }
+    else if (maxTravelTime > fastestResult.travelTimeSeconds + params.alternativesMaxAddedTravelTimeSeconds)
+    {
+      params.maxTotalTravelTimeSeconds = fastestResult.travelTimeSeconds + params.alternativesMaxAddedTravelTimeSeconds;
+    }
+    else
+    {
+      params.maxTotalTravelTimeSeconds = maxTravelTime;
+    }
+    if (params.debugDisplay)
+    {
+      std::cout << "fastestTravelTimeSeconds: " << fastestResult.travelTimeSeconds << std::endl;
+      std::cout << "maxTotalTravelTimeSeconds: " << params.maxTotalTravelTimeSeconds << std::endl;
+    }
+
+    // excluding each combination of the found route ids (added to the combination which found them):
+    auto addCombinations = [&](const RoutingResult& routingResult, const std::vector<unsigned long long>& exceptRouteIds) {
+      foundRouteIds = routingResult.routeIds;
+      std::stable_sort(foundRouteIds.begin(), foundRouteIds.end());
+      if (foundRouteIds.size() == 0 || alreadyFoundRouteIds.count(foundRouteIds) > 0)
+      {
+        return;
+      }
+      alreadyFoundRouteIds.insert(foundRouteIds);
+      alternatives.push_back(routingResult);
+      for (int k = 1; k <= (int)foundRouteIds.size(); k++)
+      {
+        Combinations<unsigned long long> combinations(foundRouteIds, k);
+        for (auto newCombination : combinations)
+        {
+          newCombination.insert(newCombination.end(), exceptRouteIds.begin(), exceptRouteIds.end());
+          std::stable_sort(newCombination.begin(), newCombination.end());
+          if (alreadyCalculatedCombinations.count(newCombination) == 0)
+          {
+            allCombinations.push_back(newCombination);
+            alreadyCalculatedCombinations.insert(newCombination);
+          }
+        }
+      }
+    };
+    addCombinations(fastestResult, params.exceptRouteIds);
+
+    auto isInfeasible = [&](const std::vector<unsigned long long>& combination) {
+      for (auto & infeasibleCombination : infeasibleCombinations)
+      {
+        if (std::includes(combination.begin(), combination.end(), infeasibleCombination.begin(), infeasibleCombination.end()))
+        {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    // this calculator is the first worker, the others run on params.alternativesWorkers with a context borrowed from
+    // params.alternativesContextPool, or get their own context when there is no pool. Contexts used by other requests are
+    // not waited for: the workers available calculate the threadsCount combinations of each batch in turn, so the batches
+    // (and the alternatives found) stay the same. Without workers, this calculator calculates every batch:
+    std::vector<std::unique_ptr<Calculator>>     workers;
+    std::vector<Calculator *>                    workersCalculators {this};
+    std::vector<std::vector<unsigned long long>> batch;
+    std::vector<RoutingResult>                   batchResults;
+    std::vector<unsigned long long>              initialExceptRouteIds = params.exceptRouteIds;
+    int                                          combinationIndex {0};
+    while (combinationIndex < (int)allCombinations.size() && calculationsCount < params.maxAlternatives)
+    {
+      while (params.alternativesWorkers != NULL && (int)workersCalculators.size() < std::min(threadsCount, (int)allCombinations.size() - combinationIndex))
+      {
+        std::shared_ptr<QueryContext> workerContext = params.alternativesContextPool != NULL ? params.alternativesContextPool->tryBorrow() : std::make_shared<QueryContext>(*network);
+        if (!workerContext)
+        {
+          break;
+        }
+        workers.push_back(std::unique_ptr<Calculator>(new Calculator(network, workerContext, params)));
+        workers.back()->accessFootpaths = accessFootpaths;
+        workers.back()->egressFootpaths = egressFootpaths;
+        workers.back()->algorithmCalculationTime.start();
+        workersCalculators.push_back(workers.back().get());
+      }
+      
+      batch.clear();
+      while (combinationIndex < (int)allCombinations.size() && (int)batch.size() < std::max(1, threadsCount) && calculationsCount + (int)batch.size() < params.maxAlternatives)
+      {
+        if (isInfeasible(allCombinations[combinationIndex]))
+        {
+          skippedCombinationsCount++;
+        }
+        else
+        {
+          batch.push_back(allCombinations[combinationIndex]);
+        }
+        combinationIndex++;
+      }
+
+      batchResults.assign(batch.size(), RoutingResult());
+      int workersCount = std::min(workersCalculators.size(), batch.size());
+      auto calculateBatch = [&](int workerIndex) {
+        for (int batchIndex = workerIndex; batchIndex < (int)batch.size(); batchIndex += workersCount)
+        {
+          workersCalculators[workerIndex]->params.exceptRouteIds = batch[batchIndex];
+          batchResults[batchIndex] = workersCalculators[workerIndex]->calculate(false);
+        }
+      };
+      TasksGroup batchTasks;
+      for (int workerIndex = 1; workerIndex < workersCount; workerIndex++)
+      {
+        batchTasks.post(*params.alternativesWorkers, [&calculateBatch, workerIndex]() { calculateBatch(workerIndex); });
+      }
+      calculateBatch(0);
+      batchTasks.wait();
+
+      for (int batchIndex = 0; batchIndex < (int)batch.size(); batchIndex++)
+      {
+        calculationsCount++;
+        lastResult = batchResults[batchIndex];
+        if (batchResults[batchIndex].status != "success")
+        {
+          infeasibleCombinations.push_back(batch[batchIndex]);
+        }
+        else
+        {
+          addCombinations(batchResults[batchIndex], batch[batchIndex]);
+        }
+      }
+    }
+    params.exceptRouteIds = initialExceptRouteIds;
+
+    if (params.debugDisplay)
+    {
+      std::cout << calculationsCount << " calculations, " << skippedCombinationsCount << " combinations skipped, " << alternatives.size() << " alternatives found" << std::endl;
+      int alternativeNumber {1};
+      for (auto & alternative : alternatives)
+      {
+        std::cout << alternativeNumber << ". ";
+        for (auto routeId : alternative.routeIds)
+        {
+          std::cout << network->routes.shortname(network->routeIndexesById.at(routeId)) << " ";
+        }
+        std::cout << " tt: " << (alternative.travelTimeSeconds / 60) << std::endl;
+        alternativeNumber++;
+      }
+    }
+
+    result = fastestResult;
+    if (!params.alternativesList)
+    {
+      if (calculationsCount > 1)
+      {
+        result.json = lastResult.json;
+      }
+      return result;
+    }
+
+    json["status"]                      = "success";
+    json["numberOfAlternatives"]        = alternatives.size();
+    json["numberOfCalculations"]        = calculationsCount;
+    json["numberOfSkippedCombinations"] = skippedCombinationsCount;
+    json["alternatives"]                = nlohmann::json::array();
+    for (auto & alternative : alternatives)
+    {
+      json["alternatives"].push_back(nlohmann::json::parse(alternative.json));
+    }
+
+    result.json = json.dump(2);
+    return result;
+  }
+
+}
@@ -22,23 +22,43 @@ namespace TrRouting
     int bestAccessTravelTime {-1};
     int bestDepartureTime {-1};
 
-    if (departureTimeSeconds > -1)
+    if (departureTimeSeconds > -1 && params.departureWindowSeconds > 0 && !params.returnAllStopsResult)
+    {
+      
+      initialDepartureTimeSeconds = departureTimeSeconds;
+      
+      std::vector<std::tuple<int,int,int,int,int,int>> profile = profileCalculation();
+      endPhase(PHASE_PROFILE, "profile calculation");
+      
+      result = profileJourneys(profile);
+      endPhase(PHASE_JOURNEY, "profile journeys");
+      
+    }
+    else if (departureTimeSeconds > -1 && params.calculateByNumberOfTransfers && !params.returnAllStopsResult)
+    {
+      
+      initialDepartureTimeSeconds = departureTimeSeconds;
+      
+      std::vector<std::tuple<int,int,int,int>> paretoFront = paretoCalculation();
+      endPhase(PHASE_PARETO, "pareto calculation");
+      
+      result = paretoJourneys(paretoFront);
+      endPhase(PHASE_JOURNEY, "pareto journeys");
+      
+    }
+    else if (departureTimeSeconds > -1)
     {
       
       initialDepartureTimeSeconds = departureTimeSeconds; // set initial departure time so we can find the latest possible departure time with reverse calculation later and still know the initial waiting time
       
       std::tie(bestArrivalTime, bestEgressStopIndex, bestEgressTravelTime) = forwardCalculation();
 
-      if (params.debugDisplay)
-        std::cerr << "-- forward calculation -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-      calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+      endPhase(PHASE_FORWARD, "forward calculation");
       
       if (params.returnAllStopsResult)
       {
         result = forwardJourney(bestArrivalTime, bestEgressStopIndex, bestEgressTravelTime);
-        if (params.debugDisplay)
-          std::cerr << "-- forward journey -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-        calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+        endPhase(PHASE_JOURNEY, "forward journey");
       }
       else
       {
@@ -50,27 +70,21 @@ namespace TrRouting
           
           for (auto & egressFootpath : egressFootpaths) // reset stops reverse tentative times with new arrival time:
           {
-            stopsReverseTentativeTime[egressFootpath.first] = arrivalTimeSeconds - egressFootpath.second;
+            context->stopsReverseTentativeTime[egressFootpath.first] = arrivalTimeSeconds - egressFootpath.second;
           }
           
           std::tie(bestDepartureTime, bestAccessStopIndex, bestAccessTravelTime) = reverseCalculation();
-          if (params.debugDisplay)
-            std::cerr << "-- reverse calculation -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-          calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+          endPhase(PHASE_REVERSE, "reverse calculation");
           
           result = reverseJourney(bestDepartureTime, bestAccessStopIndex, bestAccessTravelTime);
-          if (params.debugDisplay)
-            std::cerr << "-- reverse journey -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-          calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+          endPhase(PHASE_JOURNEY, "reverse journey");
           
         }
         else
         {
           
           result = forwardJourney(bestArrivalTime, bestEgressStopIndex, bestEgressTravelTime);
-          if (params.debugDisplay)
-            std::cerr << "-- forward journey -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-          calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+          endPhase(PHASE_JOURNEY, "forward journey");
           
         }
         
@@ -79,17 +93,15 @@ namespace TrRouting
     else if (arrivalTimeSeconds > -1)
     {
       
-      std::fill(tripsUsable.begin(), tripsUsable.end(), 1); // we need to make all trips usable when not coming from forward result because reverse calculation, by default, checks for usableTrips == 1
+      context->tripsUsable.reset(1); // we need to make all trips usable when not coming from forward result because reverse calculation, by default, checks for usableTrips == 1
       
       std::tie(bestDepartureTime, bestAccessStopIndex, bestAccessTravelTime) = reverseCalculation();
-      if (params.debugDisplay)
-        std::cerr << "-- reverse calculation -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-      calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+      endPhase(PHASE_REVERSE, "reverse calculation");
 
+      initialDepartureTimeSeconds = bestDepartureTime; // no requested departure time, so the journey starts at the latest possible departure
+      
       result = reverseJourney(bestDepartureTime, bestAccessStopIndex, bestAccessTravelTime);
-      if (params.debugDisplay)
-        std::cerr << "-- reverse journey -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-      calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+      endPhase(PHASE_JOURNEY, "reverse journey");
 
     }
 
@@ -97,4 +109,35 @@ namespace TrRouting
     
   }
   
+  void Calculator::endPhase(CalculationPhase phase, const char * debugLabel)
+  {
+    long long phaseEndTime {algorithmCalculationTime.getDurationMicrosecondsNoStop()};
+    phasesDurationsMicroseconds[phase] = std::max(0LL, phasesDurationsMicroseconds[phase]) + phaseEndTime - calculationTime;
+    if (params.debugDisplay)
+      std::cerr << "-- " << debugLabel << " -- " << phaseEndTime - calculationTime << " microseconds\n";
+    calculationTime = phaseEndTime;
+    
+    if (params.profileHardwareCounters)
+    {
+      long long phaseEndHardwareCounters[PerfCounters::EVENTS_COUNT];
+      PerfCounters::ofThisThread().read(phaseEndHardwareCounters);
+      for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+      {
+        if (phaseEndHardwareCounters[event] >= 0 && phaseStartHardwareCounters[event] >= 0)
+        {
+          phasesHardwareCounters[phase][event] = std::max(0LL, phasesHardwareCounters[phase][event]) + phaseEndHardwareCounters[event] - phaseStartHardwareCounters[event];
+          if (params.debugDisplay)
+            std::cerr << "   " << PerfCounters::eventName(event) << ": " << phaseEndHardwareCounters[event] - phaseStartHardwareCounters[event] << "\n";
+        }
+        phaseStartHardwareCounters[event] = phaseEndHardwareCounters[event];
+      }
+    }
+  }
+  
+  const char * Calculator::phaseName(int phase)
+  {
+    static const char * phasesNames[PHASES_COUNT] {"reset", "accessEgress", "filterTrips", "forward", "reverse", "profile", "pareto", "journey"};
+    return phase >= 0 && phase < PHASES_COUNT ? phasesNames[phase] : "";
+  }
+  
 }
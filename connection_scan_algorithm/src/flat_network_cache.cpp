@@ -0,0 +1,566 @@
+#include "flat_network_cache.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+namespace TrRouting
+{
+
+  namespace
+  {
+
+    const char     fileMagic[8]   = {'T', 'R', 'N', 'E', 'T', 'F', 'L', 'T'};
+    const uint64_t sectionAlign   = 64;
+
+    enum SectionId : uint32_t {
+      FORWARD_CONNECTIONS = 100, // + ConnectionTable column index
+      REVERSE_CONNECTIONS = 200, // + ConnectionTable column index
+      FOOTPATHS           = 300,
+      FOOTPATHS_RANGES    = 301,
+      TRIPS               = 400, // + column index, see addTripColumns()
+      TRIP_IDS            = 450, // + IdIndexMap column index
+      STOPS               = 500, // + column index, see addStopColumns()
+      STOP_IDS            = 550, // + IdIndexMap column index
+      ROUTES              = 600, // + column index, see addRouteColumns()
+      ROUTE_IDS           = 650, // + IdIndexMap column index
+      CALENDAR            = 700  // + column index, see addCalendarColumns()
+    };
+
+    struct FileHeader {
+      char     magic[8];
+      uint32_t version;
+      uint32_t sectionsCount;
+      uint64_t fileSize;
+      uint64_t headerChecksum; // header (with this field set to 0) and section table
+      uint32_t layout[8];      // byte order, sizes and offsets of the records used in place, see getLayout()
+    };
+
+    struct SectionHeader {
+      uint32_t id;
+      uint32_t recordSize;
+      uint64_t offset;
+      uint64_t recordsCount;
+      uint64_t checksum;
+    };
+
+    // footpaths tuples, ranges pairs and stop points are used in place, so the file must have been written with the same
+    // in-memory layout (compiler, standard library and struct definitions; changing Point requires a new format version):
+    void getLayout(uint32_t layout[8])
+    {
+      std::tuple<int,int,int> footpath;
+      const char * footpathAddress = (const char *)&footpath;
+      Point        point;
+      layout[0] = 0x01020304;
+      layout[1] = sizeof(Point);
+      layout[2] = sizeof(std::tuple<int,int,int>);
+      layout[3] = (const char *)&std::get<0>(footpath) - footpathAddress;
+      layout[4] = (const char *)&std::get<1>(footpath) - footpathAddress;
+      layout[5] = (const char *)&std::get<2>(footpath) - footpathAddress;
+      layout[6] = sizeof(std::pair<int,int>);
+      layout[7] = (const char *)&point.longitude - (const char *)&point;
+    }
+
+    uint64_t checksum(const char * data, size_t size, uint64_t hash = 14695981039346656037ULL)
+    {
+      uint64_t word;
+      size_t   i {0};
+      for (; i + 8 <= size; i += 8)
+      {
+        std::memcpy(&word, data + i, 8);
+        hash  = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 29;
+      }
+      for (; i < size; i++)
+      {
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+      }
+      return hash;
+    }
+
+    uint64_t alignOffset(uint64_t offset)
+    {
+      return (offset + sectionAlign - 1) / sectionAlign * sectionAlign;
+    }
+
+    class MappedFile {
+
+    public:
+
+      MappedFile(const char * theData, size_t theSize) : data(theData), size(theSize) {}
+      ~MappedFile() { munmap((void *)data, size); }
+
+      const char * data;
+      size_t       size;
+
+    };
+
+    class SectionsWriter {
+
+    public:
+
+      template <typename T>
+      void add(uint32_t id, const T * records, size_t recordsCount)
+      {
+        sections.push_back(Section {id, sizeof(T), (const char *)records, recordsCount});
+      }
+
+      template <typename T>
+      void add(uint32_t id, const FlatColumn<T>& column)
+      {
+        add(id, column.data(), column.size());
+      }
+
+      bool write(std::string filePath)
+      {
+        std::vector<SectionHeader> sectionHeaders;
+        uint64_t offset = alignOffset(sizeof(FileHeader) + sections.size() * sizeof(SectionHeader));
+        for (auto & section : sections)
+        {
+          uint64_t size = section.recordSize * section.recordsCount;
+          sectionHeaders.push_back(SectionHeader {section.id, section.recordSize, offset, section.recordsCount, checksum(section.data, size)});
+          offset = alignOffset(offset + size);
+        }
+
+        FileHeader header;
+        std::memset(&header, 0, sizeof(FileHeader));
+        std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+        header.version       = FlatNetworkCache::formatVersion;
+        header.sectionsCount = sections.size();
+        header.fileSize      = offset;
+        getLayout(header.layout);
+        header.headerChecksum = checksum((const char *)sectionHeaders.data(), sectionHeaders.size() * sizeof(SectionHeader), checksum((const char *)&header, sizeof(FileHeader)));
+
+        std::string temporaryFilePath = filePath + ".tmp";
+        std::ofstream file(temporaryFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        file.write((const char *)&header, sizeof(FileHeader));
+        file.write((const char *)sectionHeaders.data(), sectionHeaders.size() * sizeof(SectionHeader));
+        uint64_t position = sizeof(FileHeader) + sectionHeaders.size() * sizeof(SectionHeader);
+        const std::vector<char> padding(sectionAlign, 0);
+        for (int i = 0; i < (int)sections.size(); i++)
+        {
+          file.write(padding.data(), sectionHeaders[i].offset - position);
+          file.write(sections[i].data, sections[i].recordSize * sections[i].recordsCount);
+          position = sectionHeaders[i].offset + sections[i].recordSize * sections[i].recordsCount;
+        }
+        file.write(padding.data(), header.fileSize - position);
+        file.close();
+        if (!file || std::rename(temporaryFilePath.c_str(), filePath.c_str()) != 0)
+        {
+          std::remove(temporaryFilePath.c_str());
+          return false;
+        }
+        return true;
+      }
+
+    private:
+
+      struct Section {
+        uint32_t     id;
+        uint32_t     recordSize;
+        const char * data;
+        uint64_t     recordsCount;
+      };
+
+      std::vector<Section> sections;
+
+    };
+
+    class SectionsReader {
+
+    public:
+
+      SectionsReader(std::shared_ptr<const MappedFile> theMappedFile) : mappedFile(theMappedFile) {}
+
+      // checks the header, layout, section bounds and all checksums, returns an error message or an empty string:
+      std::string validate()
+      {
+        const char * data = mappedFile->data;
+        FileHeader header;
+        if (mappedFile->size < sizeof(FileHeader))
+        {
+          return "file too small";
+        }
+        std::memcpy(&header, data, sizeof(FileHeader));
+        if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0)
+        {
+          return "not a network cache file";
+        }
+        if (header.version != FlatNetworkCache::formatVersion)
+        {
+          return "format version " + std::to_string(header.version) + " instead of " + std::to_string(FlatNetworkCache::formatVersion);
+        }
+        if (header.fileSize != mappedFile->size || sizeof(FileHeader) + header.sectionsCount * sizeof(SectionHeader) > mappedFile->size)
+        {
+          return "truncated file";
+        }
+        uint32_t layout[8];
+        getLayout(layout);
+        if (std::memcmp(layout, header.layout, sizeof(layout)) != 0)
+        {
+          return "written with another memory layout";
+        }
+        sectionHeaders.resize(header.sectionsCount);
+        std::memcpy(sectionHeaders.data(), data + sizeof(FileHeader), header.sectionsCount * sizeof(SectionHeader));
+        uint64_t headerChecksum = header.headerChecksum;
+        header.headerChecksum   = 0;
+        if (checksum((const char *)sectionHeaders.data(), sectionHeaders.size() * sizeof(SectionHeader), checksum((const char *)&header, sizeof(FileHeader))) != headerChecksum)
+        {
+          return "wrong header checksum";
+        }
+        for (auto & sectionHeader : sectionHeaders)
+        {
+          if (sectionHeader.offset % sectionAlign != 0 || sectionHeader.offset > header.fileSize || (header.fileSize - sectionHeader.offset) / std::max((uint32_t)1, sectionHeader.recordSize) < sectionHeader.recordsCount)
+          {
+            return "section " + std::to_string(sectionHeader.id) + " out of bounds";
+          }
+          if (checksum(data + sectionHeader.offset, sectionHeader.recordSize * sectionHeader.recordsCount) != sectionHeader.checksum)
+          {
+            return "wrong checksum for section " + std::to_string(sectionHeader.id);
+          }
+        }
+        return "";
+      }
+
+      template <typename T>
+      bool records(uint32_t id, const T *& records, size_t& recordsCount)
+      {
+        for (auto & sectionHeader : sectionHeaders)
+        {
+          if (sectionHeader.id == id && sectionHeader.recordSize == sizeof(T))
+          {
+            records      = (const T *)(mappedFile->data + sectionHeader.offset);
+            recordsCount = sectionHeader.recordsCount;
+            return true;
+          }
+        }
+        return false;
+      }
+
+      template <typename T>
+      bool column(uint32_t id, FlatColumn<T>& column)
+      {
+        const T * values;
+        size_t    valuesCount;
+        if (!records(id, values, valuesCount))
+        {
+          return false;
+        }
+        column = FlatColumn<T>::view(values, valuesCount, mappedFile);
+        return true;
+      }
+
+    private:
+
+      std::shared_ptr<const MappedFile> mappedFile;
+      std::vector<SectionHeader>        sectionHeaders;
+
+    };
+
+    void addConnectionColumns(SectionsWriter& writer, uint32_t firstSectionId, const ConnectionTable& connections)
+    {
+      writer.add(firstSectionId + ConnectionTable::TIME_DEP,    connections.departureTimes.data(),       connections.departureTimes.size());
+      writer.add(firstSectionId + ConnectionTable::TIME_ARR,    connections.arrivalTimes.data(),         connections.arrivalTimes.size());
+      writer.add(firstSectionId + ConnectionTable::TRIP,        connections.tripIndexes.data(),          connections.tripIndexes.size());
+      writer.add(firstSectionId + ConnectionTable::STOP_DEP,    connections.departureStopIndexes.data(), connections.departureStopIndexes.size());
+      writer.add(firstSectionId + ConnectionTable::STOP_ARR,    connections.arrivalStopIndexes.data(),   connections.arrivalStopIndexes.size());
+      writer.add(firstSectionId + ConnectionTable::CAN_BOARD,   connections.boardingFlags.data(),        connections.boardingFlags.size());
+      writer.add(firstSectionId + ConnectionTable::SEQUENCE,    connections.sequences.data(),            connections.sequences.size());
+    }
+
+    bool readConnectionColumns(SectionsReader& reader, uint32_t firstSectionId, ConnectionTable& connections)
+    {
+      return reader.column(firstSectionId + ConnectionTable::TIME_DEP,  connections.departureTimes)
+          && reader.column(firstSectionId + ConnectionTable::TIME_ARR,  connections.arrivalTimes)
+          && reader.column(firstSectionId + ConnectionTable::TRIP,      connections.tripIndexes)
+          && reader.column(firstSectionId + ConnectionTable::STOP_DEP,  connections.departureStopIndexes)
+          && reader.column(firstSectionId + ConnectionTable::STOP_ARR,  connections.arrivalStopIndexes)
+          && reader.column(firstSectionId + ConnectionTable::CAN_BOARD, connections.boardingFlags)
+          && reader.column(firstSectionId + ConnectionTable::SEQUENCE,  connections.sequences)
+          && connections.arrivalTimes.size()         == connections.departureTimes.size()
+          && connections.tripIndexes.size()          == connections.departureTimes.size()
+          && connections.departureStopIndexes.size() == connections.departureTimes.size()
+          && connections.arrivalStopIndexes.size()   == connections.departureTimes.size()
+          && connections.boardingFlags.size()        == connections.departureTimes.size()
+          && connections.sequences.size()            == connections.departureTimes.size();
+    }
+
+    void addStringPool(SectionsWriter& writer, uint32_t firstSectionId, const StringPool& strings)
+    {
+      writer.add(firstSectionId,     strings.characters);
+      writer.add(firstSectionId + 1, strings.offsets);
+    }
+
+    bool readStringPool(SectionsReader& reader, uint32_t firstSectionId, StringPool& strings)
+    {
+      return reader.column(firstSectionId,     strings.characters)
+          && reader.column(firstSectionId + 1, strings.offsets)
+          && strings.offsets.size() > 0
+          && strings.offsets.back() == strings.characters.size()
+          && std::is_sorted(strings.offsets.begin(), strings.offsets.end());
+    }
+
+    void addIdIndexMap(SectionsWriter& writer, uint32_t firstSectionId, const IdIndexMap& indexesById)
+    {
+      writer.add(firstSectionId,     indexesById.ids);
+      writer.add(firstSectionId + 1, indexesById.indexes);
+    }
+
+    bool readIdIndexMap(SectionsReader& reader, uint32_t firstSectionId, IdIndexMap& indexesById)
+    {
+      return reader.column(firstSectionId,     indexesById.ids)
+          && reader.column(firstSectionId + 1, indexesById.indexes)
+          && indexesById.indexes.size() == indexesById.ids.size();
+    }
+
+    // true if all the values are valid indexes of a table with tableSize rows:
+    template <typename T>
+    bool indexesBelow(const FlatColumn<T>& indexes, size_t tableSize)
+    {
+      for (auto & index : indexes)
+      {
+        if (index < 0 || (size_t)index >= tableSize)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void addStopColumns(SectionsWriter& writer, const StopTable& stops)
+    {
+      writer.add(STOPS,     stops.ids);
+      writer.add(STOPS + 1, stops.points);
+      writer.add(STOPS + 2, stops.stationIds);
+      writer.add(STOPS + 3, stops.codes);
+      writer.add(STOPS + 4, stops.names);
+      addStringPool(writer, STOPS + 5, stops.strings);
+    }
+
+    bool readStopColumns(SectionsReader& reader, StopTable& stops)
+    {
+      return reader.column(STOPS,     stops.ids)
+          && reader.column(STOPS + 1, stops.points)
+          && reader.column(STOPS + 2, stops.stationIds)
+          && reader.column(STOPS + 3, stops.codes)
+          && reader.column(STOPS + 4, stops.names)
+          && readStringPool(reader, STOPS + 5, stops.strings)
+          && stops.points.size()     == stops.ids.size()
+          && stops.stationIds.size() == stops.ids.size()
+          && stops.codes.size()      == stops.ids.size()
+          && stops.names.size()      == stops.ids.size()
+          && indexesBelow(stops.codes, stops.strings.size())
+          && indexesBelow(stops.names, stops.strings.size());
+    }
+
+    void addRouteColumns(SectionsWriter& writer, const RouteTable& routes)
+    {
+      writer.add(ROUTES,     routes.ids);
+      writer.add(ROUTES + 1, routes.agencyIds);
+      writer.add(ROUTES + 2, routes.routeTypeIds);
+      writer.add(ROUTES + 3, routes.agencyAcronyms);
+      writer.add(ROUTES + 4, routes.agencyNames);
+      writer.add(ROUTES + 5, routes.shortnames);
+      writer.add(ROUTES + 6, routes.longnames);
+      writer.add(ROUTES + 7, routes.routeTypeNames);
+      addStringPool(writer, ROUTES + 8, routes.strings);
+    }
+
+    bool readRouteColumns(SectionsReader& reader, RouteTable& routes)
+    {
+      bool ok = reader.column(ROUTES,     routes.ids)
+             && reader.column(ROUTES + 1, routes.agencyIds)
+             && reader.column(ROUTES + 2, routes.routeTypeIds)
+             && reader.column(ROUTES + 3, routes.agencyAcronyms)
+             && reader.column(ROUTES + 4, routes.agencyNames)
+             && reader.column(ROUTES + 5, routes.shortnames)
+             && reader.column(ROUTES + 6, routes.longnames)
+             && reader.column(ROUTES + 7, routes.routeTypeNames)
+             && readStringPool(reader, ROUTES + 8, routes.strings)
+             && routes.agencyIds.size()    == routes.ids.size()
+             && routes.routeTypeIds.size() == routes.ids.size();
+      for (const FlatColumn<unsigned int> * stringIndexes : {&routes.agencyAcronyms, &routes.agencyNames, &routes.shortnames, &routes.longnames, &routes.routeTypeNames})
+      {
+        ok = ok && stringIndexes->size() == routes.ids.size() && indexesBelow(*stringIndexes, routes.strings.size());
+      }
+      return ok;
+    }
+
+    void addTripColumns(SectionsWriter& writer, const TripTable& trips)
+    {
+      writer.add(TRIPS,      trips.ids);
+      writer.add(TRIPS + 1,  trips.routeIdIndexes);
+      writer.add(TRIPS + 2,  trips.routePathIdIndexes);
+      writer.add(TRIPS + 3,  trips.serviceIdIndexes);
+      writer.add(TRIPS + 4,  trips.routeTypeIdIndexes);
+      writer.add(TRIPS + 5,  trips.agencyIdIndexes);
+      writer.add(TRIPS + 6,  trips.routeIds);
+      writer.add(TRIPS + 7,  trips.routePathIds);
+      writer.add(TRIPS + 8,  trips.serviceIds);
+      writer.add(TRIPS + 9,  trips.routeTypeIds);
+      writer.add(TRIPS + 10, trips.agencyIds);
+    }
+
+    bool readTripColumns(SectionsReader& reader, TripTable& trips)
+    {
+      return reader.column(TRIPS,      trips.ids)
+          && reader.column(TRIPS + 1,  trips.routeIdIndexes)
+          && reader.column(TRIPS + 2,  trips.routePathIdIndexes)
+          && reader.column(TRIPS + 3,  trips.serviceIdIndexes)
+          && reader.column(TRIPS + 4,  trips.routeTypeIdIndexes)
+          && reader.column(TRIPS + 5,  trips.agencyIdIndexes)
+          && reader.column(TRIPS + 6,  trips.routeIds)
+          && reader.column(TRIPS + 7,  trips.routePathIds)
+          && reader.column(TRIPS + 8,  trips.serviceIds)
+          && reader.column(TRIPS + 9,  trips.routeTypeIds)
+          && reader.column(TRIPS + 10, trips.agencyIds)
+          && trips.routeIdIndexes.size()     == trips.ids.size() && indexesBelow(trips.routeIdIndexes,     trips.routeIds.size())
+          && trips.routePathIdIndexes.size() == trips.ids.size() && indexesBelow(trips.routePathIdIndexes, trips.routePathIds.size())
+          && trips.serviceIdIndexes.size()   == trips.ids.size() && indexesBelow(trips.serviceIdIndexes,   trips.serviceIds.size())
+          && trips.routeTypeIdIndexes.size() == trips.ids.size() && indexesBelow(trips.routeTypeIdIndexes, trips.routeTypeIds.size())
+          && trips.agencyIdIndexes.size()    == trips.ids.size() && indexesBelow(trips.agencyIdIndexes,    trips.agencyIds.size());
+    }
+
+    void addCalendarColumns(SectionsWriter& writer, const ServiceCalendar& calendar)
+    {
+      writer.add(CALENDAR,     calendar.serviceIds);
+      writer.add(CALENDAR + 1, calendar.startDays);
+      writer.add(CALENDAR + 2, calendar.endDays);
+      writer.add(CALENDAR + 3, calendar.weekdays);
+      writer.add(CALENDAR + 4, calendar.onlyDaysOffsets);
+      writer.add(CALENDAR + 5, calendar.onlyDays);
+      writer.add(CALENDAR + 6, calendar.exceptDaysOffsets);
+      writer.add(CALENDAR + 7, calendar.exceptDays);
+    }
+
+    bool readCalendar(SectionsReader& reader, ServiceCalendar& calendar)
+    {
+      return reader.column(CALENDAR,     calendar.serviceIds)
+          && reader.column(CALENDAR + 1, calendar.startDays)
+          && reader.column(CALENDAR + 2, calendar.endDays)
+          && reader.column(CALENDAR + 3, calendar.weekdays)
+          && reader.column(CALENDAR + 4, calendar.onlyDaysOffsets)
+          && reader.column(CALENDAR + 5, calendar.onlyDays)
+          && reader.column(CALENDAR + 6, calendar.exceptDaysOffsets)
+          && reader.column(CALENDAR + 7, calendar.exceptDays)
+          && (calendar.serviceIds.size() == 0 || calendar.isValid());
+    }
+
+  }
+
+  bool FlatNetworkCache::save(const TransitNetwork& network, std::string filePath)
+  {
+    std::cout << "Saving network to flat cache file " << filePath << "..." << std::endl;
+
+    SectionsWriter writer;
+    addConnectionColumns(writer, FORWARD_CONNECTIONS, network.forwardConnections);
+    addConnectionColumns(writer, REVERSE_CONNECTIONS, network.reverseConnections);
+    writer.add(FOOTPATHS,        network.footpaths);
+    writer.add(FOOTPATHS_RANGES, network.footpathsRanges);
+    addTripColumns(writer,  network.trips);
+    addIdIndexMap(writer,   TRIP_IDS, network.tripIndexesById);
+    addStopColumns(writer,  network.stops);
+    addIdIndexMap(writer,   STOP_IDS, network.stopIndexesById);
+    addRouteColumns(writer, network.routes);
+    addIdIndexMap(writer,   ROUTE_IDS, network.routeIndexesById);
+    addCalendarColumns(writer, network.calendar);
+
+    if (!writer.write(filePath))
+    {
+      std::cerr << "could not write flat cache file " << filePath << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool FlatNetworkCache::load(TransitNetwork& network, std::string filePath)
+  {
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+      return false;
+    }
+    std::cout << "Fetching network from flat cache file " << filePath << "..." << std::endl;
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+      close(fileDescriptor);
+      return false;
+    }
+    void * address = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (address == MAP_FAILED)
+    {
+      std::cerr << "could not map flat cache file " << filePath << std::endl;
+      return false;
+    }
+
+    SectionsReader reader(std::make_shared<const MappedFile>((const char *)address, (size_t)fileStat.st_size));
+    std::string error = reader.validate();
+    if (!error.empty())
+    {
+      std::cerr << "ignoring flat cache file " << filePath << ": " << error << std::endl;
+      return false;
+    }
+
+    // fill a new network, so the given one is only replaced when the whole file could be read:
+    TransitNetwork loadedNetwork;
+    bool           ok = readConnectionColumns(reader, FORWARD_CONNECTIONS, loadedNetwork.forwardConnections)
+                     && readConnectionColumns(reader, REVERSE_CONNECTIONS, loadedNetwork.reverseConnections)
+                     && reader.column(FOOTPATHS,        loadedNetwork.footpaths)
+                     && reader.column(FOOTPATHS_RANGES, loadedNetwork.footpathsRanges)
+                     && readTripColumns(reader,  loadedNetwork.trips)
+                     && readIdIndexMap(reader,   TRIP_IDS, loadedNetwork.tripIndexesById)
+                     && readStopColumns(reader,  loadedNetwork.stops)
+                     && readIdIndexMap(reader,   STOP_IDS, loadedNetwork.stopIndexesById)
+                     && readRouteColumns(reader, loadedNetwork.routes)
+                     && readIdIndexMap(reader,   ROUTE_IDS, loadedNetwork.routeIndexesById)
+                     && readCalendar(reader,     loadedNetwork.calendar);
+    if (!ok)
+    {
+      std::cerr << "ignoring flat cache file " << filePath << ": missing or malformed sections" << std::endl;
+      return false;
+    }
+
+    network.stops              = std::move(loadedNetwork.stops);
+    network.stopIndexesById    = std::move(loadedNetwork.stopIndexesById);
+    network.routes             = std::move(loadedNetwork.routes);
+    network.routeIndexesById   = std::move(loadedNetwork.routeIndexesById);
+    network.trips              = std::move(loadedNetwork.trips);
+    network.tripIndexesById    = std::move(loadedNetwork.tripIndexesById);
+    network.calendar           = std::move(loadedNetwork.calendar);
+    network.footpaths          = std::move(loadedNetwork.footpaths);
+    network.footpathsRanges    = std::move(loadedNetwork.footpathsRanges);
+    network.forwardConnections = std::move(loadedNetwork.forwardConnections);
+    network.reverseConnections = std::move(loadedNetwork.reverseConnections);
+    return true;
+  }
+
+  bool FlatNetworkCache::isUpToDate(std::string filePath, const std::vector<std::string>& sourceFilePaths)
+  {
+    boost::system::error_code errorCode;
+    std::time_t fileTime = boost::filesystem::last_write_time(filePath, errorCode);
+    if (errorCode)
+    {
+      return false;
+    }
+    for (auto & sourceFilePath : sourceFilePaths)
+    {
+      std::time_t sourceFileTime = boost::filesystem::last_write_time(sourceFilePath, errorCode);
+      if (!errorCode && sourceFileTime > fileTime) // missing sources are ignored
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+}
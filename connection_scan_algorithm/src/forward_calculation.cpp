@@ -6,7 +6,7 @@ namespace TrRouting
   std::tuple<int,int,int> Calculator::forwardCalculation()
   {
     int  i {0};
-    int  connectionsCount = forwardConnections.size();
+    int  connectionsCount = network->forwardConnections.size();
     int  reachableConnectionsCount {0};
     int  tripIndex {-1};
     int  stopDepartureIndex {-1};
@@ -28,57 +28,65 @@ namespace TrRouting
     int  bestArrivalTime {MAX_INT};
     
     
+    const int * departureTimes = network->forwardConnections.departureTimes.data();
+    const int * tripIndexes    = network->forwardConnections.tripIndexes.data();
+    const uint64_t * tripsEnabledWords = context->tripsEnabledWords.data();
+    
+    // jump directly to the first connection departing after departure time + minimum access travel time
+    // and stop after the last one departing within the max total travel time:
+    int startConnectionIndex = network->forwardConnections.firstDepartingAtOrAfter((int)std::min((long long)departureTimeSeconds + minAccessTravelTime, (long long)MAX_INT));
+    int endConnectionIndex   = network->forwardConnections.firstDepartingAfter(    (int)std::min((long long)departureTimeSeconds + params.maxTotalTravelTimeSeconds, (long long)MAX_INT));
+    
     // main loop:
-    i = 0;
-    for(auto & connection : forwardConnections)
+    for(i = startConnectionIndex; i < endConnectionIndex; i++)
     {
 
       // ignore connections before departure time + minimum access travel time:
-      if (std::get<connectionIndexes::TIME_DEP>(connection) >= departureTimeSeconds + minAccessTravelTime)
+      if (departureTimes[i] >= departureTimeSeconds + minAccessTravelTime)
       {
-        tripIndex = std::get<connectionIndexes::TRIP>(connection);
+        tripIndex = tripIndexes[i];
         
         // enabled trips only here:
-        if (tripsEnabled[tripIndex] != -1)
+        if (BitWords::test(tripsEnabledWords, tripIndex))
         {
-          connectionDepartureTime = std::get<connectionIndexes::TIME_DEP>(connection);
+          connectionDepartureTime = departureTimes[i];
           
           // no need to parse next connections if already reached destination from all egress stops:
           if ( (!params.returnAllStopsResult && reachedAtLeastOneEgressStop && maxEgressTravelTime >= 0 && tentativeEgressStopArrivalTime < MAX_INT && connectionDepartureTime > tentativeEgressStopArrivalTime + maxEgressTravelTime) || (connectionDepartureTime - departureTimeSeconds > params.maxTotalTravelTimeSeconds))
           {
             break;
           }
-          tripEnterConnectionIndex   = tripsEnterConnection[tripIndex];
-          stopDepartureIndex         = std::get<connectionIndexes::STOP_DEP>(connection);
-          stopDepartureTentativeTime = stopsTentativeTime[stopDepartureIndex];
+          tripEnterConnectionIndex   = context->tripsEnterConnection[tripIndex];
+          stopDepartureIndex         = network->forwardConnections.departureStopIndexes[i];
+          stopDepartureTentativeTime = context->stopsTentativeTime[stopDepartureIndex];
           
           // reachable connections only here:
           if (tripEnterConnectionIndex != -1 || stopDepartureTentativeTime <= connectionDepartureTime)
           {
             
-            //std::get<5>(forwardJourneys[stopDepartureIndex]) != 1 
+            //std::get<5>(context->forwardJourneys[stopDepartureIndex]) != 1 
             
-            if (std::get<connectionIndexes::CAN_BOARD>(connection) == 1 && (tripEnterConnectionIndex == -1 || (std::get<0>(forwardJourneys[stopDepartureIndex]) == -1 && std::get<4>(forwardJourneys[stopDepartureIndex]) >= 0 && std::get<4>(forwardJourneys[stopDepartureIndex]) < tripsEnterConnectionTransferTravelTime[tripIndex])))
-            //( tripEnterConnectionIndex == -1) || (std::get<5>(forwardJourneys[stopDepartureIndex]) != 1 && (std::get<0>(forwardJourneys[stopDepartureIndex]) == -1 || std::get<connectionIndexes::TRIP>(forwardConnections[std::get<0>(forwardJourneys[stopDepartureIndex])]) == tripIndex) && std::get<4>(forwardJourneys[stopDepartureIndex]) >= 0 && std::get<4>(forwardJourneys[stopDepartureIndex]) < tripsEnterConnectionTransferTravelTime[tripIndex]))
+            if (network->forwardConnections.canBoard(i) && (tripEnterConnectionIndex == -1 || (std::get<0>(context->forwardJourneys[stopDepartureIndex]) == -1 && std::get<4>(context->forwardJourneys[stopDepartureIndex]) >= 0 && std::get<4>(context->forwardJourneys[stopDepartureIndex]) < context->tripsEnterConnectionTransferTravelTime[tripIndex])))
+            //( tripEnterConnectionIndex == -1) || (std::get<5>(context->forwardJourneys[stopDepartureIndex]) != 1 && (std::get<0>(context->forwardJourneys[stopDepartureIndex]) == -1 || network->forwardConnections.tripIndexes[std::get<0>(context->forwardJourneys[stopDepartureIndex])] == tripIndex) && std::get<4>(context->forwardJourneys[stopDepartureIndex]) >= 0 && std::get<4>(context->forwardJourneys[stopDepartureIndex]) < context->tripsEnterConnectionTransferTravelTime[tripIndex]))
             //)
             {
               //if (tripEnterConnectionIndex != -1)
               //{
-              //  std::cerr << "from_stop: " << stops[std::get<0>(footpaths[std::get<2>(forwardJourneys[stopDepartureIndex])])].name << " route:" << routes[routeIndexesById[trips[tripIndex].routeId]].shortname << " " << routes[routeIndexesById[trips[tripIndex].routeId]].longname << " old stop:" << stops[std::get<connectionIndexes::STOP_DEP>(forwardConnections[std::get<0>(forwardJourneys[stopDepartureIndex])])].name << " stop:" << stops[stopDepartureIndex].name << " tec:" <<  tripEnterConnectionIndex << " i:" <<  i << " jss:" <<  std::get<5>(forwardJourneys[stopDepartureIndex]) << " jenterc:" << std::get<0>(forwardJourneys[stopDepartureIndex]) << " jexitc:" << std::get<1>(forwardJourneys[stopDepartureIndex]) << " jtt:" << std::get<4>(forwardJourneys[stopDepartureIndex]) << " tectt:" << tripsEnterConnectionTransferTravelTime[tripIndex] << std::endl;
+              //  std::cerr << "from_stop: " << network->stops[std::get<0>(network->footpaths[std::get<2>(context->forwardJourneys[stopDepartureIndex])])].name << " route:" << network->routes[network->routeIndexesById[network->trips[tripIndex].routeId]].shortname << " " << network->routes[network->routeIndexesById[network->trips[tripIndex].routeId]].longname << " old stop:" << network->stops[network->forwardConnections.departureStopIndexes[std::get<0>(context->forwardJourneys[stopDepartureIndex])]].name << " stop:" << network->stops[stopDepartureIndex].name << " tec:" <<  tripEnterConnectionIndex << " i:" <<  i << " jss:" <<  std::get<5>(context->forwardJourneys[stopDepartureIndex]) << " jenterc:" << std::get<0>(context->forwardJourneys[stopDepartureIndex]) << " jexitc:" << std::get<1>(context->forwardJourneys[stopDepartureIndex]) << " jtt:" << std::get<4>(context->forwardJourneys[stopDepartureIndex]) << " tectt:" << context->tripsEnterConnectionTransferTravelTime[tripIndex] << std::endl;
               //}
-              tripsUsable[tripIndex]                            = 1;
-              tripsEnterConnection[tripIndex]                   = i;
-              tripsEnterConnectionTransferTravelTime[tripIndex] = std::get<4>(forwardJourneys[stopDepartureIndex]);
+              context->tripsUsable[tripIndex]                            = 1;
+              context->tripsEnterConnection[tripIndex]                   = i;
+              context->tripsEnterConnectionTransferTravelTime[tripIndex] = std::get<4>(context->forwardJourneys[stopDepartureIndex]);
             }
             
-            if (std::get<connectionIndexes::CAN_UNBOARD>(connection) == 1 && tripsEnterConnection[tripIndex] != -1)
+            if (network->forwardConnections.canUnboard(i) && context->tripsEnterConnection[tripIndex] != -1)
             {
               // get footpaths for the arrival stop to get transferable stops:
-              stopArrivalIndex      = std::get<connectionIndexes::STOP_ARR>(connection);
-              connectionArrivalTime = std::get<connectionIndexes::TIME_ARR>(connection);
-              footpathsRangeStart   = footpathsRanges[stopArrivalIndex].first;
-              footpathsRangeEnd     = footpathsRanges[stopArrivalIndex].second;
-              if (!params.returnAllStopsResult && !reachedAtLeastOneEgressStop && stopsEgressTravelTime[stopArrivalIndex] != -1) // check if the arrival stop is egressable
+              stopArrivalIndex      = network->forwardConnections.arrivalStopIndexes[i];
+              connectionArrivalTime = network->forwardConnections.arrivalTimes[i];
+              footpathsRangeStart   = network->footpathsRanges[stopArrivalIndex].first;
+              footpathsRangeEnd     = network->footpathsRanges[stopArrivalIndex].second;
+              if (!params.returnAllStopsResult && !reachedAtLeastOneEgressStop && context->stopsEgressTravelTime[stopArrivalIndex] != -1) // check if the arrival stop is egressable
               {
                 reachedAtLeastOneEgressStop    = true;
                 tentativeEgressStopArrivalTime = connectionArrivalTime;
@@ -88,18 +96,18 @@ namespace TrRouting
                 footpathIndex = footpathsRangeStart;
                 while (footpathIndex <= footpathsRangeEnd)
                 {
-                  footpathStopArrivalIndex = std::get<1>(footpaths[footpathIndex]);
-                  footpathTravelTime       = std::get<2>(footpaths[footpathIndex]);
+                  footpathStopArrivalIndex = std::get<1>(network->footpaths[footpathIndex]);
+                  footpathTravelTime       = std::get<2>(network->footpaths[footpathIndex]);
                   if (footpathTravelTime <= params.maxTransferWalkingTravelTimeSeconds)
                   {
-                    if (footpathTravelTime + params.minWaitingTimeSeconds + connectionArrivalTime < stopsTentativeTime[footpathStopArrivalIndex])
+                    if (footpathTravelTime + params.minWaitingTimeSeconds + connectionArrivalTime < context->stopsTentativeTime[footpathStopArrivalIndex])
                     {
-                      stopsTentativeTime[footpathStopArrivalIndex] = footpathTravelTime + connectionArrivalTime + params.minWaitingTimeSeconds;
-                      forwardJourneys[footpathStopArrivalIndex]    = std::make_tuple(tripsEnterConnection[tripIndex], i, footpathIndex, tripIndex, footpathTravelTime, (stopArrivalIndex == footpathStopArrivalIndex ? 1 : -1));
+                      context->stopsTentativeTime[footpathStopArrivalIndex] = footpathTravelTime + connectionArrivalTime + params.minWaitingTimeSeconds;
+                      context->forwardJourneys[footpathStopArrivalIndex]    = std::make_tuple(context->tripsEnterConnection[tripIndex], i, footpathIndex, tripIndex, footpathTravelTime, (stopArrivalIndex == footpathStopArrivalIndex ? 1 : -1));
                     }
-                    if (stopArrivalIndex == footpathStopArrivalIndex && (std::get<4>(forwardEgressJourneys[footpathStopArrivalIndex]) == -1 || std::get<connectionIndexes::TIME_ARR>(forwardConnections[std::get<1>(forwardEgressJourneys[footpathStopArrivalIndex])]) > connectionArrivalTime))
+                    if (stopArrivalIndex == footpathStopArrivalIndex && (std::get<4>(context->forwardEgressJourneys[footpathStopArrivalIndex]) == -1 || network->forwardConnections.arrivalTimes[std::get<1>(context->forwardEgressJourneys[footpathStopArrivalIndex])] > connectionArrivalTime))
                     {
-                      forwardEgressJourneys[footpathStopArrivalIndex] = std::make_tuple(tripsEnterConnection[tripIndex], i, footpathIndex, tripIndex, footpathTravelTime, 1);
+                      context->forwardEgressJourneys[footpathStopArrivalIndex] = std::make_tuple(context->tripsEnterConnection[tripIndex], i, footpathIndex, tripIndex, footpathTravelTime, 1);
                     }
                   }
                   footpathIndex++;
@@ -110,11 +118,12 @@ namespace TrRouting
           }
         }
       }
-      i++;
     }
     
     if (params.debugDisplay)
-      std::cerr << "-- " << reachableConnectionsCount << " forward connections parsed on " << connectionsCount << std::endl;
+      std::cerr << "-- " << reachableConnectionsCount << " forward connections parsed on " << connectionsCount << " (scanned from " << startConnectionIndex << " to " << endConnectionIndex << ")" << std::endl;
+    counters.scannedConnections   += i - startConnectionIndex;
+    counters.reachableConnections += reachableConnectionsCount;
     
     int egressStopArrivalTime {-1};
     int egressExitConnection  {-1};
@@ -125,13 +134,13 @@ namespace TrRouting
       i = 0;
       for (auto & egressFootpath : egressFootpaths)
       {
-        //std::cerr << stops[egressFootpath.first].name << std::endl;
-        egressExitConnection  = std::get<1>(forwardEgressJourneys[egressFootpath.first]);
+        //std::cerr << network->stops[egressFootpath.first].name << std::endl;
+        egressExitConnection  = std::get<1>(context->forwardEgressJourneys[egressFootpath.first]);
         if (egressExitConnection != -1)
         {
-          egressTravelTime      = stopsEgressTravelTime[egressFootpath.first];
-          egressStopArrivalTime = std::get<connectionIndexes::TIME_ARR>(forwardConnections[egressExitConnection]) + egressTravelTime;
-          //std::cerr << stops[egressFootpath.first].name << ": " << egressTravelTime << " - " << Toolbox::convertSecondsToFormattedTime(egressStopArrivalTime) << std::endl;
+          egressTravelTime      = context->stopsEgressTravelTime[egressFootpath.first];
+          egressStopArrivalTime = network->forwardConnections.arrivalTimes[egressExitConnection] + egressTravelTime;
+          //std::cerr << network->stops[egressFootpath.first].name << ": " << egressTravelTime << " - " << Toolbox::convertSecondsToFormattedTime(egressStopArrivalTime) << std::endl;
           if (egressStopArrivalTime >= 0 && egressStopArrivalTime - departureTimeSeconds <= params.maxTotalTravelTimeSeconds && egressStopArrivalTime < bestArrivalTime && egressStopArrivalTime < MAX_INT)
           {
             bestArrivalTime      = egressStopArrivalTime;
@@ -16,7 +16,7 @@ namespace TrRouting
     std::vector<int> resultingStops;
     if (params.returnAllStopsResult)
     {
-      stopsCount     = stops.size();
+      stopsCount     = network->stops.size();
       json["stops"]  = nlohmann::json::array();
       resultingStops = std::vector<int>(stopsCount);
       std::iota (std::begin(resultingStops), std::end(resultingStops), 0); // generate sequencial indexes of each stops
@@ -33,8 +33,8 @@ namespace TrRouting
       std::deque<std::tuple<int,int,int,int,int,short>> journey;
       std::tuple<int,int,int,int,int,short>             resultingStopJourneyStep;
       std::tuple<int,int,int,int,int,short>             emptyJourneyStep {-1,-1,-1,-1,-1,-1};
-      std::tuple<int,int,int,int,int,short,short,int>   journeyStepEnterConnection; // connection tuple: departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequenceinTrip
-      std::tuple<int,int,int,int,int,short,short,int>   journeyStepExitConnection;
+      int                                               journeyStepEnterConnection; // connection index
+      int                                               journeyStepExitConnection;
       std::vector<unsigned long long>                   routeIds;
       std::vector<unsigned long long>                   routeTypeIds;
       std::vector<unsigned long long>                   agencyIds;
@@ -79,9 +79,9 @@ namespace TrRouting
         transferTime             = -1; egressWalkingTime   = -1; 
         waitingTime              = -1; accessWaitingTime   = -1; 
         
-        //std::cerr << stops[resultingStopIndex].name << " : " << std::get<0>(forwardJourneys[resultingStopIndex]) << std::endl; 
+        //std::cerr << network->stops[resultingStopIndex].name << " : " << std::get<0>(context->forwardJourneys[resultingStopIndex]) << std::endl; 
         // recreate journey:
-        resultingStopJourneyStep = forwardEgressJourneys[resultingStopIndex];
+        resultingStopJourneyStep = context->forwardEgressJourneys[resultingStopIndex];
         
         if (resultingStopJourneyStep == emptyJourneyStep) // ignore stops with no route
         {
@@ -92,19 +92,19 @@ namespace TrRouting
         while ((std::get<0>(resultingStopJourneyStep) != -1 && std::get<1>(resultingStopJourneyStep) != -1))
         {
           journey.push_front(resultingStopJourneyStep);
-          bestAccessStopIndex = std::get<connectionIndexes::STOP_DEP>(forwardConnections[std::get<0>(resultingStopJourneyStep)]);
-          //std::cerr << "sequence: " << std::get<connectionIndexes::SEQUENCE>(forwardConnections[std::get<0>(resultingStopJourneyStep)]) << " sequence2: " << std::get<connectionIndexes::SEQUENCE>(forwardConnections[std::get<1>(journeyStep)]) << " stop:" << stops[bestAccessStopIndex].name << " tenterc:" <<  std::get<0>(journeyStep) << " texitc:" <<  std::get<1>(journeyStep) << " jss:" <<  std::get<5>(journeyStep) << " jtt:" << std::get<4>(journeyStep) << " tectt:" << tripsEnterConnectionTransferTravelTime[std::get<3>(journeyStep)] << std::endl;
-          //std::cerr << stops[bestAccessStopIndex].name << " > " << stops[std::get<connectionIndexes::STOP_ARR>(forwardConnections[std::get<1>(resultingStopJourneyStep)])].name << std::endl;
-          resultingStopJourneyStep = forwardJourneys[bestAccessStopIndex];
+          bestAccessStopIndex = network->forwardConnections.departureStopIndexes[std::get<0>(resultingStopJourneyStep)];
+          //std::cerr << "sequence: " << network->forwardConnections.sequences[std::get<0>(resultingStopJourneyStep)] << " sequence2: " << network->forwardConnections.sequences[std::get<1>(journeyStep)] << " stop:" << network->stops[bestAccessStopIndex].name << " tenterc:" <<  std::get<0>(journeyStep) << " texitc:" <<  std::get<1>(journeyStep) << " jss:" <<  std::get<5>(journeyStep) << " jtt:" << std::get<4>(journeyStep) << " tectt:" << context->tripsEnterConnectionTransferTravelTime[std::get<3>(journeyStep)] << std::endl;
+          //std::cerr << network->stops[bestAccessStopIndex].name << " > " << network->stops[network->forwardConnections.arrivalStopIndexes[std::get<1>(resultingStopJourneyStep)]].name << std::endl;
+          resultingStopJourneyStep = context->forwardJourneys[bestAccessStopIndex];
           i++;
         }
         
         if (!params.returnAllStopsResult)
         {
           json["steps"] = nlohmann::json::array();
-          journey.push_back(std::make_tuple(-1,-1,-1,-1,stopsEgressTravelTime[resultingStopIndex],-1));
+          journey.push_back(std::make_tuple(-1,-1,-1,-1,context->stopsEgressTravelTime[resultingStopIndex],-1));
         }
-        journey.push_front(std::make_tuple(-1,-1,-1,-1,stopsAccessTravelTime[bestAccessStopIndex],-1));
+        journey.push_front(std::make_tuple(-1,-1,-1,-1,context->stopsAccessTravelTime[bestAccessStopIndex],-1));
         
         //std::string stepsJson = "  \"steps\":\n  [\n";
        
@@ -116,17 +116,17 @@ namespace TrRouting
           if (std::get<0>(journeyStep) != -1 && std::get<1>(journeyStep) != -1)
           {
             // journey tuple: final enter connection, final exit connection, final footpath
-            journeyStepEnterConnection = forwardConnections[std::get<0>(journeyStep)];
-            journeyStepExitConnection  = forwardConnections[std::get<1>(journeyStep)];
-            journeyStepStopDeparture   = stops[std::get<connectionIndexes::STOP_DEP>(journeyStepEnterConnection)];
-            journeyStepStopArrival     = stops[std::get<connectionIndexes::STOP_ARR>(journeyStepExitConnection)];
-            journeyStepTrip            = trips[std::get<3>(journeyStep)];
-            journeyStepRoute           = routes[routeIndexesById[journeyStepTrip.routeId]];
+            journeyStepEnterConnection = std::get<0>(journeyStep);
+            journeyStepExitConnection  = std::get<1>(journeyStep);
+            journeyStepStopDeparture   = network->stops.stop(network->forwardConnections.departureStopIndexes[journeyStepEnterConnection]);
+            journeyStepStopArrival     = network->stops.stop(network->forwardConnections.arrivalStopIndexes[journeyStepExitConnection]);
+            journeyStepTrip            = network->trips.trip(std::get<3>(journeyStep));
+            journeyStepRoute           = network->routes.route(network->routeIndexesById.at(journeyStepTrip.routeId));
             transferTime               = std::get<4>(journeyStep);
-            departureTime              = std::get<connectionIndexes::TIME_DEP>(journeyStepEnterConnection);
-            arrivalTime                = std::get<connectionIndexes::TIME_ARR>(journeyStepExitConnection);
-            boardingSequence           = std::get<connectionIndexes::SEQUENCE>(journeyStepEnterConnection);
-            unboardingSequence         = std::get<connectionIndexes::SEQUENCE>(journeyStepExitConnection);
+            departureTime              = network->forwardConnections.departureTimes[journeyStepEnterConnection];
+            arrivalTime                = network->forwardConnections.arrivalTimes[journeyStepExitConnection];
+            boardingSequence           = network->forwardConnections.sequences[journeyStepEnterConnection];
+            unboardingSequence         = network->forwardConnections.sequences[journeyStepExitConnection];
             inVehicleTime              = arrivalTime   - departureTime;
             waitingTime                = departureTime - transferArrivalTime;
             transferArrivalTime        = arrivalTime   + transferTime;
@@ -271,14 +271,14 @@ namespace TrRouting
         
         if (params.returnAllStopsResult)
         {
-          if (std::get<0>(forwardEgressJourneys[resultingStopIndex]) != -1)
+          if (std::get<0>(context->forwardEgressJourneys[resultingStopIndex]) != -1)
           {
-            arrivalTime = std::get<connectionIndexes::TIME_ARR>(forwardConnections[std::get<1>(forwardEgressJourneys[resultingStopIndex])]);
+            arrivalTime = network->forwardConnections.arrivalTimes[std::get<1>(context->forwardEgressJourneys[resultingStopIndex])];
             if (arrivalTime - departureTimeSeconds <= params.maxTotalTravelTimeSeconds)
             {
               reachableStopsCount++;
               stopJson                           = {};
-              stopJson["id"]                     = stops[resultingStopIndex].id;
+              stopJson["id"]                     = network->stops.ids[resultingStopIndex];
               stopJson["arrivalTime"]            = Toolbox::convertSecondsToFormattedTime(arrivalTime);
               stopJson["totalTravelTimeSeconds"] = arrivalTime - departureTimeSeconds;
               stopJson["numberOfTransfers"]      = numberOfTransfers;
@@ -10,9 +10,34 @@ namespace TrRouting
     prepare();
   }
   
+  Calculator::Calculator(std::shared_ptr<const TransitNetwork> theNetwork, std::shared_ptr<QueryContext> theContext, Parameters& theParams) : network(theNetwork), context(theContext), params(theParams)
+  {
+    algorithmCalculationTime = CalculationTime();
+  }
+  
   Calculator::Calculator()
   {
     
   }
+  
+  TransitNetwork::TransitNetwork(Parameters& params)
+  {
+    prepare(params);
+  }
+  
+  TransitNetwork::TransitNetwork()
+  {
+    
+  }
+  
+  QueryContext::QueryContext(const TransitNetwork& network)
+  {
+    prepare(network);
+  }
+  
+  QueryContext::QueryContext()
+  {
+    
+  }
 
 }
@@ -0,0 +1,159 @@
+#include "calculator.hpp"
+
+namespace TrRouting
+{
+
+  // multi-criteria connection scan on arrival time and number of boardings: connections are scanned once by ascending departure time,
+  // keeping for each stop the earliest time it can be reached with each number of boardings (0 being the access) and for each trip
+  // the fewest boardings needed to be on it. The pareto front is read from the egress arrival times by number of boardings:
+  std::vector<std::tuple<int,int,int,int>> Calculator::paretoCalculation()
+  {
+    int  i {0};
+    int  k {0};
+    int  connectionsCount = network->forwardConnections.size();
+    int  reachableConnectionsCount {0};
+    int  tripIndex {-1};
+    int  tripBoardingsCount {MAX_INT};
+    int  stopDepartureIndex {-1};
+    int  stopArrivalIndex {-1};
+    int  connectionDepartureTime {-1};
+    int  connectionArrivalTime {-1};
+    int  footpathsRangeStart {-1};
+    int  footpathsRangeEnd {-1};
+    int  footpathIndex {-1};
+    int  footpathStopArrivalIndex {-1};
+    int  footpathTravelTime {-1};
+    int  footpathArrivalTime {-1};
+    int  egressTravelTime {-1};
+    int  labelIndex {-1};
+
+    int labelsCapacity = QueryContext::maxParetoBoardings;
+    int maxBoardings   = params.maxNumberOfTransfers >= 0 ? std::min(params.maxNumberOfTransfers + 1, labelsCapacity) : labelsCapacity;
+    int labelsPerStop  = labelsCapacity + 1;
+
+    // labels for every stop and number of boardings are only needed by pareto queries, so they are allocated on first use:
+    if (context->stopsTentativeTimeByBoardings.size() != network->stops.size() * labelsPerStop)
+    {
+      context->stopsTentativeTimeByBoardings = StampedVector<int>(network->stops.size() * labelsPerStop, MAX_INT);
+      context->forwardJourneysByBoardings    = StampedVector<std::tuple<int,int,int>>(network->stops.size() * labelsPerStop, std::make_tuple(-1,-1,-1));
+    }
+
+    // best arrival at destination by number of boardings, with the last leg enter and exit connections:
+    std::vector<std::tuple<int,int,int>> egressArrivals(maxBoardings + 1, std::make_tuple(MAX_INT, -1, -1));
+
+    for (auto & accessFootpath : accessFootpaths)
+    {
+      context->stopsTentativeTimeByBoardings[accessFootpath.first * labelsPerStop] = departureTimeSeconds + accessFootpath.second + params.minWaitingTimeSeconds;
+    }
+
+    const int * departureTimes = network->forwardConnections.departureTimes.data();
+    const int * arrivalTimes   = network->forwardConnections.arrivalTimes.data();
+    const int * tripIndexes    = network->forwardConnections.tripIndexes.data();
+    const uint64_t * tripsEnabledWords = context->tripsEnabledWords.data();
+
+    int startConnectionIndex = network->forwardConnections.firstDepartingAtOrAfter((int)std::min((long long)departureTimeSeconds + minAccessTravelTime, (long long)MAX_INT));
+    int endConnectionIndex   = network->forwardConnections.firstDepartingAfter(    (int)std::min((long long)departureTimeSeconds + params.maxTotalTravelTimeSeconds, (long long)MAX_INT));
+
+    // main loop:
+    for(i = startConnectionIndex; i < endConnectionIndex; i++)
+    {
+      tripIndex = tripIndexes[i];
+
+      // enabled trips only here:
+      if (!BitWords::test(tripsEnabledWords, tripIndex))
+      {
+        continue;
+      }
+
+      connectionDepartureTime = departureTimes[i];
+
+      // the destination was already reached with a single boarding, no later connection can improve the front:
+      if (maxBoardings >= 1 && std::get<0>(egressArrivals[1]) <= connectionDepartureTime)
+      {
+        break;
+      }
+
+      // boarding here with the fewest boardings reaching the departure stop in time:
+      if (network->forwardConnections.canBoard(i))
+      {
+        stopDepartureIndex = network->forwardConnections.departureStopIndexes[i];
+        labelIndex         = stopDepartureIndex * labelsPerStop;
+        for (k = 0; k < maxBoardings && k + 1 < context->tripsBoardingsCount[tripIndex]; k++)
+        {
+          if (context->stopsTentativeTimeByBoardings[labelIndex + k] <= connectionDepartureTime)
+          {
+            context->tripsBoardingsCount[tripIndex]  = k + 1;
+            context->tripsEnterConnection[tripIndex] = i;
+            break;
+          }
+        }
+      }
+
+      tripBoardingsCount = context->tripsBoardingsCount[tripIndex];
+      if (tripBoardingsCount == MAX_INT)
+      {
+        continue;
+      }
+      reachableConnectionsCount++;
+
+      if (!network->forwardConnections.canUnboard(i))
+      {
+        continue;
+      }
+      stopArrivalIndex      = network->forwardConnections.arrivalStopIndexes[i];
+      connectionArrivalTime = arrivalTimes[i];
+
+      // walking to destination:
+      egressTravelTime = context->stopsEgressTravelTime[stopArrivalIndex];
+      if (egressTravelTime != -1 && connectionArrivalTime + egressTravelTime < std::get<0>(egressArrivals[tripBoardingsCount]))
+      {
+        egressArrivals[tripBoardingsCount] = std::make_tuple(connectionArrivalTime + egressTravelTime, context->tripsEnterConnection[tripIndex], i);
+      }
+
+      // transferring, only if another boarding is allowed:
+      if (tripBoardingsCount >= maxBoardings)
+      {
+        continue;
+      }
+      footpathsRangeStart = network->footpathsRanges[stopArrivalIndex].first;
+      footpathsRangeEnd   = network->footpathsRanges[stopArrivalIndex].second;
+      if (footpathsRangeStart >= 0 && footpathsRangeEnd >= 0)
+      {
+        for (footpathIndex = footpathsRangeStart; footpathIndex <= footpathsRangeEnd; footpathIndex++)
+        {
+          footpathStopArrivalIndex = std::get<1>(network->footpaths[footpathIndex]);
+          footpathTravelTime       = std::get<2>(network->footpaths[footpathIndex]);
+          if (footpathTravelTime <= params.maxTransferWalkingTravelTimeSeconds)
+          {
+            footpathArrivalTime = connectionArrivalTime + footpathTravelTime + params.minWaitingTimeSeconds;
+            labelIndex          = footpathStopArrivalIndex * labelsPerStop + tripBoardingsCount;
+            if (footpathArrivalTime < context->stopsTentativeTimeByBoardings[labelIndex])
+            {
+              context->stopsTentativeTimeByBoardings[labelIndex] = footpathArrivalTime;
+              context->forwardJourneysByBoardings[labelIndex]    = std::make_tuple(context->tripsEnterConnection[tripIndex], i, footpathIndex);
+            }
+          }
+        }
+      }
+    }
+
+    if (params.debugDisplay)
+      std::cerr << "-- " << reachableConnectionsCount << " pareto connections parsed on " << connectionsCount << " (scanned from " << startConnectionIndex << " to " << endConnectionIndex << ")" << std::endl;
+    counters.scannedConnections   += i - startConnectionIndex;
+    counters.reachableConnections += reachableConnectionsCount;
+
+    // keep a number of boardings only if it arrives earlier than with fewer boardings:
+    std::vector<std::tuple<int,int,int,int>> paretoFront;
+    int bestArrivalTime {MAX_INT};
+    for (k = 1; k <= maxBoardings; k++)
+    {
+      if (std::get<0>(egressArrivals[k]) < bestArrivalTime && std::get<0>(egressArrivals[k]) - departureTimeSeconds <= params.maxTotalTravelTimeSeconds)
+      {
+        bestArrivalTime = std::get<0>(egressArrivals[k]);
+        paretoFront.push_back(std::make_tuple(k, bestArrivalTime, std::get<1>(egressArrivals[k]), std::get<2>(egressArrivals[k])));
+      }
+    }
+    return paretoFront;
+  }
+
+}
@@ -0,0 +1,90 @@
+#include "calculator.hpp"
+#include "json.hpp"
+
+namespace TrRouting
+{
+
+  RoutingResult Calculator::paretoJourneys(const std::vector<std::tuple<int,int,int,int>>& paretoFront)
+  {
+    RoutingResult  result;
+    nlohmann::json json;
+    nlohmann::json journeyJson;
+    int            labelsPerStop = QueryContext::maxParetoBoardings + 1;
+
+    json["origin"]               = { params.origin.longitude,      params.origin.latitude };
+    json["destination"]          = { params.destination.longitude, params.destination.latitude };
+    json["departureTime"]        = Toolbox::convertSecondsToFormattedTime(departureTimeSeconds);
+    json["departureTimeSeconds"] = departureTimeSeconds;
+    json["numberOfJourneys"]     = paretoFront.size();
+    json["journeys"]             = nlohmann::json::array();
+
+    for (auto & journey : paretoFront)
+    {
+      int boardingsCount   = std::get<0>(journey);
+      int arrivalTime      = std::get<1>(journey);
+      int enterConnection  = std::get<2>(journey);
+      int exitConnection   = std::get<3>(journey);
+      int egressTravelTime = context->stopsEgressTravelTime[network->forwardConnections.arrivalStopIndexes[exitConnection]];
+      std::vector<std::pair<int,int>> legsConnections; // enter and exit connections, last leg first
+
+      // go back from the last leg, each leg being boarded from the label with one boarding less at its departure stop:
+      for (int k = boardingsCount; k >= 1 && enterConnection != -1; k--)
+      {
+        legsConnections.push_back(std::make_pair(enterConnection, exitConnection));
+        if (k > 1)
+        {
+          std::tie(enterConnection, exitConnection, std::ignore) = context->forwardJourneysByBoardings[network->forwardConnections.departureStopIndexes[enterConnection] * labelsPerStop + k - 1];
+        }
+      }
+      std::reverse(legsConnections.begin(), legsConnections.end());
+
+      int accessStopIndex           = network->forwardConnections.departureStopIndexes[legsConnections.front().first];
+      int accessTravelTime          = context->stopsAccessTravelTime[accessStopIndex];
+      int latestOriginDepartureTime = network->forwardConnections.departureTimes[legsConnections.front().first] - accessTravelTime - params.minWaitingTimeSeconds;
+      std::vector<unsigned long long> routeIds;
+
+      journeyJson         = {};
+      journeyJson["legs"] = nlohmann::json::array();
+      for (auto & legConnections : legsConnections)
+      {
+        journeyJson["legs"].push_back(legJson(legConnections.first, legConnections.second, routeIds));
+      }
+
+      journeyJson["arrivalTime"]                                    = Toolbox::convertSecondsToFormattedTime(arrivalTime);
+      journeyJson["arrivalTimeSeconds"]                             = arrivalTime;
+      journeyJson["totalTravelTimeMinutes"]                         = Toolbox::convertSecondsToMinutes(arrivalTime - departureTimeSeconds);
+      journeyJson["totalTravelTimeSeconds"]                         = arrivalTime - departureTimeSeconds;
+      journeyJson["departureTimeToMinimizeFirstWaitingTime"]        = Toolbox::convertSecondsToFormattedTime(latestOriginDepartureTime);
+      journeyJson["departureTimeToMinimizeFirstWaitingTimeSeconds"] = latestOriginDepartureTime;
+      journeyJson["numberOfBoardings"]                              = legsConnections.size();
+      journeyJson["numberOfTransfers"]                              = legsConnections.size() - 1;
+      journeyJson["accessTravelTimeSeconds"]                        = accessTravelTime;
+      journeyJson["egressTravelTimeSeconds"]                        = egressTravelTime;
+      journeyJson["routeIds"]                                       = routeIds;
+      json["journeys"].push_back(journeyJson);
+    }
+
+    json["minimumWaitingTimeBeforeEachBoardingMinutes"] = Toolbox::convertSecondsToMinutes(params.minWaitingTimeSeconds);
+    json["minimumWaitingTimeBeforeEachBoardingSeconds"] = params.minWaitingTimeSeconds;
+
+    result.departureTimeSeconds = departureTimeSeconds;
+    if (paretoFront.size() > 0)
+    {
+      json["status"]            = "success";
+      result.status             = "success";
+      result.arrivalTimeSeconds = std::get<1>(paretoFront.back()); // the journey with the most boardings arrives first
+      result.travelTimeSeconds  = result.arrivalTimeSeconds - departureTimeSeconds;
+    }
+    else
+    {
+      json["status"]            = "no_routing_found";
+      result.status             = "no_routing_found";
+      result.arrivalTimeSeconds = -1;
+      result.travelTimeSeconds  = -1;
+    }
+
+    result.json = json.dump(2);
+    return result;
+  }
+
+}
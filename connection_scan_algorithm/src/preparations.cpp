@@ -5,16 +5,43 @@ namespace TrRouting
     
   void Calculator::prepare()
   {
+    network = std::make_shared<const TransitNetwork>(params);
+    context = std::make_shared<QueryContext>(*network);
+  }
+  
+  void TransitNetwork::prepare(Parameters& params)
+  {
+    
+    // fetchers return stops, routes and trips as vectors and maps, converted to compact tables once everything is fetched:
+    std::vector<Stop>                 stopsVector;
+    std::map<unsigned long long, int> stopIndexes;
+    std::vector<Route>                routesVector;
+    std::map<unsigned long long, int> routeIndexes;
+    std::vector<Trip>                 tripsVector;
+    std::map<unsigned long long, int> tripIndexes;
+    std::vector<Service>              servicesVector;
+    std::map<unsigned long long, int> serviceIndexes;
+    auto setTables = [&]() {
+      stops            = StopTable::fromStops(stopsVector);
+      stopIndexesById  = IdIndexMap(stopIndexes);
+      routes           = RouteTable::fromRoutes(routesVector);
+      routeIndexesById = IdIndexMap(routeIndexes);
+      trips            = TripTable::fromTrips(tripsVector);
+      tripIndexesById  = IdIndexMap(tripIndexes);
+      calendar         = ServiceCalendar::fromServices(servicesVector, trips);
+    };
     
     if (params.debugDisplay)
       std::cerr << "preparing stops, routes, trips, connections and footpaths..." << std::endl;
     if (params.dataFetcherShortname == "database")
     {
-      std::tie(stops, stopIndexesById)                 = params.databaseFetcher->getStops(params.applicationShortname);
-      std::tie(routes, routeIndexesById)               = params.databaseFetcher->getRoutes(params.applicationShortname);
-      std::tie(trips, tripIndexesById)                 = params.databaseFetcher->getTrips(params.applicationShortname);
-      std::tie(forwardConnections, reverseConnections) = params.databaseFetcher->getConnections(params.applicationShortname, stopIndexesById, tripIndexesById);
-      std::tie(footpaths, footpathsRanges)             = params.databaseFetcher->getFootpaths(params.applicationShortname, stopIndexesById);
+      std::tie(stopsVector, stopIndexes)               = params.databaseFetcher->getStops(params.applicationShortname);
+      std::tie(routesVector, routeIndexes)             = params.databaseFetcher->getRoutes(params.applicationShortname);
+      std::tie(tripsVector, tripIndexes)               = params.databaseFetcher->getTrips(params.applicationShortname);
+      std::tie(servicesVector, serviceIndexes)         = params.databaseFetcher->getServices(params.applicationShortname);
+      std::tie(forwardConnections, reverseConnections) = params.databaseFetcher->getConnections(params.applicationShortname, stopIndexes, tripIndexes);
+      std::tie(footpaths, footpathsRanges)             = params.databaseFetcher->getFootpaths(params.applicationShortname, stopIndexes);
+      setTables();
       std::tie(odTrips, odTripIndexesById)             = params.cacheFetcher->getOdTrips(params.applicationShortname, stops, params);
       if (params.updateOdTrips == 1) // only update od trips if set as parameter (1) when launching app, because this takes a long time. Call only if stops and/or od trips were modified.
       {
@@ -23,30 +50,46 @@ namespace TrRouting
     }
     else if (params.dataFetcherShortname == "cache")
     {
-      std::tie(stops, stopIndexesById)                   = params.cacheFetcher->getStops(params.applicationShortname);
-      if (stops.size() == 0)
-      {
-        std::tie(stops, stopIndexesById)                 = params.databaseFetcher->getStops(params.applicationShortname);
-      }
-      std::tie(routes, routeIndexesById)                 = params.cacheFetcher->getRoutes(params.applicationShortname);
-      if (routes.size() == 0)
-      {
-        std::tie(routes, routeIndexesById)               = params.databaseFetcher->getRoutes(params.applicationShortname);
-      }
-      std::tie(trips, tripIndexesById)                   = params.cacheFetcher->getTrips(params.applicationShortname);
-      if (trips.size() == 0)
-      {
-        std::tie(trips, tripIndexesById)                 = params.databaseFetcher->getTrips(params.applicationShortname);
-      }
-      std::tie(forwardConnections, reverseConnections)   = params.cacheFetcher->getConnections(params.applicationShortname, stopIndexesById, tripIndexesById);
-      if (forwardConnections.size() == 0)
+      // use the flat (memory-mapped) network cache file when it is newer than the binary cache files, build it otherwise:
+      std::string              flatCacheFilePath = FlatNetworkCache::filePath(params.applicationShortname);
+      std::vector<std::string> cacheFilePaths;
+      for (std::string cacheFileName : {"stops", "stop_indexes", "routes", "route_indexes", "trips", "trip_indexes", "services", "service_indexes", "connections_forward", "connections_reverse", "footpaths", "footpaths_ranges"})
       {
-        std::tie(forwardConnections, reverseConnections) = params.databaseFetcher->getConnections(params.applicationShortname, stopIndexesById, tripIndexesById);
+        cacheFilePaths.push_back(params.applicationShortname + "_" + cacheFileName + ".cache");
       }
-      std::tie(footpaths, footpathsRanges)               = params.cacheFetcher->getFootpaths(params.applicationShortname, stopIndexesById);
-      if (footpaths.size() == 0)
+      if (!FlatNetworkCache::isUpToDate(flatCacheFilePath, cacheFilePaths) || !FlatNetworkCache::load(*this, flatCacheFilePath))
       {
-        std::tie(footpaths, footpathsRanges)             = params.databaseFetcher->getFootpaths(params.applicationShortname, stopIndexesById);
+        std::tie(stopsVector, stopIndexes)                 = params.cacheFetcher->getStops(params.applicationShortname);
+        if (stopsVector.size() == 0)
+        {
+          std::tie(stopsVector, stopIndexes)               = params.databaseFetcher->getStops(params.applicationShortname);
+        }
+        std::tie(routesVector, routeIndexes)               = params.cacheFetcher->getRoutes(params.applicationShortname);
+        if (routesVector.size() == 0)
+        {
+          std::tie(routesVector, routeIndexes)             = params.databaseFetcher->getRoutes(params.applicationShortname);
+        }
+        std::tie(tripsVector, tripIndexes)                 = params.cacheFetcher->getTrips(params.applicationShortname);
+        if (tripsVector.size() == 0)
+        {
+          std::tie(tripsVector, tripIndexes)               = params.databaseFetcher->getTrips(params.applicationShortname);
+        }
+        std::tie(servicesVector, serviceIndexes)           = params.cacheFetcher->getServices(params.applicationShortname); // optional: without calendars, trips are not filtered by date
+        std::tie(forwardConnections, reverseConnections)   = params.cacheFetcher->getConnections(params.applicationShortname, stopIndexes, tripIndexes);
+        if (forwardConnections.size() == 0)
+        {
+          std::tie(forwardConnections, reverseConnections) = params.databaseFetcher->getConnections(params.applicationShortname, stopIndexes, tripIndexes);
+        }
+        std::tie(footpaths, footpathsRanges)               = params.cacheFetcher->getFootpaths(params.applicationShortname, stopIndexes);
+        if (footpaths.size() == 0)
+        {
+          std::tie(footpaths, footpathsRanges)             = params.databaseFetcher->getFootpaths(params.applicationShortname, stopIndexes);
+        }
+        setTables();
+        if (forwardConnections.size() > 0)
+        {
+          FlatNetworkCache::save(*this, flatCacheFilePath);
+        }
       }
       std::tie(odTrips, odTripIndexesById)               = params.cacheFetcher->getOdTrips(params.applicationShortname, stops, params);
       if (odTrips.size() == 0)
@@ -56,39 +99,59 @@ namespace TrRouting
     }
     else if (params.dataFetcherShortname == "gtfs")
     {
-      std::tie(stops, stopIndexesById)                 = params.gtfsFetcher->getStops(params.applicationShortname);
-      std::tie(routes, routeIndexesById)               = params.gtfsFetcher->getRoutes(params.applicationShortname);
-      std::tie(trips, tripIndexesById)                 = params.gtfsFetcher->getTrips(params.applicationShortname);
-      std::tie(forwardConnections, reverseConnections) = params.gtfsFetcher->getConnections(params.applicationShortname, stopIndexesById, tripIndexesById);
-      std::tie(footpaths, footpathsRanges)             = params.gtfsFetcher->getFootpaths(params.applicationShortname, stopIndexesById);
+      std::tie(stopsVector, stopIndexes)               = params.gtfsFetcher->getStops(params.applicationShortname);
+      std::tie(routesVector, routeIndexes)             = params.gtfsFetcher->getRoutes(params.applicationShortname);
+      std::tie(tripsVector, tripIndexes)               = params.gtfsFetcher->getTrips(params.applicationShortname);
+      std::tie(servicesVector, serviceIndexes)         = params.gtfsFetcher->getServices(params.applicationShortname);
+      std::tie(forwardConnections, reverseConnections) = params.gtfsFetcher->getConnections(params.applicationShortname, stopIndexes, tripIndexes);
+      std::tie(footpaths, footpathsRanges)             = params.gtfsFetcher->getFootpaths(params.applicationShortname, stopIndexes);
+      setTables();
     }
     else if (params.dataFetcherShortname == "csv")
     {
-      std::tie(stops, stopIndexesById)                 = params.csvFetcher->getStops(params.applicationShortname);
-      std::tie(routes, routeIndexesById)               = params.csvFetcher->getRoutes(params.applicationShortname);
-      std::tie(trips, tripIndexesById)                 = params.csvFetcher->getTrips(params.applicationShortname);
-      std::tie(forwardConnections, reverseConnections) = params.csvFetcher->getConnections(params.applicationShortname, stopIndexesById, tripIndexesById);
-      std::tie(footpaths, footpathsRanges)             = params.csvFetcher->getFootpaths(params.applicationShortname, stopIndexesById);
+      std::tie(stopsVector, stopIndexes)               = params.csvFetcher->getStops(params.applicationShortname);
+      std::tie(routesVector, routeIndexes)             = params.csvFetcher->getRoutes(params.applicationShortname);
+      std::tie(tripsVector, tripIndexes)               = params.csvFetcher->getTrips(params.applicationShortname);
+      std::tie(servicesVector, serviceIndexes)         = params.csvFetcher->getServices(params.applicationShortname);
+      std::tie(forwardConnections, reverseConnections) = params.csvFetcher->getConnections(params.applicationShortname, stopIndexes, tripIndexes);
+      std::tie(footpaths, footpathsRanges)             = params.csvFetcher->getFootpaths(params.applicationShortname, stopIndexes);
+      setTables();
     }
     
-    std::cout << "preparing stops tentative times, trips enter connections and journeys..." << std::endl;
+    stopsSpatialIndex = StopsSpatialIndex(stops);
+    routesTrips       = TripsBitsets::fromTrips(trips.routeIds,     trips.routeIdIndexes);
+    routeTypesTrips   = TripsBitsets::fromTrips(trips.routeTypeIds, trips.routeTypeIdIndexes);
+    agenciesTrips     = TripsBitsets::fromTrips(trips.agencyIds,    trips.agencyIdIndexes);
+    servicesTrips     = TripsBitsets::fromTrips(trips.serviceIds,   trips.serviceIdIndexes);
+  }
+  
+  void QueryContext::prepare(const TransitNetwork& network)
+  {
+    
+    const StopTable & stops = network.stops;
+    const TripTable & trips = network.trips;
     
-    stopsTentativeTime                     = std::vector<int>(stops.size());
-    stopsReverseTentativeTime              = std::vector<int>(stops.size()); //std::vector<std::deque<std::pair<int,int>>>(stops.size());
-    //stopsD                                 = std::vector<int>(stops.size());
-    stopsAccessTravelTime                  = std::vector<int>(stops.size());
-    stopsEgressTravelTime                  = std::vector<int>(stops.size());
-    tripsEnterConnection                   = std::vector<int>(trips.size());
-    tripsExitConnection                    = std::vector<int>(trips.size());
-    //tripsReverseTime                       = std::vector<int>(trips.size());
-    tripsEnterConnectionTransferTravelTime = std::vector<int>(trips.size());
-    tripsExitConnectionTransferTravelTime  = std::vector<int>(trips.size());
-    tripsEnabled                           = std::vector<int>(trips.size());
-    tripsUsable                            = std::vector<int>(trips.size());
-    forwardJourneys                        = std::vector<std::tuple<int,int,int,int,int,short>>(stops.size());
-    forwardEgressJourneys                  = std::vector<std::tuple<int,int,int,int,int,short>>(stops.size());
-    reverseJourneys                        = std::vector<std::tuple<int,int,int,int,int,short>>(stops.size());
-    reverseAccessJourneys                  = std::vector<std::tuple<int,int,int,int,int,short>>(stops.size());
+    stopsTentativeTime                     = StampedVector<int>(stops.size());
+    stopsReverseTentativeTime              = StampedVector<int>(stops.size()); //std::vector<std::deque<std::pair<int,int>>>(stops.size());
+    //stopsD                                 = StampedVector<int>(stops.size());
+    stopsAccessTravelTime                  = StampedVector<int>(stops.size());
+    stopsEgressTravelTime                  = StampedVector<int>(stops.size());
+    tripsEnterConnection                   = StampedVector<int>(trips.size());
+    tripsExitConnection                    = StampedVector<int>(trips.size());
+    //tripsReverseTime                       = StampedVector<int>(trips.size());
+    tripsEnterConnectionTransferTravelTime = StampedVector<int>(trips.size());
+    tripsExitConnectionTransferTravelTime  = StampedVector<int>(trips.size());
+    tripsEnabledWords                      = std::vector<uint64_t>(BitWords::wordsCount(trips.size()));
+    tripsFilterWords                       = std::vector<uint64_t>(BitWords::wordsCount(trips.size()));
+    tripsUsable                            = StampedVector<int>(trips.size());
+    forwardJourneys                        = StampedVector<std::tuple<int,int,int,int,int,short>>(stops.size());
+    forwardEgressJourneys                  = StampedVector<std::tuple<int,int,int,int,int,short>>(stops.size());
+    reverseJourneys                        = StampedVector<std::tuple<int,int,int,int,int,short>>(stops.size());
+    reverseAccessJourneys                  = StampedVector<std::tuple<int,int,int,int,int,short>>(stops.size());
+    tripsProfile                           = StampedVector<std::tuple<int,int,int>>(trips.size());
+    stopsProfiles                          = std::vector<std::vector<std::tuple<int,int,int,int,int>>>(stops.size());
+    stopsProfilesCounts                    = StampedVector<int>(stops.size());
+    tripsBoardingsCount                    = StampedVector<int>(trips.size());
     
   }
   
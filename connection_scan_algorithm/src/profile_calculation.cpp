@@ -0,0 +1,181 @@
+#include "calculator.hpp"
+
+namespace TrRouting
+{
+
+  const std::tuple<int,int,int,int,int> * Calculator::stopProfileEntry(int stopIndex, int readyTime)
+  {
+    // entries are sorted by descending departure time, the last one departing at or after ready time has the earliest arrival:
+    const std::vector<std::tuple<int,int,int,int,int>> & stopProfile = context->stopsProfiles[stopIndex];
+    auto entriesEnd = stopProfile.begin() + context->stopsProfilesCounts[stopIndex];
+    auto firstTooEarly = std::partition_point(stopProfile.begin(), entriesEnd, [readyTime](const std::tuple<int,int,int,int,int>& entry) {
+      return std::get<0>(entry) >= readyTime;
+    });
+    return firstTooEarly == stopProfile.begin() ? NULL : &(*(firstTooEarly - 1));
+  }
+
+  // profile connection scan: connections are scanned once by descending departure time, keeping for each stop the pareto set
+  // of (departure time, arrival time at destination) and for each trip the arrival time at destination when on the trip:
+  std::vector<std::tuple<int,int,int,int,int,int>> Calculator::profileCalculation()
+  {
+    int  i {0};
+    int  connectionsCount = network->forwardConnections.size();
+    int  reachableConnectionsCount {0};
+    int  tripIndex {-1};
+    int  stopDepartureIndex {-1};
+    int  stopArrivalIndex {-1};
+    int  connectionDepartureTime {-1};
+    int  connectionArrivalTime {-1};
+    int  footpathsRangeStart {-1};
+    int  footpathsRangeEnd {-1};
+    int  footpathIndex {-1};
+    int  footpathTravelTime {-1};
+    int  egressTravelTime {-1};
+    int  accessTravelTime {-1};
+    int  arrivalTime {MAX_INT};
+    int  exitConnection {-1};
+    int  exitFootpath {-1};
+    int  originDepartureTime {-1};
+    const std::tuple<int,int,int,int,int> * transferEntry;
+    std::vector<std::tuple<int,int,int,int,int,int>> originProfile;
+
+    int windowStartTime = departureTimeSeconds;
+    int windowEndTime   = (int)std::min((long long)departureTimeSeconds + params.departureWindowSeconds, (long long)MAX_INT);
+
+    // journeys leaving before the end of the window and arriving after the earliest arrival when leaving at the end of the window
+    // are dominated, so a forward calculation from the end of the window bounds the scan:
+    departureTimeSeconds = windowEndTime;
+    for (auto & accessFootpath : accessFootpaths)
+    {
+      context->stopsTentativeTime[accessFootpath.first] = departureTimeSeconds + accessFootpath.second + params.minWaitingTimeSeconds;
+    }
+    int latestUsefulArrivalTime = std::get<0>(forwardCalculation());
+    departureTimeSeconds        = windowStartTime;
+
+    int startConnectionIndex = network->forwardConnections.firstDepartingAtOrAfter((int)std::min((long long)windowStartTime + minAccessTravelTime, (long long)MAX_INT));
+    int endConnectionIndex   = network->forwardConnections.firstDepartingAfter(std::min(latestUsefulArrivalTime, (int)std::min((long long)windowEndTime + params.maxTotalTravelTimeSeconds, (long long)MAX_INT)));
+
+    const int * departureTimes = network->forwardConnections.departureTimes.data();
+    const int * arrivalTimes   = network->forwardConnections.arrivalTimes.data();
+    const int * tripIndexes    = network->forwardConnections.tripIndexes.data();
+    const uint64_t * tripsEnabledWords = context->tripsEnabledWords.data();
+
+    // main loop, latest departures first:
+    for(i = endConnectionIndex - 1; i >= startConnectionIndex; i--)
+    {
+      tripIndex = tripIndexes[i];
+
+      // enabled trips only here:
+      if (!BitWords::test(tripsEnabledWords, tripIndex))
+      {
+        continue;
+      }
+
+      // staying on the trip:
+      std::tie(arrivalTime, exitConnection, exitFootpath) = context->tripsProfile[tripIndex];
+
+      if (network->forwardConnections.canUnboard(i))
+      {
+        stopArrivalIndex      = network->forwardConnections.arrivalStopIndexes[i];
+        connectionArrivalTime = arrivalTimes[i];
+
+        // walking to destination:
+        egressTravelTime = context->stopsEgressTravelTime[stopArrivalIndex];
+        if (egressTravelTime != -1 && connectionArrivalTime + egressTravelTime < arrivalTime)
+        {
+          arrivalTime    = connectionArrivalTime + egressTravelTime;
+          exitConnection = i;
+          exitFootpath   = -1;
+        }
+
+        // transferring to another trip at the arrival stop or at stops within walking distance:
+        footpathsRangeStart = network->footpathsRanges[stopArrivalIndex].first;
+        footpathsRangeEnd   = network->footpathsRanges[stopArrivalIndex].second;
+        if (footpathsRangeStart >= 0 && footpathsRangeEnd >= 0)
+        {
+          for (footpathIndex = footpathsRangeStart; footpathIndex <= footpathsRangeEnd; footpathIndex++)
+          {
+            footpathTravelTime = std::get<2>(network->footpaths[footpathIndex]);
+            if (footpathTravelTime <= params.maxTransferWalkingTravelTimeSeconds)
+            {
+              transferEntry = stopProfileEntry(std::get<1>(network->footpaths[footpathIndex]), connectionArrivalTime + footpathTravelTime + params.minWaitingTimeSeconds);
+              if (transferEntry != NULL && std::get<1>(*transferEntry) < arrivalTime)
+              {
+                arrivalTime    = std::get<1>(*transferEntry);
+                exitConnection = i;
+                exitFootpath   = footpathIndex;
+              }
+            }
+          }
+        }
+      }
+
+      if (arrivalTime == MAX_INT)
+      {
+        continue;
+      }
+      context->tripsProfile[tripIndex] = std::make_tuple(arrivalTime, exitConnection, exitFootpath);
+      reachableConnectionsCount++;
+
+      // boarding here, keep only if not dominated by a later departure from the same stop:
+      if (network->forwardConnections.canBoard(i))
+      {
+        stopDepartureIndex      = network->forwardConnections.departureStopIndexes[i];
+        connectionDepartureTime = departureTimes[i];
+        std::vector<std::tuple<int,int,int,int,int>> & stopProfile = context->stopsProfiles[stopDepartureIndex];
+        int & stopProfileCount = context->stopsProfilesCounts[stopDepartureIndex];
+        if (stopProfileCount > 0 && arrivalTime >= std::get<1>(stopProfile[stopProfileCount - 1]))
+        {
+          continue;
+        }
+        if (stopProfileCount > 0 && std::get<0>(stopProfile[stopProfileCount - 1]) == connectionDepartureTime)
+        {
+          stopProfileCount--; // same departure time, earlier arrival: replace
+        }
+        if (stopProfileCount < (int)stopProfile.size())
+        {
+          stopProfile[stopProfileCount] = std::make_tuple(connectionDepartureTime, arrivalTime, i, exitConnection, exitFootpath);
+        }
+        else
+        {
+          stopProfile.push_back(std::make_tuple(connectionDepartureTime, arrivalTime, i, exitConnection, exitFootpath));
+        }
+        stopProfileCount++;
+
+        // latest departure from origin to board here:
+        accessTravelTime = context->stopsAccessTravelTime[stopDepartureIndex];
+        if (accessTravelTime != -1)
+        {
+          originDepartureTime = connectionDepartureTime - accessTravelTime - params.minWaitingTimeSeconds;
+          if (originDepartureTime >= windowStartTime && originDepartureTime <= windowEndTime && arrivalTime - originDepartureTime <= params.maxTotalTravelTimeSeconds)
+          {
+            originProfile.push_back(std::make_tuple(originDepartureTime, arrivalTime, stopDepartureIndex, i, exitConnection, exitFootpath));
+          }
+        }
+      }
+    }
+
+    if (params.debugDisplay)
+      std::cerr << "-- " << reachableConnectionsCount << " profile connections parsed on " << connectionsCount << " (scanned from " << endConnectionIndex << " down to " << startConnectionIndex << ")" << std::endl;
+    counters.scannedConnections   += endConnectionIndex - 1 - i;
+    counters.reachableConnections += reachableConnectionsCount;
+
+    // access stops have different access travel times, so keep only the pareto-optimal origin departures:
+    std::sort(originProfile.begin(), originProfile.end(), [](const std::tuple<int,int,int,int,int,int>& journeyA, const std::tuple<int,int,int,int,int,int>& journeyB) {
+      return std::get<0>(journeyA) != std::get<0>(journeyB) ? std::get<0>(journeyA) > std::get<0>(journeyB) : std::get<1>(journeyA) < std::get<1>(journeyB);
+    });
+    std::vector<std::tuple<int,int,int,int,int,int>> profile;
+    int bestArrivalTime {MAX_INT};
+    for (auto & journey : originProfile)
+    {
+      if (std::get<1>(journey) < bestArrivalTime)
+      {
+        bestArrivalTime = std::get<1>(journey);
+        profile.push_back(journey);
+      }
+    }
+    std::reverse(profile.begin(), profile.end());
+    return profile;
+  }
+
+}
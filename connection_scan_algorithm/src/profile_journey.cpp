@@ -0,0 +1,117 @@
+#include "calculator.hpp"
+#include "json.hpp"
+
+namespace TrRouting
+{
+
+  nlohmann::json Calculator::legJson(int enterConnection, int exitConnection, std::vector<unsigned long long>& routeIds)
+  {
+    nlohmann::json json;
+    int tripIndex  = network->forwardConnections.tripIndexes[enterConnection];
+    int routeIndex = network->routeIndexesById.at(network->trips.routeId(tripIndex));
+    routeIds.push_back(network->routes.ids[routeIndex]);
+    json["tripId"]               = network->trips.ids[tripIndex];
+    json["routeId"]              = network->routes.ids[routeIndex];
+    json["routeShortname"]       = network->routes.shortname(routeIndex);
+    json["boardingStopId"]       = network->stops.ids[network->forwardConnections.departureStopIndexes[enterConnection]];
+    json["unboardingStopId"]     = network->stops.ids[network->forwardConnections.arrivalStopIndexes[exitConnection]];
+    json["departureTime"]        = Toolbox::convertSecondsToFormattedTime(network->forwardConnections.departureTimes[enterConnection]);
+    json["departureTimeSeconds"] = network->forwardConnections.departureTimes[enterConnection];
+    json["arrivalTime"]          = Toolbox::convertSecondsToFormattedTime(network->forwardConnections.arrivalTimes[exitConnection]);
+    json["arrivalTimeSeconds"]   = network->forwardConnections.arrivalTimes[exitConnection];
+    return json;
+  }
+
+  RoutingResult Calculator::profileJourneys(const std::vector<std::tuple<int,int,int,int,int,int>>& profile)
+  {
+    RoutingResult  result;
+    nlohmann::json json;
+    nlohmann::json journeyJson;
+    int            windowEndTime = (int)std::min((long long)departureTimeSeconds + params.departureWindowSeconds, (long long)MAX_INT);
+
+    json["origin"]                          = { params.origin.longitude,      params.origin.latitude };
+    json["destination"]                     = { params.destination.longitude, params.destination.latitude };
+    json["departureWindowStartTime"]        = Toolbox::convertSecondsToFormattedTime(departureTimeSeconds);
+    json["departureWindowEndTime"]          = Toolbox::convertSecondsToFormattedTime(windowEndTime);
+    json["departureWindowStartTimeSeconds"] = departureTimeSeconds;
+    json["departureWindowEndTimeSeconds"]   = windowEndTime;
+    json["numberOfJourneys"]                = profile.size();
+    json["journeys"]                        = nlohmann::json::array();
+
+    int stopsCount = network->stops.size();
+    for (auto & journey : profile)
+    {
+      int originDepartureTime = std::get<0>(journey);
+      int arrivalTime         = std::get<1>(journey);
+      int accessTravelTime    = context->stopsAccessTravelTime[std::get<2>(journey)];
+      int enterConnection     = std::get<3>(journey);
+      int exitConnection      = std::get<4>(journey);
+      int exitFootpath        = std::get<5>(journey);
+      int egressTravelTime    = -1;
+      int legsCount           = 0;
+      std::vector<unsigned long long> routeIds;
+
+      journeyJson         = {};
+      journeyJson["legs"] = nlohmann::json::array();
+
+      // follow the trips and transfers chosen during the scan until egress:
+      while (enterConnection != -1 && legsCount <= stopsCount)
+      {
+        journeyJson["legs"].push_back(legJson(enterConnection, exitConnection, routeIds));
+        legsCount++;
+
+        if (exitFootpath == -1) // egress
+        {
+          egressTravelTime = context->stopsEgressTravelTime[network->forwardConnections.arrivalStopIndexes[exitConnection]];
+          enterConnection  = -1;
+        }
+        else
+        {
+          const std::tuple<int,int,int,int,int> * transferEntry = stopProfileEntry(std::get<1>(network->footpaths[exitFootpath]), network->forwardConnections.arrivalTimes[exitConnection] + std::get<2>(network->footpaths[exitFootpath]) + params.minWaitingTimeSeconds);
+          if (transferEntry == NULL) // cannot happen, the entry was there when scanning
+          {
+            break;
+          }
+          std::tie(std::ignore, std::ignore, enterConnection, exitConnection, exitFootpath) = *transferEntry;
+        }
+      }
+
+      journeyJson["departureTime"]           = Toolbox::convertSecondsToFormattedTime(originDepartureTime);
+      journeyJson["departureTimeSeconds"]    = originDepartureTime;
+      journeyJson["arrivalTime"]             = Toolbox::convertSecondsToFormattedTime(arrivalTime);
+      journeyJson["arrivalTimeSeconds"]      = arrivalTime;
+      journeyJson["totalTravelTimeMinutes"]  = Toolbox::convertSecondsToMinutes(arrivalTime - originDepartureTime);
+      journeyJson["totalTravelTimeSeconds"]  = arrivalTime - originDepartureTime;
+      journeyJson["numberOfBoardings"]       = legsCount;
+      journeyJson["numberOfTransfers"]       = legsCount - 1;
+      journeyJson["accessTravelTimeSeconds"] = accessTravelTime;
+      journeyJson["egressTravelTimeSeconds"] = egressTravelTime;
+      journeyJson["routeIds"]                = routeIds;
+      json["journeys"].push_back(journeyJson);
+    }
+
+    json["minimumWaitingTimeBeforeEachBoardingMinutes"] = Toolbox::convertSecondsToMinutes(params.minWaitingTimeSeconds);
+    json["minimumWaitingTimeBeforeEachBoardingSeconds"] = params.minWaitingTimeSeconds;
+
+    if (profile.size() > 0)
+    {
+      json["status"]              = "success";
+      result.status               = "success";
+      result.departureTimeSeconds = std::get<0>(profile[0]);
+      result.arrivalTimeSeconds   = std::get<1>(profile[0]);
+      result.travelTimeSeconds    = std::get<1>(profile[0]) - std::get<0>(profile[0]);
+    }
+    else
+    {
+      json["status"]              = "no_routing_found";
+      result.status               = "no_routing_found";
+      result.departureTimeSeconds = departureTimeSeconds;
+      result.arrivalTimeSeconds   = -1;
+      result.travelTimeSeconds    = -1;
+    }
+
+    result.json = json.dump(2);
+    return result;
+  }
+
+}
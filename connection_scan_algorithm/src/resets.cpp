@@ -7,29 +7,40 @@ namespace TrRouting
   {
     
     calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    std::fill(phasesDurationsMicroseconds, phasesDurationsMicroseconds + PHASES_COUNT, -1);
+    counters = CalculationCounters();
+    std::fill(&phasesHardwareCounters[0][0], &phasesHardwareCounters[0][0] + PHASES_COUNT * PerfCounters::EVENTS_COUNT, -1);
+    if (params.profileHardwareCounters)
+    {
+      PerfCounters::ofThisThread().read(phaseStartHardwareCounters);
+    }
     
-    std::fill(stopsTentativeTime.begin(),        stopsTentativeTime.end(),   MAX_INT);
-    std::fill(stopsReverseTentativeTime.begin(), stopsReverseTentativeTime.end(), -1);
+    context->stopsTentativeTime.reset(                    MAX_INT);
+    context->stopsReverseTentativeTime.reset(             -1);
     //std::fill(stopsD.begin(), stopsD.end(), MAX_INT);
     //std::fill(stopsReverseTentativeTime.begin(), stopsReverseTentativeTime.end(), std::deque<std::pair<int,int>>(1, std::make_pair(MAX_INT, MAX_INT));
-    std::fill(stopsAccessTravelTime.begin(),     stopsAccessTravelTime.end(),     -1);
-    std::fill(stopsEgressTravelTime.begin(),     stopsEgressTravelTime.end(),     -1);
+    context->stopsAccessTravelTime.reset(                 -1);
+    context->stopsEgressTravelTime.reset(                 -1);
     if (resetAccessPaths)
     {
       accessFootpaths.clear();
       egressFootpaths.clear();
     }
-    std::fill(tripsEnterConnection.begin(),      tripsEnterConnection.end(),      -1);
-    std::fill(tripsExitConnection.begin(),       tripsExitConnection.end(),       -1);
-    std::fill(tripsEnterConnectionTransferTravelTime.begin(), tripsEnterConnectionTransferTravelTime.end(), MAX_INT);
-    std::fill(tripsExitConnectionTransferTravelTime.begin(),  tripsExitConnectionTransferTravelTime.end(),  MAX_INT);
+    context->tripsEnterConnection.reset(                  -1);
+    context->tripsExitConnection.reset(                   -1);
+    context->tripsEnterConnectionTransferTravelTime.reset(MAX_INT);
+    context->tripsExitConnectionTransferTravelTime.reset( MAX_INT);
     //std::fill(tripsReverseTime.begin(), tripsReverseTime.end(), MAX_INT);
-    std::fill(tripsEnabled.begin(),          tripsEnabled.end(), 1);
-    std::fill(tripsUsable.begin(),           tripsUsable.end(),  -1);
-    std::fill(forwardJourneys.begin(),       forwardJourneys.end(),       std::make_tuple(-1,-1,-1,-1,-1,-1));
-    std::fill(forwardEgressJourneys.begin(), forwardEgressJourneys.end(), std::make_tuple(-1,-1,-1,-1,-1,-1));
-    std::fill(reverseJourneys.begin(),       reverseJourneys.end(),       std::make_tuple(-1,-1,-1,-1,-1,-1));
-    std::fill(reverseAccessJourneys.begin(), reverseAccessJourneys.end(), std::make_tuple(-1,-1,-1,-1,-1,-1));
+    context->tripsUsable.reset(                           -1);
+    context->forwardJourneys.reset(                       std::make_tuple(-1,-1,-1,-1,-1,-1));
+    context->forwardEgressJourneys.reset(                 std::make_tuple(-1,-1,-1,-1,-1,-1));
+    context->reverseJourneys.reset(                       std::make_tuple(-1,-1,-1,-1,-1,-1));
+    context->reverseAccessJourneys.reset(                 std::make_tuple(-1,-1,-1,-1,-1,-1));
+    context->tripsProfile.reset(                          std::make_tuple(MAX_INT,-1,-1));
+    context->stopsProfilesCounts.reset(                   0);
+    context->stopsTentativeTimeByBoardings.reset(         MAX_INT);
+    context->forwardJourneysByBoardings.reset(            std::make_tuple(-1,-1,-1));
+    context->tripsBoardingsCount.reset(                   MAX_INT);
     
     departureTimeSeconds = -1;
     arrivalTimeSeconds   = -1;
@@ -51,9 +62,7 @@ namespace TrRouting
 
 
 
-    if (params.debugDisplay)
-      std::cerr << "-- reset and preparations -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-    calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    endPhase(PHASE_RESET, "reset and preparations");
 
 
     int i {0};
@@ -65,6 +74,17 @@ namespace TrRouting
     minEgressTravelTime = MAX_INT;
     maxAccessTravelTime = -1;
     
+    // when both access and egress footpaths must come from osrm, fetch them with a single table request:
+    bool accessAndEgressFromOsrm = resetAccessPaths && params.odTrip == NULL
+      && !(params.accessStopIds.size() > 0 && params.accessStopTravelTimesSeconds.size() == params.accessStopIds.size())
+      && !(params.egressStopIds.size() > 0 && params.egressStopTravelTimesSeconds.size() == params.egressStopIds.size());
+    if (accessAndEgressFromOsrm)
+    {
+      std::vector<std::vector<std::pair<int,int>>> accessAndEgressFootpaths = getAccessibleStopsFootpathsFromPoints({params.origin, params.destination}, {params.maxAccessWalkingTravelTimeSeconds, params.maxEgressWalkingTravelTimeSeconds});
+      accessFootpaths = accessAndEgressFootpaths[0];
+      egressFootpaths = accessAndEgressFootpaths[1];
+    }
+    
     if (!params.returnAllStopsResult || departureTimeSeconds >= -1)
     {
       if (resetAccessPaths)
@@ -78,21 +98,24 @@ namespace TrRouting
           i = 0;
           for (auto & accessStopId : params.accessStopIds)
           {
-            accessFootpaths.push_back(std::make_pair(stopIndexesById[accessStopId], params.accessStopTravelTimesSeconds[i]));
+            if (network->stopIndexesById.count(accessStopId) > 0) // ignore unknown stop ids (the shared network must not be modified by lookups)
+            {
+              accessFootpaths.push_back(std::make_pair(network->stopIndexesById.at(accessStopId), params.accessStopTravelTimesSeconds[i]));
+            }
             i++;
           }
         }
-        else
+        else if (!accessAndEgressFromOsrm)
         {
-          accessFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoint(params.origin, stops, params.accessMode, params.maxAccessWalkingTravelTimeSeconds, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+          accessFootpaths = getAccessibleStopsFootpathsFromPoints({params.origin}, {params.maxAccessWalkingTravelTimeSeconds})[0];
         }
       }
     
       for (auto & accessFootpath : accessFootpaths)
       {
-        stopsAccessTravelTime[accessFootpath.first] = accessFootpath.second;
-        forwardJourneys[accessFootpath.first]       = std::make_tuple(-1, -1, -1, -1, accessFootpath.second, -1);
-        stopsTentativeTime[accessFootpath.first]    = departureTimeSeconds + accessFootpath.second + params.minWaitingTimeSeconds;
+        context->stopsAccessTravelTime[accessFootpath.first] = accessFootpath.second;
+        context->forwardJourneys[accessFootpath.first]       = std::make_tuple(-1, -1, -1, -1, accessFootpath.second, -1);
+        context->stopsTentativeTime[accessFootpath.first]    = departureTimeSeconds + accessFootpath.second + params.minWaitingTimeSeconds;
         if (accessFootpath.second < minAccessTravelTime)
         {
           minAccessTravelTime = accessFootpath.second;
@@ -101,8 +124,8 @@ namespace TrRouting
         {
           maxAccessTravelTime = accessFootpath.second;
         }
-        //std::cerr << "origin_stop: " << stops[accessFootpath.first].name << " - " << Toolbox::convertSecondsToFormattedTime(stopsTentativeTime[accessFootpath.first]) << std::endl;
-        //std::cerr << std::to_string(stops[accessFootpath.first].id) + ",";
+        //std::cerr << "origin_stop: " << network->stops[accessFootpath.first].name << " - " << Toolbox::convertSecondsToFormattedTime(context->stopsTentativeTime[accessFootpath.first]) << std::endl;
+        //std::cerr << std::to_string(network->stops[accessFootpath.first].id) + ",";
       }
     }
   
@@ -124,21 +147,24 @@ namespace TrRouting
           i = 0;
           for (auto & egressStopId : params.egressStopIds)
           {
-            egressFootpaths.push_back(std::make_pair(stopIndexesById[egressStopId], params.egressStopTravelTimesSeconds[i]));
+            if (network->stopIndexesById.count(egressStopId) > 0) // ignore unknown stop ids
+            {
+              egressFootpaths.push_back(std::make_pair(network->stopIndexesById.at(egressStopId), params.egressStopTravelTimesSeconds[i]));
+            }
             i++;
           }
         }
-        else
+        else if (!accessAndEgressFromOsrm)
         {
-          egressFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoint(params.destination, stops, params.accessMode, params.maxEgressWalkingTravelTimeSeconds, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+          egressFootpaths = getAccessibleStopsFootpathsFromPoints({params.destination}, {params.maxEgressWalkingTravelTimeSeconds})[0];
         }
       }
       
       for (auto & egressFootpath : egressFootpaths)
       {
-        stopsEgressTravelTime[egressFootpath.first]     = egressFootpath.second;
-        reverseJourneys[egressFootpath.first]           = std::make_tuple(-1, -1, -1, -1, egressFootpath.second, -1);
-        stopsReverseTentativeTime[egressFootpath.first] = arrivalTimeSeconds - egressFootpath.second;
+        context->stopsEgressTravelTime[egressFootpath.first]     = egressFootpath.second;
+        context->reverseJourneys[egressFootpath.first]           = std::make_tuple(-1, -1, -1, -1, egressFootpath.second, -1);
+        context->stopsReverseTentativeTime[egressFootpath.first] = arrivalTimeSeconds - egressFootpath.second;
         if (egressFootpath.second > maxEgressTravelTime)
         {
           maxEgressTravelTime = egressFootpath.second;
@@ -148,7 +174,7 @@ namespace TrRouting
           minEgressTravelTime = egressFootpath.second;
         }
         //stopsD[egressFootpath.first]                = egressFootpath.second;
-        //result.json += "origin_stop: " + stops[accessFootpath.first].name + " - " + Toolbox::convertSecondsToFormattedTime(stopsTentativeTime[accessFootpath.first]) + "\n";
+        //result.json += "origin_stop: " + network->stops[accessFootpath.first].name + " - " + Toolbox::convertSecondsToFormattedTime(context->stopsTentativeTime[accessFootpath.first]) + "\n";
         //result.json += std::to_string((int)(ceil(egressFootpath.second))) + ",";
       }
     }
@@ -159,95 +185,41 @@ namespace TrRouting
 
 
 
-    if (params.debugDisplay)
-      std::cerr << "-- access and egress footpaths -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-    calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    endPhase(PHASE_ACCESS_EGRESS, "access and egress footpaths");
 
 
 
 
 
 
-    // disable trips according to parameters:
-    i = 0;
-    for (auto & trip : trips)
+    // enabled trips: trips running on the requested date (when the network has service calendars), combined word by word
+    // with the precomputed trips bitsets of the filtered routes, route types, agencies and services:
+    const TripTable & trips = network->trips;
+    int               tripsWordsCount   = BitWords::wordsCount(trips.size());
+    uint64_t *        tripsEnabledWords = context->tripsEnabledWords.data();
+    BitWords::setAll(tripsEnabledWords, trips.size());
+    uint64_t * tripsFilterWords = context->tripsFilterWords.data();
+    if (params.routingDateYear > 0 && network->calendar.hasCalendars())
     {
-      if (params.onlyServiceIds.size() > 0)
-      {
-        if (std::find(params.onlyServiceIds.begin(), params.onlyServiceIds.end(), trip.serviceId) == params.onlyServiceIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.onlyRouteIds.size() > 0)
-      {
-        if (std::find(params.onlyRouteIds.begin(), params.onlyRouteIds.end(), trip.routeId) == params.onlyRouteIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.onlyRouteTypeIds.size() > 0)
-      {
-        if (std::find(params.onlyRouteTypeIds.begin(), params.onlyRouteTypeIds.end(), trip.routeTypeId) == params.onlyRouteTypeIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.onlyAgencyIds.size() > 0)
-      {
-        if (std::find(params.onlyAgencyIds.begin(), params.onlyAgencyIds.end(), trip.agencyId) == params.onlyAgencyIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      
-      
-      if (params.exceptServiceIds.size() > 0)
-      {
-        if (std::find(params.exceptServiceIds.begin(), params.exceptServiceIds.end(), trip.serviceId) != params.exceptServiceIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.exceptRouteIds.size() > 0)
-      {
-        if (std::find(params.exceptRouteIds.begin(), params.exceptRouteIds.end(), trip.routeId) != params.exceptRouteIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.exceptRouteTypeIds.size() > 0)
-      {
-        if (std::find(params.exceptRouteTypeIds.begin(), params.exceptRouteTypeIds.end(), trip.routeTypeId) != params.exceptRouteTypeIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      if (params.exceptAgencyIds.size() > 0)
-      {
-        if (std::find(params.exceptAgencyIds.begin(), params.exceptAgencyIds.end(), trip.agencyId) != params.exceptAgencyIds.end())
-        {
-          tripsEnabled[i] = -1;
-        }
-      }
-      
-      i++;
+      std::vector<unsigned long long> runningServiceIds;
+      network->calendar.runningServiceIds(params.routingDateYear, params.routingDateMonth, params.routingDateDay, runningServiceIds);
+      network->servicesTrips.keepTrips(runningServiceIds, tripsEnabledWords, tripsFilterWords, tripsWordsCount);
     }
+    std::vector<unsigned long long> onlyServiceIds(params.onlyServiceIds.begin(), params.onlyServiceIds.end()); // int ids in parameters
+    if (onlyServiceIds.size() > 0)            { network->servicesTrips.keepTrips(  onlyServiceIds,            tripsEnabledWords, tripsFilterWords, tripsWordsCount); }
+    if (params.onlyRouteIds.size() > 0)       { network->routesTrips.keepTrips(    params.onlyRouteIds,       tripsEnabledWords, tripsFilterWords, tripsWordsCount); }
+    if (params.onlyRouteTypeIds.size() > 0)   { network->routeTypesTrips.keepTrips(params.onlyRouteTypeIds,   tripsEnabledWords, tripsFilterWords, tripsWordsCount); }
+    if (params.onlyAgencyIds.size() > 0)      { network->agenciesTrips.keepTrips(  params.onlyAgencyIds,      tripsEnabledWords, tripsFilterWords, tripsWordsCount); }
+    network->servicesTrips.removeTrips(  params.exceptServiceIds,   tripsEnabledWords);
+    network->routesTrips.removeTrips(    params.exceptRouteIds,     tripsEnabledWords);
+    network->routeTypesTrips.removeTrips(params.exceptRouteTypeIds, tripsEnabledWords);
+    network->agenciesTrips.removeTrips(  params.exceptAgencyIds,    tripsEnabledWords);
     
 
 
 
 
-    if (params.debugDisplay)
-      std::cerr << "-- filter trips -- " << algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime << " microseconds\n";
-    calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    endPhase(PHASE_FILTER_TRIPS, "filter trips");
 
 
 
@@ -257,4 +229,45 @@ namespace TrRouting
 
 
 
+  std::vector<std::vector<std::pair<int,int>>> Calculator::getAccessibleStopsFootpathsFromPoints(const std::vector<Point>& points, const std::vector<int>& maxTravelTimesSeconds)
+  {
+    if (params.footpathsCache == NULL)
+    {
+      counters.osrmRequests++;
+      return OsrmFetcher::getAccessibleStopsFootpathsFromPoints(points, maxTravelTimesSeconds, network->stops, network->stopsSpatialIndex, params.accessMode, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+    }
+    
+    // only ask osrm (in a single request) for the points not found in the cache:
+    std::vector<std::vector<std::pair<int,int>>> footpaths(points.size());
+    std::vector<FootpathsCacheKey> keys;
+    std::vector<int>               missingIndexes;
+    std::vector<Point>             missingPoints;
+    std::vector<int>               missingMaxTravelTimesSeconds;
+    keys.reserve(points.size());
+    for (int i = 0; i < (int)points.size(); i++)
+    {
+      keys.push_back(params.footpathsCache->key(points[i], params.accessMode, maxTravelTimesSeconds[i], params.walkingSpeedMetersPerSecond));
+      if (!params.footpathsCache->get(keys[i], footpaths[i]))
+      {
+        missingIndexes.push_back(i);
+        missingPoints.push_back(points[i]);
+        missingMaxTravelTimesSeconds.push_back(maxTravelTimesSeconds[i]);
+      }
+    }
+    if (missingPoints.size() > 0)
+    {
+      counters.osrmRequests++;
+      std::vector<std::vector<std::pair<int,int>>> missingFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoints(missingPoints, missingMaxTravelTimesSeconds, network->stops, network->stopsSpatialIndex, params.accessMode, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+      for (int i = 0; i < (int)missingIndexes.size(); i++)
+      {
+        footpaths[missingIndexes[i]] = missingFootpaths[i];
+        if (missingFootpaths[i].size() > 0) // do not keep empty results, osrm may just have been unreachable
+        {
+          params.footpathsCache->put(keys[missingIndexes[i]], missingFootpaths[i]);
+        }
+      }
+    }
+    return footpaths;
+  }
+  
 }
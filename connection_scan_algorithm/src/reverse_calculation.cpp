@@ -6,7 +6,7 @@ namespace TrRouting
   std::tuple<int,int,int> Calculator::reverseCalculation()
   {
     int  i {0};
-    int  connectionsCount = reverseConnections.size();
+    int  connectionsCount = network->reverseConnections.size();
     int  reachableConnectionsCount {0};
     int  tripIndex {-1};
     int  stopDepartureIndex {-1};
@@ -33,30 +33,38 @@ namespace TrRouting
     //int time3 {-1};
     //int timeC {-1};
 
+    const int * arrivalTimes = network->reverseConnections.arrivalTimes.data();
+    const int * tripIndexes  = network->reverseConnections.tripIndexes.data();
+    const uint64_t * tripsEnabledWords = context->tripsEnabledWords.data();
+    
+    // jump directly to the first connection arriving before arrival time - minimum egress travel time
+    // and stop after the last one arriving within the max total travel time:
+    int startConnectionIndex = network->reverseConnections.firstArrivingAtOrBefore((int)std::max((long long)arrivalTimeSeconds - minEgressTravelTime, (long long)-MAX_INT));
+    int endConnectionIndex   = network->reverseConnections.firstArrivingBefore(    (int)std::max((long long)arrivalTimeSeconds - params.maxTotalTravelTimeSeconds, (long long)-MAX_INT));
+    
     // main loop for reverse connections:
-    i = 0;
-    for(auto & connection : reverseConnections)
+    for(i = startConnectionIndex; i < endConnectionIndex; i++)
     {
       // ignore connections before departure time + minimum access travel time:
-      if (std::get<connectionIndexes::TIME_ARR>(connection) <= arrivalTimeSeconds - minEgressTravelTime)
+      if (arrivalTimes[i] <= arrivalTimeSeconds - minEgressTravelTime)
       {
         
-        tripIndex = std::get<connectionIndexes::TRIP>(connection);
+        tripIndex = tripIndexes[i];
         
         // enabled trips only here:
-        if (tripsUsable[tripIndex] == 1 && tripsEnabled[tripIndex] != -1)
+        if (context->tripsUsable[tripIndex] == 1 && BitWords::test(tripsEnabledWords, tripIndex))
         {
           
-          connectionArrivalTime = std::get<connectionIndexes::TIME_ARR>(connection);
+          connectionArrivalTime = arrivalTimes[i];
           
           // no need to parse next connections if already reached destination from all egress stops, except if max travel time is set, so we can get a reverse profile in the next loop calculation:
           if ( (!params.returnAllStopsResult && reachedAtLeastOneAccessStop && maxAccessTravelTime >= 0 && connectionArrivalTime < tentativeAccessStopDepartureTime - maxAccessTravelTime) || (arrivalTimeSeconds - connectionArrivalTime > params.maxTotalTravelTimeSeconds))
           {
             break;
           }
-          tripExitConnectionIndex  = tripsExitConnection[tripIndex];
-          stopArrivalIndex         = std::get<connectionIndexes::STOP_ARR>(connection);
-          stopArrivalTentativeTime = stopsReverseTentativeTime[stopArrivalIndex];
+          tripExitConnectionIndex  = context->tripsExitConnection[tripIndex];
+          stopArrivalIndex         = network->reverseConnections.arrivalStopIndexes[i];
+          stopArrivalTentativeTime = context->stopsReverseTentativeTime[stopArrivalIndex];
           
           //std::cerr << "stopArrivalTentativeTime: " << stopArrivalTentativeTime << " connectionArrivalTime: " << connectionArrivalTime << " tripExitConnectionIndex: " << tripExitConnectionIndex << std::endl;
           
@@ -64,20 +72,20 @@ namespace TrRouting
           if (tripExitConnectionIndex != -1 || stopArrivalTentativeTime >= connectionArrivalTime)
           {
             
-            if (std::get<connectionIndexes::CAN_UNBOARD>(connection) == 1 && (tripExitConnectionIndex == -1 || (std::get<0>(reverseJourneys[stopArrivalIndex]) == -1 && std::get<4>(reverseJourneys[stopArrivalIndex]) >= 0 && std::get<4>(reverseJourneys[stopArrivalIndex]) <= tripsExitConnectionTransferTravelTime[tripIndex]))) // <= to make sure we get the same result as forward calculation, which uses >
+            if (network->reverseConnections.canUnboard(i) && (tripExitConnectionIndex == -1 || (std::get<0>(context->reverseJourneys[stopArrivalIndex]) == -1 && std::get<4>(context->reverseJourneys[stopArrivalIndex]) >= 0 && std::get<4>(context->reverseJourneys[stopArrivalIndex]) <= context->tripsExitConnectionTransferTravelTime[tripIndex]))) // <= to make sure we get the same result as forward calculation, which uses >
             {
-              tripsExitConnection[tripIndex]                   = i;
-              tripsExitConnectionTransferTravelTime[tripIndex] = std::get<4>(reverseJourneys[stopArrivalIndex]);
+              context->tripsExitConnection[tripIndex]                   = i;
+              context->tripsExitConnectionTransferTravelTime[tripIndex] = std::get<4>(context->reverseJourneys[stopArrivalIndex]);
             }
             
-            if (std::get<connectionIndexes::CAN_BOARD>(connection) == 1 && tripsExitConnection[tripIndex] != -1)
+            if (network->reverseConnections.canBoard(i) && context->tripsExitConnection[tripIndex] != -1)
             {
               // get footpaths for the arrival stop to get transferable stops:
-              stopDepartureIndex      = std::get<connectionIndexes::STOP_DEP>(connection);
-              connectionDepartureTime = std::get<connectionIndexes::TIME_DEP>(connection);
-              footpathsRangeStart     = footpathsRanges[stopDepartureIndex].first;
-              footpathsRangeEnd       = footpathsRanges[stopDepartureIndex].second;
-              if (!params.returnAllStopsResult && !reachedAtLeastOneAccessStop && stopsAccessTravelTime[stopDepartureIndex] != -1) // check if the departure stop is accessable
+              stopDepartureIndex      = network->reverseConnections.departureStopIndexes[i];
+              connectionDepartureTime = network->reverseConnections.departureTimes[i];
+              footpathsRangeStart     = network->footpathsRanges[stopDepartureIndex].first;
+              footpathsRangeEnd       = network->footpathsRanges[stopDepartureIndex].second;
+              if (!params.returnAllStopsResult && !reachedAtLeastOneAccessStop && context->stopsAccessTravelTime[stopDepartureIndex] != -1) // check if the departure stop is accessable
               {
                 reachedAtLeastOneAccessStop      = true;
                 tentativeAccessStopDepartureTime = connectionDepartureTime;
@@ -87,19 +95,19 @@ namespace TrRouting
                 footpathIndex = footpathsRangeStart;
                 while (footpathIndex <= footpathsRangeEnd)
                 {
-                  footpathStopDepartureIndex = std::get<1>(footpaths[footpathIndex]);
-                  footpathTravelTime         = std::get<2>(footpaths[footpathIndex]);
+                  footpathStopDepartureIndex = std::get<1>(network->footpaths[footpathIndex]);
+                  footpathTravelTime         = std::get<2>(network->footpaths[footpathIndex]);
                   
                   if (footpathTravelTime <= params.maxTransferWalkingTravelTimeSeconds)
                   {
-                    if (connectionDepartureTime - footpathTravelTime - params.minWaitingTimeSeconds >= stopsReverseTentativeTime[footpathStopDepartureIndex])
+                    if (connectionDepartureTime - footpathTravelTime - params.minWaitingTimeSeconds >= context->stopsReverseTentativeTime[footpathStopDepartureIndex])
                     {
-                      stopsReverseTentativeTime[footpathStopDepartureIndex] = connectionDepartureTime - footpathTravelTime - params.minWaitingTimeSeconds;
-                      reverseJourneys[footpathStopDepartureIndex]           = std::make_tuple(i, tripsExitConnection[tripIndex], footpathIndex, tripIndex, footpathTravelTime, (stopDepartureIndex == footpathStopDepartureIndex ? 1 : -1));
+                      context->stopsReverseTentativeTime[footpathStopDepartureIndex] = connectionDepartureTime - footpathTravelTime - params.minWaitingTimeSeconds;
+                      context->reverseJourneys[footpathStopDepartureIndex]           = std::make_tuple(i, context->tripsExitConnection[tripIndex], footpathIndex, tripIndex, footpathTravelTime, (stopDepartureIndex == footpathStopDepartureIndex ? 1 : -1));
                     }
-                    if (stopDepartureIndex == footpathStopDepartureIndex && (std::get<4>(reverseAccessJourneys[footpathStopDepartureIndex]) == -1 || std::get<connectionIndexes::TIME_DEP>(reverseConnections[std::get<1>(reverseAccessJourneys[footpathStopDepartureIndex])]) <= connectionDepartureTime))
+                    if (stopDepartureIndex == footpathStopDepartureIndex && (std::get<4>(context->reverseAccessJourneys[footpathStopDepartureIndex]) == -1 || network->reverseConnections.departureTimes[std::get<1>(context->reverseAccessJourneys[footpathStopDepartureIndex])] <= connectionDepartureTime))
                     {
-                      reverseAccessJourneys[footpathStopDepartureIndex] = std::make_tuple(i, tripsExitConnection[tripIndex], footpathIndex, tripIndex, footpathTravelTime, 1);
+                      context->reverseAccessJourneys[footpathStopDepartureIndex] = std::make_tuple(i, context->tripsExitConnection[tripIndex], footpathIndex, tripIndex, footpathTravelTime, 1);
                     }
                   }
                   footpathIndex++;
@@ -110,11 +118,12 @@ namespace TrRouting
           }
         }
       }
-      i++;
     }
     
     if (params.debugDisplay)
-      std::cerr << "-- " << reachableConnectionsCount << " reverse connections parsed on " << connectionsCount << std::endl;
+      std::cerr << "-- " << reachableConnectionsCount << " reverse connections parsed on " << connectionsCount << " (scanned from " << startConnectionIndex << " to " << endConnectionIndex << ")" << std::endl;
+    counters.scannedConnections   += i - startConnectionIndex;
+    counters.reachableConnections += reachableConnectionsCount;
 
     
     int accessStopDepartureTime {-1};
@@ -126,12 +135,12 @@ namespace TrRouting
       i = 0;
       for (auto & accessFootpath : accessFootpaths)
       {
-        accessEnterConnection  = std::get<0>(reverseAccessJourneys[accessFootpath.first]);
+        accessEnterConnection  = std::get<0>(context->reverseAccessJourneys[accessFootpath.first]);
         if (accessEnterConnection != -1)
         {
-          accessTravelTime        = stopsAccessTravelTime[accessFootpath.first];
-          accessStopDepartureTime = std::get<connectionIndexes::TIME_DEP>(reverseConnections[accessEnterConnection]) - accessTravelTime - params.minWaitingTimeSeconds;
-          //std::cerr << stops[accessFootpath.first].name << ": " << accessTravelTime << " t: " << trips[std::get<connectionIndexes::TRIP>(reverseConnections[accessEnterConnection])].id << " - " << Toolbox::convertSecondsToFormattedTime(accessStopDepartureTime) << std::endl;
+          accessTravelTime        = context->stopsAccessTravelTime[accessFootpath.first];
+          accessStopDepartureTime = network->reverseConnections.departureTimes[accessEnterConnection] - accessTravelTime - params.minWaitingTimeSeconds;
+          //std::cerr << network->stops[accessFootpath.first].name << ": " << accessTravelTime << " t: " << network->trips[network->reverseConnections.tripIndexes[accessEnterConnection]].id << " - " << Toolbox::convertSecondsToFormattedTime(accessStopDepartureTime) << std::endl;
           if (accessStopDepartureTime >= 0 && arrivalTimeSeconds - accessStopDepartureTime <= params.maxTotalTravelTimeSeconds && accessStopDepartureTime > bestDepartureTime && accessStopDepartureTime < MAX_INT)
           {
             bestDepartureTime    = accessStopDepartureTime;
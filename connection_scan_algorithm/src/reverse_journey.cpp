@@ -16,7 +16,7 @@ namespace TrRouting
     std::vector<int> resultingStops;
     if (params.returnAllStopsResult)
     {
-      stopsCount     = stops.size();
+      stopsCount     = network->stops.size();
       json["stops"]  = nlohmann::json::array();
       resultingStops = std::vector<int>(stopsCount);
       std::iota (std::begin(resultingStops), std::end(resultingStops), 0); // generate sequencial indexes of each stops
@@ -33,8 +33,8 @@ namespace TrRouting
       std::deque<std::tuple<int,int,int,int,int,short>> journey;
       std::tuple<int,int,int,int,int,short>             resultingStopJourneyStep;
       std::tuple<int,int,int,int,int,short>             emptyJourneyStep {-1,-1,-1,-1,-1,-1};
-      std::tuple<int,int,int,int,int,short,short,int>   journeyStepEnterConnection; // connection tuple: departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequenceinTrip
-      std::tuple<int,int,int,int,int,short,short,int>   journeyStepExitConnection;
+      int                                               journeyStepEnterConnection; // connection index
+      int                                               journeyStepExitConnection;
       std::vector<unsigned long long>                   routeIds;
       std::vector<unsigned long long>                   routeTypeIds;
       std::vector<unsigned long long>                   agencyIds;
@@ -79,15 +79,15 @@ namespace TrRouting
         transferTime             = -1; egressWalkingTime   = -1; 
         waitingTime              = -1; accessWaitingTime   = -1; 
         
-        //std::cerr << stops[resultingStopIndex].name << " : " << std::get<0>(reverseAccessJourneys[resultingStopIndex]) << " tt: " << std::get<4>(reverseAccessJourneys[resultingStopIndex]) << std::endl; 
+        //std::cerr << network->stops[resultingStopIndex].name << " : " << std::get<0>(context->reverseAccessJourneys[resultingStopIndex]) << " tt: " << std::get<4>(context->reverseAccessJourneys[resultingStopIndex]) << std::endl; 
         // recreate journey:
-        resultingStopJourneyStep = reverseAccessJourneys[resultingStopIndex];
+        resultingStopJourneyStep = context->reverseAccessJourneys[resultingStopIndex];
         
         if (resultingStopJourneyStep == emptyJourneyStep) // ignore stops with no route
         {
           continue;
         }
-        //std::cerr << stops[bestEgressStopIndex].name << std::endl;
+        //std::cerr << network->stops[bestEgressStopIndex].name << std::endl;
         i = 0;
         while ((std::get<0>(resultingStopJourneyStep) != -1 && std::get<1>(resultingStopJourneyStep) != -1))
         {
@@ -96,9 +96,9 @@ namespace TrRouting
             std::get<4>(journey[journey.size()-1]) = std::get<4>(resultingStopJourneyStep);
           }
           journey.push_back(resultingStopJourneyStep);
-          bestEgressStopIndex      = std::get<connectionIndexes::STOP_ARR>(reverseConnections[std::get<1>(resultingStopJourneyStep)]);
-          //std::cerr << stops[std::get<connectionIndexes::STOP_DEP>(reverseConnections[std::get<0>(resultingStopJourneyStep)])].name << " tt: " << std::get<4>(resultingStopJourneyStep) << " > "  << stops[std::get<connectionIndexes::STOP_ARR>(reverseConnections[std::get<1>(resultingStopJourneyStep)])].name << std::endl;
-          resultingStopJourneyStep = reverseJourneys[bestEgressStopIndex];
+          bestEgressStopIndex      = network->reverseConnections.arrivalStopIndexes[std::get<1>(resultingStopJourneyStep)];
+          //std::cerr << network->stops[network->reverseConnections.departureStopIndexes[std::get<0>(resultingStopJourneyStep)]].name << " tt: " << std::get<4>(resultingStopJourneyStep) << " > "  << network->stops[network->reverseConnections.arrivalStopIndexes[std::get<1>(resultingStopJourneyStep)]].name << std::endl;
+          resultingStopJourneyStep = context->reverseJourneys[bestEgressStopIndex];
           
           i++;
         }
@@ -106,9 +106,9 @@ namespace TrRouting
         if (!params.returnAllStopsResult)
         {
           json["steps"] = nlohmann::json::array();
-          journey.push_front(std::make_tuple(-1,-1,-1,-1,stopsAccessTravelTime[resultingStopIndex],-1));
+          journey.push_front(std::make_tuple(-1,-1,-1,-1,context->stopsAccessTravelTime[resultingStopIndex],-1));
         }
-        journey.push_back(std::make_tuple(-1,-1,-1,-1,stopsEgressTravelTime[bestEgressStopIndex],-1));
+        journey.push_back(std::make_tuple(-1,-1,-1,-1,context->stopsEgressTravelTime[bestEgressStopIndex],-1));
         
         //std::string stepsJson = "  \"steps\":\n  [\n";
        
@@ -120,17 +120,17 @@ namespace TrRouting
           if (std::get<0>(journeyStep) != -1 && std::get<1>(journeyStep) != -1)
           {
             // journey tuple: final enter connection, final exit connection, final footpath
-            journeyStepEnterConnection  = reverseConnections[std::get<0>(journeyStep)];
-            journeyStepExitConnection   = reverseConnections[std::get<1>(journeyStep)];
-            journeyStepStopDeparture    = stops[std::get<connectionIndexes::STOP_DEP>(journeyStepEnterConnection)];
-            journeyStepStopArrival      = stops[std::get<connectionIndexes::STOP_ARR>(journeyStepExitConnection)];
-            journeyStepTrip             = trips[std::get<3>(journeyStep)];
-            journeyStepRoute            = routes[routeIndexesById[journeyStepTrip.routeId]];
+            journeyStepEnterConnection  = std::get<0>(journeyStep);
+            journeyStepExitConnection   = std::get<1>(journeyStep);
+            journeyStepStopDeparture    = network->stops.stop(network->reverseConnections.departureStopIndexes[journeyStepEnterConnection]);
+            journeyStepStopArrival      = network->stops.stop(network->reverseConnections.arrivalStopIndexes[journeyStepExitConnection]);
+            journeyStepTrip             = network->trips.trip(std::get<3>(journeyStep));
+            journeyStepRoute            = network->routes.route(network->routeIndexesById.at(journeyStepTrip.routeId));
             transferTime                = std::get<4>(journeyStep);
-            departureTime               = std::get<connectionIndexes::TIME_DEP>(journeyStepEnterConnection);
-            arrivalTime                 = std::get<connectionIndexes::TIME_ARR>(journeyStepExitConnection);
-            boardingSequence            = std::get<connectionIndexes::SEQUENCE>(journeyStepEnterConnection);
-            unboardingSequence          = std::get<connectionIndexes::SEQUENCE>(journeyStepExitConnection);
+            departureTime               = network->reverseConnections.departureTimes[journeyStepEnterConnection];
+            arrivalTime                 = network->reverseConnections.arrivalTimes[journeyStepExitConnection];
+            boardingSequence            = network->reverseConnections.sequences[journeyStepEnterConnection];
+            unboardingSequence          = network->reverseConnections.sequences[journeyStepExitConnection];
             inVehicleTime               = arrivalTime   - departureTime;
             waitingTime                 = departureTime - transferArrivalTime;
             transferArrivalTime         = arrivalTime   + transferTime;
@@ -273,14 +273,14 @@ namespace TrRouting
                 
         if (params.returnAllStopsResult)
         {
-          if (std::get<0>(reverseAccessJourneys[resultingStopIndex]) != -1)
+          if (std::get<0>(context->reverseAccessJourneys[resultingStopIndex]) != -1)
           {
-            departureTime = std::get<connectionIndexes::TIME_DEP>(reverseConnections[std::get<0>(reverseAccessJourneys[resultingStopIndex])]) - params.minWaitingTimeSeconds;
+            departureTime = network->reverseConnections.departureTimes[std::get<0>(context->reverseAccessJourneys[resultingStopIndex])] - params.minWaitingTimeSeconds;
             if (arrivalTimeSeconds - departureTime <= params.maxTotalTravelTimeSeconds)
             {
               reachableStopsCount++;
               stopJson                           = {};
-              stopJson["id"]                     = stops[resultingStopIndex].id;
+              stopJson["id"]                     = network->stops.ids[resultingStopIndex];
               stopJson["departureTime"]          = Toolbox::convertSecondsToFormattedTime(departureTime);
               stopJson["totalTravelTimeSeconds"] = arrivalTimeSeconds - departureTime;
               stopJson["numberOfTransfers"]      = numberOfTransfers;
@@ -0,0 +1,695 @@
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+#include "routing_query.hpp"
+
+namespace TrRouting
+{
+
+  namespace
+  {
+
+    enum QueryParameter {
+      UnknownParameter,
+      OriginParameter,
+      DestinationParameter,
+      CalculationNameParameter,
+      FileFormatParameter,
+      BatchParameter,
+      BatchesCountParameter,
+      DateParameter,
+      TimeParameter,
+      AccessStopIdsParameter,
+      EgressStopIdsParameter,
+      AccessStopTravelTimesParameter,
+      EgressStopTravelTimesParameter,
+      OdTripIdParameter,
+      OdTripsParameter,
+      OdTripsSampleSizeParameter,
+      OdTripsPeriodsParameter,
+      OdTripsAgeGroupsParameter,
+      OdTripsGendersParameter,
+      OdTripsOccupationsParameter,
+      OdTripsActivitiesParameter,
+      OdTripsModesParameter,
+      OnlyServiceIdsParameter,
+      ExceptServiceIdsParameter,
+      OnlyRouteIdsParameter,
+      ExceptRouteIdsParameter,
+      OnlyRouteTypeIdsParameter,
+      ExceptRouteTypeIdsParameter,
+      OnlyAgencyIdsParameter,
+      ExceptAgencyIdsParameter,
+      OriginStopIdParameter,
+      DestinationStopIdParameter,
+      MaxTransfersParameter,
+      ByNumberOfTransfersParameter,
+      SaveToFileParameter,
+      MinWaitingTimeParameter,
+      MaxTravelTimeParameter,
+      DepartureWindowParameter,
+      MaxAccessTravelTimeParameter,
+      MaxEgressTravelTimeParameter,
+      MaxTransferTravelTimeParameter,
+      MaxOnlyWalkingAccessRatioParameter,
+      TransferPenaltyParameter,
+      AlternativesParameter,
+      AlternativesListParameter,
+      MaxAlternativesParameter,
+      AlternativesMaxAddedTravelTimeParameter,
+      AlternativesMaxRatioParameter,
+      AlternativesMinMaxTravelTimeParameter,
+      AllStopsParameter,
+      TransferOnlyAtSameStationParameter,
+      DetailedParameter,
+      TransferBetweenSameRouteParameter,
+      ReverseParameter
+    };
+
+    unsigned int sliceHash(const QuerySlice& slice)
+    {
+      unsigned int hash {2166136261u};
+      for (const char * character = slice.begin; character < slice.end; character++)
+      {
+        hash = (hash ^ (unsigned char)*character) * 16777619u;
+      }
+      return hash;
+    }
+
+    // the hash selects the only known name it can be, which must then match exactly:
+    QueryParameter queryParameter(const QuerySlice& name)
+    {
+      const char *   literal;
+      QueryParameter parameter;
+      switch (sliceHash(name))
+      {
+        case queryParameterHash("origin"):                                     literal = "origin";                                     parameter = OriginParameter;                         break;
+        case queryParameterHash("destination"):                                literal = "destination";                                parameter = DestinationParameter;                    break;
+        case queryParameterHash("calculation_name"):                           literal = "calculation_name";                           parameter = CalculationNameParameter;                break;
+        case queryParameterHash("file_format"):                                literal = "file_format";                                parameter = FileFormatParameter;                     break;
+        case queryParameterHash("batch"):                                      literal = "batch";                                      parameter = BatchParameter;                          break;
+        case queryParameterHash("num_batches"):                                literal = "num_batches";                                parameter = BatchesCountParameter;                   break;
+        case queryParameterHash("date"):                                       literal = "date";                                       parameter = DateParameter;                           break;
+        case queryParameterHash("time"):                                       literal = "time";                                       parameter = TimeParameter;                           break;
+        case queryParameterHash("departure"):                                  literal = "departure";                                  parameter = TimeParameter;                           break;
+        case queryParameterHash("arrival"):                                    literal = "arrival";                                    parameter = TimeParameter;                           break;
+        case queryParameterHash("departure_time"):                             literal = "departure_time";                             parameter = TimeParameter;                           break;
+        case queryParameterHash("arrival_time"):                               literal = "arrival_time";                               parameter = TimeParameter;                           break;
+        case queryParameterHash("start_time"):                                 literal = "start_time";                                 parameter = TimeParameter;                           break;
+        case queryParameterHash("end_time"):                                   literal = "end_time";                                   parameter = TimeParameter;                           break;
+        case queryParameterHash("access_stop_ids"):                            literal = "access_stop_ids";                            parameter = AccessStopIdsParameter;                  break;
+        case queryParameterHash("egress_stop_ids"):                            literal = "egress_stop_ids";                            parameter = EgressStopIdsParameter;                  break;
+        case queryParameterHash("access_stop_travel_times_seconds"):           literal = "access_stop_travel_times_seconds";           parameter = AccessStopTravelTimesParameter;          break;
+        case queryParameterHash("access_stop_travel_times"):                   literal = "access_stop_travel_times";                   parameter = AccessStopTravelTimesParameter;          break;
+        case queryParameterHash("egress_stop_travel_times_seconds"):           literal = "egress_stop_travel_times_seconds";           parameter = EgressStopTravelTimesParameter;          break;
+        case queryParameterHash("egress_stop_travel_times"):                   literal = "egress_stop_travel_times";                   parameter = EgressStopTravelTimesParameter;          break;
+        case queryParameterHash("od_trip_id"):                                 literal = "od_trip_id";                                 parameter = OdTripIdParameter;                       break;
+        case queryParameterHash("od_trips"):                                   literal = "od_trips";                                   parameter = OdTripsParameter;                        break;
+        case queryParameterHash("od_trips_sample_size"):                       literal = "od_trips_sample_size";                       parameter = OdTripsSampleSizeParameter;              break;
+        case queryParameterHash("od_trips_periods"):                           literal = "od_trips_periods";                           parameter = OdTripsPeriodsParameter;                 break;
+        case queryParameterHash("od_trips_age_groups"):                        literal = "od_trips_age_groups";                        parameter = OdTripsAgeGroupsParameter;               break;
+        case queryParameterHash("od_trips_genders"):                           literal = "od_trips_genders";                           parameter = OdTripsGendersParameter;                 break;
+        case queryParameterHash("od_trips_occupations"):                       literal = "od_trips_occupations";                       parameter = OdTripsOccupationsParameter;             break;
+        case queryParameterHash("od_trips_activities"):                        literal = "od_trips_activities";                        parameter = OdTripsActivitiesParameter;              break;
+        case queryParameterHash("od_trips_modes"):                             literal = "od_trips_modes";                             parameter = OdTripsModesParameter;                   break;
+        case queryParameterHash("only_service_ids"):                           literal = "only_service_ids";                           parameter = OnlyServiceIdsParameter;                 break;
+        case queryParameterHash("except_service_ids"):                         literal = "except_service_ids";                         parameter = ExceptServiceIdsParameter;               break;
+        case queryParameterHash("only_route_ids"):                             literal = "only_route_ids";                             parameter = OnlyRouteIdsParameter;                   break;
+        case queryParameterHash("except_route_ids"):                           literal = "except_route_ids";                           parameter = ExceptRouteIdsParameter;                 break;
+        case queryParameterHash("only_route_type_ids"):                        literal = "only_route_type_ids";                        parameter = OnlyRouteTypeIdsParameter;               break;
+        case queryParameterHash("except_route_type_ids"):                      literal = "except_route_type_ids";                      parameter = ExceptRouteTypeIdsParameter;             break;
+        case queryParameterHash("only_agency_ids"):                            literal = "only_agency_ids";                            parameter = OnlyAgencyIdsParameter;                  break;
+        case queryParameterHash("except_agency_ids"):                          literal = "except_agency_ids";                          parameter = ExceptAgencyIdsParameter;                break;
+        case queryParameterHash("starting_stop_id"):                           literal = "starting_stop_id";                           parameter = OriginStopIdParameter;                   break;
+        case queryParameterHash("start_stop_id"):                              literal = "start_stop_id";                              parameter = OriginStopIdParameter;                   break;
+        case queryParameterHash("origin_stop_id"):                             literal = "origin_stop_id";                             parameter = OriginStopIdParameter;                   break;
+        case queryParameterHash("ending_stop_id"):                             literal = "ending_stop_id";                             parameter = DestinationStopIdParameter;              break;
+        case queryParameterHash("end_stop_id"):                                literal = "end_stop_id";                                parameter = DestinationStopIdParameter;              break;
+        case queryParameterHash("destination_stop_id"):                        literal = "destination_stop_id";                        parameter = DestinationStopIdParameter;              break;
+        case queryParameterHash("max_number_of_transfers"):                    literal = "max_number_of_transfers";                    parameter = MaxTransfersParameter;                   break;
+        case queryParameterHash("max_transfers"):                              literal = "max_transfers";                              parameter = MaxTransfersParameter;                   break;
+        case queryParameterHash("calculate_by_number_of_transfers"):           literal = "calculate_by_number_of_transfers";           parameter = ByNumberOfTransfersParameter;            break;
+        case queryParameterHash("by_num_transfers"):                           literal = "by_num_transfers";                           parameter = ByNumberOfTransfersParameter;            break;
+        case queryParameterHash("save_to_file"):                               literal = "save_to_file";                               parameter = SaveToFileParameter;                     break;
+        case queryParameterHash("min_waiting_time"):                           literal = "min_waiting_time";                           parameter = MinWaitingTimeParameter;                 break;
+        case queryParameterHash("min_waiting_time_minutes"):                   literal = "min_waiting_time_minutes";                   parameter = MinWaitingTimeParameter;                 break;
+        case queryParameterHash("max_travel_time"):                            literal = "max_travel_time";                            parameter = MaxTravelTimeParameter;                  break;
+        case queryParameterHash("max_travel_time_minutes"):                    literal = "max_travel_time_minutes";                    parameter = MaxTravelTimeParameter;                  break;
+        case queryParameterHash("departure_window"):                           literal = "departure_window";                           parameter = DepartureWindowParameter;                break;
+        case queryParameterHash("departure_window_minutes"):                   literal = "departure_window_minutes";                   parameter = DepartureWindowParameter;                break;
+        case queryParameterHash("max_access_travel_time"):                     literal = "max_access_travel_time";                     parameter = MaxAccessTravelTimeParameter;            break;
+        case queryParameterHash("max_access_travel_time_minutes"):             literal = "max_access_travel_time_minutes";             parameter = MaxAccessTravelTimeParameter;            break;
+        case queryParameterHash("max_egress_travel_time"):                     literal = "max_egress_travel_time";                     parameter = MaxEgressTravelTimeParameter;            break;
+        case queryParameterHash("max_egress_travel_time_minutes"):             literal = "max_egress_travel_time_minutes";             parameter = MaxEgressTravelTimeParameter;            break;
+        case queryParameterHash("max_transfer_travel_time"):                   literal = "max_transfer_travel_time";                   parameter = MaxTransferTravelTimeParameter;          break;
+        case queryParameterHash("max_transfer_travel_time_minutes"):           literal = "max_transfer_travel_time_minutes";           parameter = MaxTransferTravelTimeParameter;          break;
+        case queryParameterHash("max_only_walking_access_travel_time_ratio"):  literal = "max_only_walking_access_travel_time_ratio";  parameter = MaxOnlyWalkingAccessRatioParameter;      break;
+        case queryParameterHash("transfer_penalty"):                           literal = "transfer_penalty";                           parameter = TransferPenaltyParameter;                break;
+        case queryParameterHash("transfer_penalty_minutes"):                   literal = "transfer_penalty_minutes";                   parameter = TransferPenaltyParameter;                break;
+        case queryParameterHash("alternatives"):                               literal = "alternatives";                               parameter = AlternativesParameter;                   break;
+        case queryParameterHash("alt"):                                        literal = "alt";                                        parameter = AlternativesParameter;                   break;
+        case queryParameterHash("alternatives_list"):                          literal = "alternatives_list";                          parameter = AlternativesListParameter;               break;
+        case queryParameterHash("alt_list"):                                   literal = "alt_list";                                   parameter = AlternativesListParameter;               break;
+        case queryParameterHash("max_alternatives"):                           literal = "max_alternatives";                           parameter = MaxAlternativesParameter;                break;
+        case queryParameterHash("max_alt"):                                    literal = "max_alt";                                    parameter = MaxAlternativesParameter;                break;
+        case queryParameterHash("alternatives_max_added_travel_time_minutes"): literal = "alternatives_max_added_travel_time_minutes"; parameter = AlternativesMaxAddedTravelTimeParameter; break;
+        case queryParameterHash("alt_max_added_travel_time"):                  literal = "alt_max_added_travel_time";                  parameter = AlternativesMaxAddedTravelTimeParameter; break;
+        case queryParameterHash("alternatives_max_travel_time_ratio"):         literal = "alternatives_max_travel_time_ratio";         parameter = AlternativesMaxRatioParameter;           break;
+        case queryParameterHash("alt_max_ratio"):                              literal = "alt_max_ratio";                              parameter = AlternativesMaxRatioParameter;           break;
+        case queryParameterHash("alternatives_min_max_travel_time_minutes"):   literal = "alternatives_min_max_travel_time_minutes";   parameter = AlternativesMinMaxTravelTimeParameter;   break;
+        case queryParameterHash("alt_min_max_travel_time"):                    literal = "alt_min_max_travel_time";                    parameter = AlternativesMinMaxTravelTimeParameter;   break;
+        case queryParameterHash("return_all_stops_results"):                   literal = "return_all_stops_results";                   parameter = AllStopsParameter;                       break;
+        case queryParameterHash("return_all_stops_result"):                    literal = "return_all_stops_result";                    parameter = AllStopsParameter;                       break;
+        case queryParameterHash("all_stops"):                                  literal = "all_stops";                                  parameter = AllStopsParameter;                       break;
+        case queryParameterHash("transfer_only_at_same_station"):              literal = "transfer_only_at_same_station";              parameter = TransferOnlyAtSameStationParameter;      break;
+        case queryParameterHash("transfer_only_at_station"):                   literal = "transfer_only_at_station";                   parameter = TransferOnlyAtSameStationParameter;      break;
+        case queryParameterHash("detailed"):                                   literal = "detailed";                                   parameter = DetailedParameter;                       break;
+        case queryParameterHash("detailed_results"):                           literal = "detailed_results";                           parameter = DetailedParameter;                       break;
+        case queryParameterHash("detailed_result"):                            literal = "detailed_result";                            parameter = DetailedParameter;                       break;
+        case queryParameterHash("transfer_between_same_route"):                literal = "transfer_between_same_route";                parameter = TransferBetweenSameRouteParameter;       break;
+        case queryParameterHash("allow_same_route_transfer"):                  literal = "allow_same_route_transfer";                  parameter = TransferBetweenSameRouteParameter;       break;
+        case queryParameterHash("transfers_between_same_route"):               literal = "transfers_between_same_route";               parameter = TransferBetweenSameRouteParameter;       break;
+        case queryParameterHash("allow_same_route_transfers"):                 literal = "allow_same_route_transfers";                 parameter = TransferBetweenSameRouteParameter;       break;
+        case queryParameterHash("reverse"):                                    literal = "reverse";                                    parameter = ReverseParameter;                        break;
+        default:
+          return UnknownParameter;
+      }
+      return name.equals(literal) ? parameter : UnknownParameter;
+    }
+
+    // numbers are converted directly from the query string, conversions stop at the separator (or the end of the
+    // path) ending the slice at the latest. The whole slice must be converted, and start with a digit or a minus sign
+    // followed by a digit, as strtoll and strtof would skip leading spaces and accept a plus sign, inf or nan:
+    bool isNumberStart(const QuerySlice& value)
+    {
+      const char * digit = value.size() > 1 && *value.begin == '-' ? value.begin + 1 : value.begin;
+      return value.size() > 0 && *digit >= '0' && *digit <= '9';
+    }
+
+    bool parseLongLong(const QuerySlice& value, long long& result)
+    {
+      char * parsedEnd;
+      if (!isNumberStart(value))
+      {
+        return false;
+      }
+      result = strtoll(value.begin, &parsedEnd, 10);
+      return parsedEnd == value.end;
+    }
+
+    bool parseInt(const QuerySlice& value, int& result)
+    {
+      long long longResult;
+      if (!parseLongLong(value, longResult) || longResult < INT_MIN || longResult > INT_MAX)
+      {
+        return false;
+      }
+      result = (int)longResult;
+      return true;
+    }
+
+    bool parseFloat(const QuerySlice& value, float& result)
+    {
+      char * parsedEnd;
+      if (!isNumberStart(value))
+      {
+        return false;
+      }
+      result = strtof(value.begin, &parsedEnd);
+      return parsedEnd == value.end;
+    }
+
+    // call parsePart for each part of the value between separators, until it fails:
+    template <typename PartFunction>
+    bool forEachPart(const QuerySlice& value, const char * separators, PartFunction parsePart)
+    {
+      QuerySlice part {value.begin, value.begin};
+      while (true)
+      {
+        while (part.end < value.end && strchr(separators, *part.end) == NULL)
+        {
+          part.end++;
+        }
+        if (!parsePart(part))
+        {
+          return false;
+        }
+        if (part.end == value.end)
+        {
+          return true;
+        }
+        part.begin = part.end + 1;
+        part.end   = part.begin;
+      }
+    }
+
+    bool parseIds(const QuerySlice& value, std::vector<unsigned long long>& ids)
+    {
+      return forEachPart(value, ",", [&ids](const QuerySlice& part) {
+        long long id;
+        if (!parseLongLong(part, id))
+        {
+          return false;
+        }
+        ids.push_back(id);
+        return true;
+      });
+    }
+
+    bool parseInts(const QuerySlice& value, std::vector<int>& integers)
+    {
+      return forEachPart(value, ",", [&integers](const QuerySlice& part) {
+        int integer;
+        if (!parseInt(part, integer))
+        {
+          return false;
+        }
+        integers.push_back(integer);
+        return true;
+      });
+    }
+
+    bool parseStrings(const QuerySlice& value, std::vector<std::string>& strings)
+    {
+      return forEachPart(value, ",", [&strings](const QuerySlice& part) {
+        strings.push_back(std::string(part.begin, part.end));
+        return true;
+      });
+    }
+
+    bool parseMinutesAsSeconds(const QuerySlice& value, int& seconds)
+    {
+      if (!parseInt(value, seconds))
+      {
+        return false;
+      }
+      seconds *= 60;
+      return true;
+    }
+
+    bool parseLatitudeLongitude(const QuerySlice& value, Point& point)
+    {
+      float latitudeLongitude[2];
+      int   partsCount {0};
+      bool  parsed = forEachPart(value, ",", [&latitudeLongitude, &partsCount](const QuerySlice& part) {
+        if (partsCount >= 2 || !parseFloat(part, latitudeLongitude[partsCount]))
+        {
+          return false;
+        }
+        partsCount++;
+        return true;
+      });
+      if (!parsed || partsCount != 2)
+      {
+        return false;
+      }
+      point = Point(latitudeLongitude[0], latitudeLongitude[1]);
+      return true;
+    }
+
+    std::string jsonValueString(const nlohmann::json& valueJson)
+    {
+      if (valueJson.is_string())
+      {
+        return valueJson.get<std::string>();
+      }
+      else if (valueJson.is_boolean())
+      {
+        return valueJson.get<bool>() ? "true" : "false";
+      }
+      return valueJson.dump();
+    }
+
+  }
+
+  bool QuerySlice::equals(const char * literal) const
+  {
+    int literalSize = strlen(literal);
+    return literalSize == size() && strncmp(begin, literal, literalSize) == 0;
+  }
+
+  void RoutingQuery::reset(Parameters& params)
+  {
+    calculationName     = "trRoutingResult";
+    fileFormat          = "json";
+    saveToFile          = false;
+    batchNumber         = 1;
+    batchesCount        = 1;
+    odTripId            = -1;
+    calculateAllOdTrips = false;
+    odTripsSampleSize   = -1;
+    timeHour            = -1;
+    timeMinute          = -1;
+    odTripsPeriods.clear();
+    odTripsGenders.clear();
+    odTripsAgeGroups.clear();
+    odTripsOccupations.clear();
+    odTripsActivities.clear();
+    odTripsModes.clear();
+
+    params.forwardCalculation                     = true;
+    params.detailedResults                        = false;
+    params.returnAllStopsResult                   = false;
+    params.transferOnlyAtSameStation              = false;
+    params.transferBetweenSameRoute               = true;
+    params.origin                                 = Point();
+    params.destination                            = Point();
+    params.routingDateYear                        = 0;
+    params.routingDateMonth                       = 0;
+    params.routingDateDay                         = 0;
+    params.originStopId                           = -1;
+    params.destinationStopId                      = -1;
+    params.odTrip                                 = NULL;
+    params.maxNumberOfTransfers                   = -1;
+    params.minWaitingTimeSeconds                  = 5 * 60;
+    params.departureTimeHour                      = -1;
+    params.departureTimeMinutes                   = -1;
+    params.arrivalTimeHour                        = -1;
+    params.arrivalTimeMinutes                     = -1;
+    params.maxTotalTravelTimeSeconds              = MAX_INT;
+    params.departureWindowSeconds                 = 0;
+    params.maxAccessWalkingTravelTimeSeconds      = 20 * 60;
+    params.maxEgressWalkingTravelTimeSeconds      = 20 * 60;
+    params.maxTransferWalkingTravelTimeSeconds    = 20 * 60;
+    params.maxTotalWalkingTravelTimeSeconds       = 60 * 60;
+    params.maxOnlyWalkingAccessTravelTimeRatio    = 1.5;
+    params.transferPenaltySeconds                 = 0;
+    params.accessMode                             = "walking";
+    params.egressMode                             = "walking";
+    params.noResultSecondMode                     = "driving";
+    params.tryNextModeIfRoutingFails              = false;
+    params.noResultNextAccessTimeSecondsIncrement = 5 * 60;
+    params.maxNoResultNextAccessTimeSeconds       = 40 * 60;
+    params.calculateByNumberOfTransfers           = false;
+    params.alternatives                           = false;
+    params.alternativesList                       = false;
+    params.onlyServiceIds.clear();
+    params.exceptServiceIds.clear();
+    params.onlyRouteIds.clear();
+    params.exceptRouteIds.clear();
+    params.onlyRouteTypeIds.clear();
+    params.exceptRouteTypeIds.clear();
+    params.onlyAgencyIds.clear();
+    params.exceptAgencyIds.clear();
+    params.accessStopIds.clear();
+    params.egressStopIds.clear();
+    params.accessStopTravelTimesSeconds.clear();
+    params.egressStopTravelTimesSeconds.clear();
+  }
+
+  bool RoutingQuery::parse(const char * queryBegin, const char * queryEnd, Parameters& params)
+  {
+    QuerySlice query {queryBegin, queryEnd};
+    QuerySlice name;
+    QuerySlice value;
+    bool       parsed {true};
+
+    // name=value pairs separated by &:
+    parsed = forEachPart(query, "&", [&](const QuerySlice& parameterWithValue) {
+      name.begin = parameterWithValue.begin;
+      name.end   = parameterWithValue.begin;
+      while (name.end < parameterWithValue.end && *name.end != '=')
+      {
+        name.end++;
+      }
+      value.begin = name.end < parameterWithValue.end ? name.end + 1 : name.end;
+      value.end   = parameterWithValue.end;
+
+      switch (queryParameter(name))
+      {
+        case OriginParameter:
+          parsed = parseLatitudeLongitude(value, params.origin);
+          break;
+        case DestinationParameter:
+          parsed = parseLatitudeLongitude(value, params.destination);
+          break;
+        case CalculationNameParameter:
+          calculationName.assign(value.begin, value.end);
+          break;
+        case FileFormatParameter:
+          fileFormat.assign(value.begin, value.end);
+          break;
+        case BatchParameter:
+          parsed = parseInt(value, batchNumber);
+          break;
+        case BatchesCountParameter:
+          parsed = parseInt(value, batchesCount);
+          break;
+        case DateParameter: // 2018/12/31 or 2018-12-31
+        {
+          int dateParts[3];
+          int partsCount {0};
+          parsed = forEachPart(value, "/-", [&dateParts, &partsCount](const QuerySlice& part) {
+            return partsCount < 3 && parseInt(part, dateParts[partsCount++]);
+          }) && partsCount == 3; // a partial date would route on the default service day
+          if (parsed)
+          {
+            params.routingDateYear  = dateParts[0];
+            params.routingDateMonth = dateParts[1];
+            params.routingDateDay   = dateParts[2];
+          }
+          break;
+        }
+        case TimeParameter: // 08:00, seconds are ignored
+        {
+          int timeParts[2];
+          int partsCount {0};
+          forEachPart(value, ":", [&timeParts, &partsCount, &parsed](const QuerySlice& part) {
+            if (partsCount < 2)
+            {
+              parsed = parsed && parseInt(part, timeParts[partsCount]);
+            }
+            partsCount++;
+            return parsed;
+          });
+          parsed = parsed && partsCount >= 2;
+          if (parsed)
+          {
+            timeHour   = timeParts[0];
+            timeMinute = timeParts[1];
+          }
+          break;
+        }
+        case AccessStopIdsParameter:
+          parsed = parseIds(value, params.accessStopIds);
+          break;
+        case EgressStopIdsParameter:
+          parsed = parseIds(value, params.egressStopIds);
+          break;
+        case AccessStopTravelTimesParameter:
+          parsed = parseInts(value, params.accessStopTravelTimesSeconds);
+          break;
+        case EgressStopTravelTimesParameter:
+          parsed = parseInts(value, params.egressStopTravelTimesSeconds);
+          break;
+        case OdTripIdParameter:
+          parsed = parseInt(value, odTripId);
+          break;
+        case OdTripsParameter:
+          if (value.isTrue()) { calculateAllOdTrips = true; }
+          break;
+        case OdTripsSampleSizeParameter:
+          parsed = parseInt(value, odTripsSampleSize);
+          break;
+        case OdTripsPeriodsParameter: // start,end,start,end...
+        {
+          int startAtSeconds {-1};
+          int periodIndex {0};
+          parsed = forEachPart(value, ",", [&](const QuerySlice& part) {
+            int seconds;
+            if (!parseInt(part, seconds))
+            {
+              return false;
+            }
+            if (periodIndex % 2 == 0)
+            {
+              startAtSeconds = seconds;
+            }
+            else
+            {
+              odTripsPeriods.push_back(std::make_pair(startAtSeconds, seconds));
+            }
+            periodIndex++;
+            return true;
+          });
+          break;
+        }
+        case OdTripsAgeGroupsParameter:
+          parsed = parseStrings(value, odTripsAgeGroups);
+          break;
+        case OdTripsGendersParameter:
+          parsed = parseStrings(value, odTripsGenders);
+          break;
+        case OdTripsOccupationsParameter:
+          parsed = parseStrings(value, odTripsOccupations);
+          break;
+        case OdTripsActivitiesParameter:
+          parsed = parseStrings(value, odTripsActivities);
+          break;
+        case OdTripsModesParameter:
+          parsed = parseStrings(value, odTripsModes);
+          break;
+        case OnlyServiceIdsParameter:
+          parsed = parseInts(value, params.onlyServiceIds);
+          break;
+        case ExceptServiceIdsParameter:
+          parsed = parseIds(value, params.exceptServiceIds);
+          break;
+        case OnlyRouteIdsParameter:
+          parsed = parseIds(value, params.onlyRouteIds);
+          break;
+        case ExceptRouteIdsParameter:
+          parsed = parseIds(value, params.exceptRouteIds);
+          break;
+        case OnlyRouteTypeIdsParameter:
+          parsed = parseIds(value, params.onlyRouteTypeIds);
+          break;
+        case ExceptRouteTypeIdsParameter:
+          parsed = parseIds(value, params.exceptRouteTypeIds);
+          break;
+        case OnlyAgencyIdsParameter:
+          parsed = parseIds(value, params.onlyAgencyIds);
+          break;
+        case ExceptAgencyIdsParameter:
+          parsed = parseIds(value, params.exceptAgencyIds);
+          break;
+        case OriginStopIdParameter:
+          parsed = parseLongLong(value, params.originStopId);
+          break;
+        case DestinationStopIdParameter:
+          parsed = parseLongLong(value, params.destinationStopId);
+          break;
+        case MaxTransfersParameter:
+          parsed = parseInt(value, params.maxNumberOfTransfers);
+          break;
+        case ByNumberOfTransfersParameter:
+          if (value.isTrue()) { params.calculateByNumberOfTransfers = true; }
+          break;
+        case SaveToFileParameter:
+          if (value.isTrue()) { saveToFile = true; }
+          break;
+        case MinWaitingTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.minWaitingTimeSeconds);
+          if (params.minWaitingTimeSeconds < 0)
+          {
+            params.minWaitingTimeSeconds = 0;
+          }
+          break;
+        case MaxTravelTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.maxTotalTravelTimeSeconds);
+          if (params.maxTotalTravelTimeSeconds == 0)
+          {
+            params.maxTotalTravelTimeSeconds = MAX_INT;
+          }
+          break;
+        case DepartureWindowParameter:
+          parsed = parseMinutesAsSeconds(value, params.departureWindowSeconds);
+          break;
+        case MaxAccessTravelTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.maxAccessWalkingTravelTimeSeconds);
+          break;
+        case MaxEgressTravelTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.maxEgressWalkingTravelTimeSeconds);
+          break;
+        case MaxTransferTravelTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.maxTransferWalkingTravelTimeSeconds);
+          break;
+        case MaxOnlyWalkingAccessRatioParameter:
+          parsed = parseFloat(value, params.maxOnlyWalkingAccessTravelTimeRatio);
+          break;
+        case TransferPenaltyParameter:
+          parsed = parseMinutesAsSeconds(value, params.transferPenaltySeconds);
+          break;
+        case AlternativesParameter:
+          if (value.isTrue()) { params.alternatives = true; }
+          break;
+        case AlternativesListParameter:
+          if (value.isTrue()) { params.alternativesList = true; }
+          break;
+        case MaxAlternativesParameter:
+          parsed = parseInt(value, params.maxAlternatives);
+          break;
+        case AlternativesMaxAddedTravelTimeParameter:
+          parsed = parseMinutesAsSeconds(value, params.alternativesMaxAddedTravelTimeSeconds);
+          break;
+        case AlternativesMaxRatioParameter:
+          parsed = parseFloat(value, params.alternativesMaxTravelTimeRatio);
+          break;
+        case AlternativesMinMaxTravelTimeParameter:
+        {
+          int minMaxTravelTimeSeconds;
+          parsed = parseMinutesAsSeconds(value, minMaxTravelTimeSeconds);
+          params.minAlternativeMaxTravelTimeSeconds = minMaxTravelTimeSeconds;
+          break;
+        }
+        case AllStopsParameter:
+          if (value.isTrue()) { params.returnAllStopsResult = true; }
+          break;
+        case TransferOnlyAtSameStationParameter:
+          if (value.isTrue()) { params.transferOnlyAtSameStation = true; }
+          break;
+        case DetailedParameter:
+          if (value.isTrue()) { params.detailedResults = true; }
+          break;
+        case TransferBetweenSameRouteParameter:
+          if (value.isFalse()) { params.transferBetweenSameRoute = false; }
+          break;
+        case ReverseParameter:
+          if (value.isTrue()) { params.forwardCalculation = false; }
+          break;
+        case UnknownParameter:
+          break;
+      }
+      return parsed;
+    });
+    if (!parsed)
+    {
+      return false;
+    }
+
+    // the time is a departure or an arrival time depending on the calculation direction, which can be given after it:
+    if (params.forwardCalculation)
+    {
+      params.departureTimeHour    = timeHour;
+      params.departureTimeMinutes = timeMinute;
+    }
+    else
+    {
+      params.arrivalTimeHour    = timeHour;
+      params.arrivalTimeMinutes = timeMinute;
+    }
+    return true;
+  }
+
+  std::string RoutingQuery::queryString(const nlohmann::json& queryJson)
+  {
+    std::string queryString;
+    if (queryJson.is_string())
+    {
+      return queryJson.get<std::string>();
+    }
+    else if (!queryJson.is_object())
+    {
+      throw std::invalid_argument("query is neither a string nor an object");
+    }
+    for (auto parameter = queryJson.begin(); parameter != queryJson.end(); parameter++)
+    {
+      queryString += (queryString.empty() ? "" : "&") + parameter.key() + "=";
+      if (parameter.value().is_array())
+      {
+        for (auto valueIterator = parameter.value().begin(); valueIterator != parameter.value().end(); valueIterator++)
+        {
+          queryString += (valueIterator == parameter.value().begin() ? "" : ",") + jsonValueString(*valueIterator);
+        }
+      }
+      else
+      {
+        queryString += jsonValueString(parameter.value());
+      }
+    }
+    return queryString;
+  }
+
+}
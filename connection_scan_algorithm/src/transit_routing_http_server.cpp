@@ -15,12 +15,16 @@
 
 #include <vector>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <curses.h>
 #include <locale>
+#include <signal.h>
 
 #include "toolbox.hpp"
 #include "database_fetcher.hpp"
@@ -30,7 +34,14 @@
 #include "calculation_time.hpp"
 #include "parameters.hpp"
 #include "calculator.hpp"
-#include "combinations.hpp"
+#include "query_context_pool.hpp"
+#include "footpaths_cache.hpp"
+#include "routing_state.hpp"
+#include "streamed_result.hpp"
+#include "routing_query.hpp"
+#include "metrics.hpp"
+#include "worker_pool.hpp"
+#include "perf_counters.hpp"
 
 //Added for the json-example:
 using namespace boost::property_tree;
@@ -53,13 +64,122 @@ std::string consoleResetColor = "";
 //  const size_t ERROR_IN_COMMAND_LINE = 1;
 //}
 
+// od trips demand aggregated by one od trips calculation task, merged with the other tasks at the end:
+struct OdTripsAggregates {
+  std::map<unsigned long long, std::map<int, double>> tripsLegsProfile; // parent map key: trip id, nested map key: connection sequence, value: number of trips using this connection
+  std::map<unsigned long long, std::map<int, std::pair<double, std::vector<unsigned long long>>>> routePathsLegsProfile; // parent map key: route path id, nested map key: connection sequence, value: number of trips using this connection and their ids
+  std::map<unsigned long long, double> routesOdTripsCount; // key: route id, value: count od trips using this route
+};
+
+// od trips and batch requests are calculated by tasks on the calculation workers after their resource function returned, so
+// the server thread is free to write the results streamed meanwhile. Results are written in order by the task completing the
+// next one, and the last task to finish ends the response. Tasks do not calculate further ahead of what was sent to the client:
+const size_t maxUnsentResultsBytes {1024 * 1024};
+
+struct OdTripsRequest {
+  std::shared_ptr<HttpServer::Response> response;
+  std::shared_ptr<const RoutingState>   routingState;
+  Parameters                            params;
+  RoutingQuery                          query;
+  CalculationTime                       calculationTime;
+  std::vector<int>                      selectedOdTrips; // od trip indexes
+  std::unique_ptr<StreamedResult>       streamedResult;
+  std::unique_ptr<OrderedResults>       odTripsResults;
+  std::vector<OdTripsAggregates>        tasksAggregates;
+  std::atomic<int>                      nextSelectedOdTripIndex {0};
+  std::atomic<int>                      runningTasksCount {0};
+};
+
+struct BatchRequest {
+  std::shared_ptr<HttpServer::Response> response;
+  std::shared_ptr<const RoutingState>   routingState;
+  CalculationTime                       calculationTime;
+  std::vector<std::string>              queryStrings;
+  std::vector<char>                     malformedQueries; // lines or elements which are neither a query string nor an object of parameters, failed in their own slot
+  bool                                  ndjson {false};
+  std::unique_ptr<StreamedResult>       streamedResult;
+  std::unique_ptr<OrderedResults>       queriesResults;
+  std::atomic<int>                      nextQueryIndex {0};
+  std::atomic<int>                      runningTasksCount {0};
+};
+
 //Added for the default_resource example
 void default_resource_send(const HttpServer &server, const std::shared_ptr<HttpServer::Response> &response,
                            const std::shared_ptr<std::ifstream> &ifs);
 
+// metrics exported by /metrics: one histogram by calculator phase followed by one by endpoint, and the calculations counters,
+// followed by one counter by phase and hardware event when the hardware counters are profiled:
+enum RequestsHistogram { RouteRequestsHistogram = Calculator::PHASES_COUNT, OdTripsRequestsHistogram, BatchRequestsHistogram };
+enum ServerCounter { CalculationsCounter, FailedQueriesCounter, ScannedConnectionsCounter, ReachableConnectionsCounter, OsrmRequestsCounter, HardwareEventsCounters };
+
+std::vector<MetricDefinition> serverHistograms()
+{
+  std::vector<MetricDefinition> histograms;
+  for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
+  {
+    histograms.push_back({"trrouting_phase_duration_seconds", "phase=\"" + std::string(Calculator::phaseName(phase)) + "\"", "Duration of the calculator phases."});
+  }
+  histograms.push_back({"trrouting_request_duration_seconds", "endpoint=\"route\"",    "Duration of the requests, by endpoint."});
+  histograms.push_back({"trrouting_request_duration_seconds", "endpoint=\"od_trips\"", "Duration of the requests, by endpoint."});
+  histograms.push_back({"trrouting_request_duration_seconds", "endpoint=\"batch\"",    "Duration of the requests, by endpoint."});
+  return histograms;
+}
+
+std::vector<MetricDefinition> serverCounters(bool profileHardwareCounters)
+{
+  std::vector<MetricDefinition> counters {
+    {"trrouting_calculations_total",          "", "Calculations (queries, od trips and queries of batches, not the cached responses)."},
+    {"trrouting_failed_queries_total",        "", "Malformed queries and failed calculations."},
+    {"trrouting_scanned_connections_total",   "", "Connections between the first and the last connection of the scans."},
+    {"trrouting_reachable_connections_total", "", "Scanned connections of trips which could be used."},
+    {"trrouting_osrm_requests_total",         "", "Requests to osrm for access and egress footpaths."}
+  };
+  for (int phase = 0; profileHardwareCounters && phase < Calculator::PHASES_COUNT; phase++)
+  {
+    for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+    {
+      counters.push_back({"trrouting_phase_hardware_events_total", "phase=\"" + std::string(Calculator::phaseName(phase)) + "\",event=\"" + PerfCounters::eventName(event) + "\"", "Hardware events counted by the calculator phases (user space only)."});
+    }
+  }
+  return counters;
+}
+
+void recordCalculationMetrics(Metrics& metrics, const Calculator& calculator)
+{
+  for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
+  {
+    if (calculator.phasesDurationsMicroseconds[phase] >= 0)
+    {
+      metrics.record(phase, calculator.phasesDurationsMicroseconds[phase]);
+    }
+  }
+  metrics.add(CalculationsCounter);
+  metrics.add(ScannedConnectionsCounter,   calculator.counters.scannedConnections);
+  metrics.add(ReachableConnectionsCounter, calculator.counters.reachableConnections);
+  metrics.add(OsrmRequestsCounter,         calculator.counters.osrmRequests);
+  for (int phase = 0; calculator.params.profileHardwareCounters && phase < Calculator::PHASES_COUNT; phase++)
+  {
+    for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+    {
+      if (calculator.phasesHardwareCounters[phase][event] >= 0)
+      {
+        metrics.add(HardwareEventsCounters + phase * PerfCounters::EVENTS_COUNT + event, calculator.phasesHardwareCounters[phase][event]);
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   
   int serverPort {4000};
+  int threadsCount {1};
+  int odTripsThreads {std::max(1, (int)std::thread::hardware_concurrency())};
+  int alternativesThreads {std::max(1, (int)std::thread::hardware_concurrency())};
+  int batchThreads {std::max(1, (int)std::thread::hardware_concurrency())};
+  int footpathsCacheMb {0};
+  float footpathsCacheSnapMeters {10.0};
+  bool footpathsCachePersist {false};
+  int responseCacheMb {0};
   std::string dataFetcherStr {"database"}; // csv, database
   
   // Get application shortname from config file:
@@ -96,8 +216,28 @@ int main(int argc, char** argv) {
       ("databaseHost",     boost::program_options::value<std::string>(), "database host");
   optionsDesc.add_options() 
       ("databasePassword", boost::program_options::value<std::string>(), "database password");
+  optionsDesc.add_options() 
+      ("threads",          boost::program_options::value<int>(), "number of server threads, each one routing with its own query context (default 1)");
+  optionsDesc.add_options() 
+      ("odTripsThreads",   boost::program_options::value<int>(), "number of worker threads calculating the od trips of a request (default: number of cores)");
+  optionsDesc.add_options() 
+      ("alternativesThreads", boost::program_options::value<int>(), "number of threads calculating the alternatives of a request, with the server thread (default: number of cores)");
+  optionsDesc.add_options() 
+      ("batchThreads",     boost::program_options::value<int>(), "number of worker threads calculating the queries of a batch request (default: number of cores)");
+  optionsDesc.add_options() 
+      ("footpathsCacheMb",         boost::program_options::value<int>(), "memory limit in MB of the cache of access/egress footpaths fetched from osrm (default 0: no cache)");
+  optionsDesc.add_options() 
+      ("footpathsCacheSnapMeters", boost::program_options::value<float>(), "size of the cells in which origins/destinations share the same cached footpaths (default 10)");
+  optionsDesc.add_options() 
+      ("footpathsCachePersist",    boost::program_options::value<int>(), "save the footpaths cache to a .cache file and reload it at startup (1 or 0, default 0)");
+  optionsDesc.add_options() 
+      ("responseCacheMb",          boost::program_options::value<int>(), "memory limit in MB of the cache of routing responses for identical queries (default 0: no cache)");
   optionsDesc.add_options() 
       ("updateOdTrips", boost::program_options::value<std::string>(), "update od trips access and egress stops or not (1 or 0)");
+  optionsDesc.add_options() 
+      ("debug",                    boost::program_options::value<int>(), "log each request with its calculation times (1 or 0, default 0: timings are only exported by /metrics)");
+  optionsDesc.add_options() 
+      ("profileHardwareCounters",  boost::program_options::value<int>(), "count cpu cycles, instructions, llc misses and branch misses of each calculation phase, exported by /metrics (1 or 0, default 0, linux only)");
   
   boost::program_options::store(boost::program_options::parse_command_line(argc, argv, optionsDesc), variablesMap);
   
@@ -149,16 +289,71 @@ int main(int argc, char** argv) {
   {
     algorithmParams.databasePassword = variablesMap["databasePassword"].as<std::string>();
   }
+  if(variablesMap.count("threads") == 1)
+  {
+    threadsCount = std::max(1, variablesMap["threads"].as<int>());
+  }
+  if(variablesMap.count("odTripsThreads") == 1)
+  {
+    odTripsThreads = std::max(1, variablesMap["odTripsThreads"].as<int>());
+  }
+  if(variablesMap.count("alternativesThreads") == 1)
+  {
+    alternativesThreads = std::max(1, variablesMap["alternativesThreads"].as<int>());
+  }
+  if(variablesMap.count("batchThreads") == 1)
+  {
+    batchThreads = std::max(1, variablesMap["batchThreads"].as<int>());
+  }
+  if(variablesMap.count("footpathsCacheMb") == 1)
+  {
+    footpathsCacheMb = std::max(0, variablesMap["footpathsCacheMb"].as<int>());
+  }
+  if(variablesMap.count("footpathsCacheSnapMeters") == 1)
+  {
+    footpathsCacheSnapMeters = std::max(0.1f, variablesMap["footpathsCacheSnapMeters"].as<float>());
+  }
+  if(variablesMap.count("footpathsCachePersist") == 1)
+  {
+    footpathsCachePersist = variablesMap["footpathsCachePersist"].as<int>() == 1;
+  }
+  if(variablesMap.count("responseCacheMb") == 1)
+  {
+    responseCacheMb = std::max(0, variablesMap["responseCacheMb"].as<int>());
+  }
   if(variablesMap.count("updateOdTrips") == 1)
   {
     algorithmParams.updateOdTrips = variablesMap["updateOdTrips"].as<int>();
   }
+  if(variablesMap.count("debug") == 1)
+  {
+    algorithmParams.debugDisplay = variablesMap["debug"].as<int>() == 1;
+  }
+  if(variablesMap.count("profileHardwareCounters") == 1)
+  {
+    algorithmParams.profileHardwareCounters = variablesMap["profileHardwareCounters"].as<int>() == 1;
+  }
   
   
   std::cout << "Using http port "      << serverPort << std::endl;
   std::cout << "Using osrm walk port "  << algorithmParams.osrmRoutingWalkingPort << std::endl;
   std::cout << "Using data fetcher "   << dataFetcherStr << std::endl;
   std::cout << "Using data shortname " << dataShortname << std::endl;
+  std::cout << "Using server threads " << threadsCount << std::endl;
+  std::cout << "Using od trips threads " << odTripsThreads << std::endl;
+  std::cout << "Using alternatives threads " << alternativesThreads << std::endl;
+  std::cout << "Using batch threads " << batchThreads << std::endl;
+  
+  int workersThreads = std::max(odTripsThreads, batchThreads); // each request uses at most its own number of threads from the shared workers
+  std::cout << "Using footpaths cache MB " << footpathsCacheMb << std::endl;
+  std::cout << "Using response cache MB " << responseCacheMb << std::endl;
+  std::cout << "Using debug display " << (algorithmParams.debugDisplay ? 1 : 0) << std::endl;
+  std::cout << "Using hardware counters profiling " << (algorithmParams.profileHardwareCounters ? 1 : 0) << std::endl;
+  if (algorithmParams.profileHardwareCounters && !PerfCounters::ofThisThread().available())
+  {
+    std::cerr << "hardware counters are not available, only durations will be profiled (" << PerfCounters::ofThisThread().unavailableReason() << ")" << std::endl;
+    algorithmParams.profileHardwareCounters = false;
+  }
   
   // setup console colors 
   // (this will create a new terminal window, check if the terminal is color-capable and then it will close the terminal window with endwin()):
@@ -187,7 +382,6 @@ int main(int argc, char** argv) {
   std::cout << "Starting transit routing for the application: ";
   std::cout << consoleGreen + dataShortname + consoleResetColor << std::endl << std::endl;
   
-  Calculator  calculator;
   algorithmParams.applicationShortname = dataShortname;
   algorithmParams.dataFetcherShortname = dataFetcherStr;
   
@@ -208,707 +402,337 @@ int main(int argc, char** argv) {
   CacheFetcher cacheFetcher       = CacheFetcher();
   algorithmParams.cacheFetcher    = &cacheFetcher;
   
-  calculator = Calculator(algorithmParams);
-  int i = 0;
-  
-  /////////
-  
-  std::cout << "preparing server..." << std::endl;
-  
-  //HTTP-server using 1 thread
-  //Unless you do more heavy non-threaded processing in the resources,
-  //1 thread is usually faster than several threads
-  HttpServer server;
-  server.config.port = serverPort;
+  // block SIGHUP in all threads, it is only received by the reload thread (see below):
+  sigset_t reloadSignals;
+  sigemptyset(&reloadSignals);
+  sigaddset(&reloadSignals, SIGHUP);
+  pthread_sigmask(SIG_BLOCK, &reloadSignals, NULL);
   
-  server.resource["^/route/v1/transit[/]?\\?([0-9a-zA-Z&=_,:/.-]+)$"]["GET"]=[&server, &calculator](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
-    
-    calculator.algorithmCalculationTime.start();
-    
-    //calculator.algorithmCalculationTime.startStep();
-    
-    std::cout << "calculating request..." << std::endl;
-    
-    std::string resultStr;
-    std::string csv;
-    
-    std::cout << request->path << std::endl;
+  // load a network with its query contexts (one per server thread, so requests never wait for a context, one per extra alternatives
+  // thread and one per worker thread)
+  // and its access/egress footpaths cache (optionally saved next to the network .cache files):
+  Parameters networkParams = algorithmParams;
+  auto prepareRoutingState = [networkParams, threadsCount, alternativesThreads, workersThreads, footpathsCacheMb, footpathsCacheSnapMeters, responseCacheMb](std::shared_ptr<const RoutingState> previousRoutingState) {
+    Parameters params = networkParams;
+    std::shared_ptr<RoutingState> routingState = std::make_shared<RoutingState>();
+    routingState->network                 = std::make_shared<const TransitNetwork>(params);
     
-    bool saveToFile {false}; // save result to file instead of returning it in response
-    std::string calculationName {"trRoutingResult"};
-    std::string fileFormat {"json"}; // csv can be used, but only with calculateAllTrips = true
-    
-    if (request->path_match.size() >= 1)
+    std::cout << "preparing query contexts..." << std::endl; // only logged here, not for the contexts made while answering requests
+    routingState->queryContextPool        = std::make_shared<QueryContextPool>(routingState->network, threadsCount);
+    routingState->alternativesContextPool = std::make_shared<QueryContextPool>(routingState->network, alternativesThreads - 1);
+    routingState->workersContextPool      = std::make_shared<QueryContextPool>(routingState->network, workersThreads);
+    routingState->networkVersion          = previousRoutingState ? previousRoutingState->networkVersion + 1 : 1;
+    if (footpathsCacheMb > 0)
     {
-      std::vector<std::string> parametersWithValues;
-      
-      std::string queryString = request->path_match[1];
-      
-      boost::split(parametersWithValues, queryString, boost::is_any_of("&"));
-      
-      float originLatitude, originLongitude, destinationLatitude, destinationLongitude;
-      long long startingStopId{-1}, endingStopId{-1};
-      std::vector<int> onlyServiceIds;
-      std::vector<unsigned long long> exceptServiceIds;
-      std::vector<unsigned long long> onlyRouteIds;
-      std::vector<unsigned long long> exceptRouteIds;
-      std::vector<unsigned long long> onlyRouteTypeIds;
-      std::vector<unsigned long long> exceptRouteTypeIds;
-      std::vector<unsigned long long> onlyAgencyIds;
-      std::vector<unsigned long long> exceptAgencyIds;
-      std::vector<unsigned long long> accessStopIds;
-      std::vector<unsigned long long> egressStopIds;
-      std::vector<int> accessStopTravelTimesSeconds;
-      std::vector<int> egressStopTravelTimesSeconds;
-      std::vector<std::pair<int,int>> odTripsPeriods; // pair: start_at_seconds, end_at_seconds
-      std::vector<std::string> odTripsGenders;
-      std::vector<std::string> odTripsAgeGroups;
-      std::vector<std::string> odTripsOccupations;
-      std::vector<std::string> odTripsActivities;
-      std::vector<std::string> odTripsModes;
-      
-      int odTripsSampleSize {-1}; // for testing only
-      bool calculateAllOdTrips {false}; // fetch all od trips from cache or database and calculate for all these trips
-      int batchNumber  {1}; // when using multiple batches (parallele calculations)
-      int batchesCount {1};
-      int odTripId {-1}; // when calculating for only one trip
-      bool alternatives {false}; // calculate alternatives or not
-      
-      calculator.params.onlyServiceIds     = onlyServiceIds;
-      calculator.params.exceptServiceIds   = exceptServiceIds;
-      calculator.params.onlyRouteIds       = onlyRouteIds;
-      calculator.params.exceptRouteIds     = exceptRouteIds;
-      calculator.params.onlyRouteTypeIds   = onlyRouteTypeIds;
-      calculator.params.exceptRouteTypeIds = exceptRouteTypeIds;
-      calculator.params.onlyAgencyIds      = onlyAgencyIds;
-      calculator.params.exceptAgencyIds    = exceptAgencyIds;
-      //calculator.params.odTripsPeriods     = odTripsPeriods;
-      //calculator.params.odTripsGenders     = odTripsGenders;
-      //calculator.params.odTripsAgeGroups   = odTripsAgeGroups;
-      //calculator.params.odTripsOccupations = odTripsOccupations;
-      //calculator.params.odTripsActivities  = odTripsActivities;
-      //calculator.params.odTripsModes       = odTripsModes;
-      
-      std::vector<std::string> parameterWithValueVector;
-      std::vector<std::string> latitudeLongitudeVector;
-      std::vector<std::string> dateVector;
-      std::vector<std::string> timeVector;
-      std::vector<std::string> onlyServiceIdsVector;
-      std::vector<std::string> exceptServiceIdsVector;
-      std::vector<std::string> onlyRouteIdsVector;
-      std::vector<std::string> exceptRouteIdsVector;
-      std::vector<std::string> onlyRouteTypeIdsVector;
-      std::vector<std::string> exceptRouteTypeIdsVector;
-      std::vector<std::string> onlyAgencyIdsVector;
-      std::vector<std::string> exceptAgencyIdsVector;
-      std::vector<std::string> accessStopIdsVector;
-      std::vector<std::string> accessStopTravelTimesSecondsVector;
-      std::vector<std::string> egressStopIdsVector;
-      std::vector<std::string> egressStopTravelTimesSecondsVector;
-      std::vector<std::string> odTripsPeriodsVector;
-      std::vector<std::string> odTripsGendersVector;
-      std::vector<std::string> odTripsAgeGroupsVector;
-      std::vector<std::string> odTripsOccupationsVector;
-      std::vector<std::string> odTripsActivitiesVector;
-      std::vector<std::string> odTripsModesVector;
-
-      int timeHour;
-      int timeMinute;
-      
-      calculator.params.forwardCalculation                     = true;
-      calculator.params.detailedResults                        = false;
-      calculator.params.returnAllStopsResult                   = false;
-      calculator.params.transferOnlyAtSameStation              = false;
-      calculator.params.transferBetweenSameRoute               = true;
-      calculator.params.origin                                 = Point();
-      calculator.params.destination                            = Point();
-      calculator.params.routingDateYear                        = 0;
-      calculator.params.routingDateMonth                       = 0;
-      calculator.params.routingDateDay                         = 0;
-      calculator.params.originStopId                           = -1;
-      calculator.params.destinationStopId                      = -1;
-      calculator.params.odTrip                                 = NULL;
-      calculator.params.maxNumberOfTransfers                   = -1;
-      calculator.params.minWaitingTimeSeconds                  = 5 * 60;
-      calculator.params.departureTimeHour                      = -1;
-      calculator.params.departureTimeMinutes                   = -1;
-      calculator.params.arrivalTimeHour                        = -1;
-      calculator.params.arrivalTimeMinutes                     = -1;
-      calculator.params.maxTotalTravelTimeSeconds              = MAX_INT;
-      calculator.params.maxAccessWalkingTravelTimeSeconds      = 20 * 60;
-      calculator.params.maxEgressWalkingTravelTimeSeconds      = 20 * 60;
-      calculator.params.maxTransferWalkingTravelTimeSeconds    = 20 * 60;
-      calculator.params.maxTotalWalkingTravelTimeSeconds       = 60 * 60;
-      calculator.params.maxOnlyWalkingAccessTravelTimeRatio    = 1.5;
-      calculator.params.transferPenaltySeconds                 = 0;
-      calculator.params.accessMode                             = "walking";
-      calculator.params.egressMode                             = "walking";
-      calculator.params.noResultSecondMode                     = "driving";
-      calculator.params.tryNextModeIfRoutingFails              = false;
-      calculator.params.noResultNextAccessTimeSecondsIncrement = 5 * 60;
-      calculator.params.maxNoResultNextAccessTimeSeconds       = 40 * 60;
-      calculator.params.calculateByNumberOfTransfers           = false;
-      calculator.params.alternatives                           = false;
-      calculator.params.accessStopIds.clear();
-      calculator.params.egressStopIds.clear();
-      calculator.params.accessStopTravelTimesSeconds.clear();
-      calculator.params.egressStopTravelTimesSeconds.clear();
-
-      for(auto & parameterWithValue : parametersWithValues)
+      // cached footpaths are still valid if the stops did not change:
+      if (previousRoutingState && FootpathsCache::stopsSignature(previousRoutingState->network->stops) == FootpathsCache::stopsSignature(routingState->network->stops))
       {
-        boost::split(parameterWithValueVector, parameterWithValue, boost::is_any_of("="));
-        
-        if (parameterWithValueVector[0] == "origin")
-        {
-          boost::split(latitudeLongitudeVector, parameterWithValueVector[1], boost::is_any_of(","));
-          originLatitude           = std::stof(latitudeLongitudeVector[0]);
-          originLongitude          = std::stof(latitudeLongitudeVector[1]);
-          calculator.params.origin = Point(originLatitude, originLongitude);
-        }
-        else if (parameterWithValueVector[0] == "destination")
-        {
-          boost::split(latitudeLongitudeVector, parameterWithValueVector[1], boost::is_any_of(","));
-          destinationLatitude           = std::stof(latitudeLongitudeVector[0]);
-          destinationLongitude          = std::stof(latitudeLongitudeVector[1]);
-          calculator.params.destination = Point(destinationLatitude, destinationLongitude);
-        }
-        else if (parameterWithValueVector[0] == "calculation_name")
-        {
-          calculationName = parameterWithValueVector[1];
-        }
-        else if (parameterWithValueVector[0] == "file_format")
-        {
-          fileFormat = parameterWithValueVector[1];
-        }
-        else if (parameterWithValueVector[0] == "batch")
-        {
-          batchNumber = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "num_batches")
-        {
-          batchesCount = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "date")
-        {
-          boost::split(dateVector, parameterWithValueVector[1], boost::is_any_of("/"));
-          calculator.params.routingDateYear      = std::stoi(dateVector[0]);
-          calculator.params.routingDateMonth     = std::stoi(dateVector[1]);
-          calculator.params.routingDateDay       = std::stoi(dateVector[2]);
-        }
-        else if (parameterWithValueVector[0] == "time"
-                 || parameterWithValueVector[0] == "departure"      || parameterWithValueVector[0] == "arrival"
-                 || parameterWithValueVector[0] == "departure_time" || parameterWithValueVector[0] == "arrival_time"
-                 || parameterWithValueVector[0] == "start_time"     || parameterWithValueVector[0] == "end_time"
-                )
-        {
-          boost::split(timeVector, parameterWithValueVector[1], boost::is_any_of(":"));
-          timeHour      = std::stoi(timeVector[0]);
-          timeMinute    = std::stoi(timeVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "access_stop_ids")
-        {
-          boost::split(accessStopIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string accessStopId : accessStopIdsVector)
-          {
-            accessStopIds.push_back(std::stoll(accessStopId));
-          }
-          calculator.params.accessStopIds = accessStopIds;
-        }
-        else if (parameterWithValueVector[0] == "egress_stop_ids")
-        {
-          boost::split(egressStopIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string egressStopId : egressStopIdsVector)
-          {
-            egressStopIds.push_back(std::stoll(egressStopId));
-          }
-          calculator.params.egressStopIds = egressStopIds;
-        }
-        else if (parameterWithValueVector[0] == "od_trip_id")
-        {
-          odTripId = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "od_trips")
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculateAllOdTrips = true; }
-        }
-        else if (parameterWithValueVector[0] == "od_trips_sample_size")
-        {
-          odTripsSampleSize = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "od_trips_periods")
-        {
-          boost::split(odTripsPeriodsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          int periodIndex {0};
-          int startAtSeconds;
-          int endAtSeconds;
-          for(std::string odTripsTime : odTripsPeriodsVector)
-          {
-            if (periodIndex % 2 == 0)
-            {
-              startAtSeconds = std::stoi(odTripsTime);
-            }
-            else
-            {
-              endAtSeconds = std::stoi(odTripsTime);
-              odTripsPeriods.push_back(std::make_pair(startAtSeconds, endAtSeconds));
-            }
-            periodIndex++;
-          }
-          //calculator.params.odTripsPeriods = odTripsPeriods;
-        }
-        else if (parameterWithValueVector[0] == "od_trips_age_groups")
-        {
-          boost::split(odTripsAgeGroupsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string odTripsAgeGroup : odTripsAgeGroupsVector)
-          {
-            odTripsAgeGroups.push_back(odTripsAgeGroup);
-          }
-          //calculator.params.odTripsAgeGroups = odTripsAgeGroups;
-        }
-        else if (parameterWithValueVector[0] == "od_trips_genders")
-        {
-          boost::split(odTripsGendersVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string odTripsGender : odTripsGendersVector)
-          {
-            odTripsGenders.push_back(odTripsGender);
-          }
-          //calculator.params.odTripsGenders = odTripsGenders;
-        }
-        else if (parameterWithValueVector[0] == "od_trips_occupations")
-        {
-          boost::split(odTripsOccupationsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string odTripsOccupation : odTripsOccupationsVector)
-          {
-            odTripsOccupations.push_back(odTripsOccupation);
-          }
-          //calculator.params.odTripsOccupations = odTripsOccupations;
-        }
-        else if (parameterWithValueVector[0] == "od_trips_activities")
-        {
-          boost::split(odTripsActivitiesVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string odTripsActivity : odTripsActivitiesVector)
-          {
-            odTripsActivities.push_back(odTripsActivity);
-          }
-          //calculator.params.odTripsActivities = odTripsActivities;
-        }
-        else if (parameterWithValueVector[0] == "od_trips_modes")
-        {
-          boost::split(odTripsModesVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string odTripsMode : odTripsModesVector)
-          {
-            odTripsModes.push_back(odTripsMode);
-          }
-          //calculator.params.odTripsModes = odTripsModes;
-        }
-        
-        else if (parameterWithValueVector[0] == "access_stop_travel_times_seconds" || parameterWithValueVector[0] == "access_stop_travel_times")
-        {
-          boost::split(accessStopTravelTimesSecondsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string accessStopTravelTimeSeconds : accessStopTravelTimesSecondsVector)
-          {
-            accessStopTravelTimesSeconds.push_back(std::stoi(accessStopTravelTimeSeconds));
-          }
-          calculator.params.accessStopTravelTimesSeconds = accessStopTravelTimesSeconds;
-        }
-        else if (parameterWithValueVector[0] == "egress_stop_travel_times_seconds" || parameterWithValueVector[0] == "egress_stop_travel_times")
-        {
-          boost::split(egressStopTravelTimesSecondsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string egressStopTravelTimeSeconds : egressStopTravelTimesSecondsVector)
-          {
-            egressStopTravelTimesSeconds.push_back(std::stoi(egressStopTravelTimeSeconds));
-          }
-          calculator.params.egressStopTravelTimesSeconds = egressStopTravelTimesSeconds;
-        }
-        else if (parameterWithValueVector[0] == "only_service_ids")
-        {
-          boost::split(onlyServiceIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string onlyServiceId : onlyServiceIdsVector)
-          {
-            onlyServiceIds.push_back(std::stoll(onlyServiceId));
-          }
-          calculator.params.onlyServiceIds = onlyServiceIds;
-        }
-        else if (parameterWithValueVector[0] == "except_service_ids")
-        {
-          boost::split(exceptServiceIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string exceptServiceId : exceptServiceIdsVector)
-          {
-            exceptServiceIds.push_back(std::stoll(exceptServiceId));
-          }
-          calculator.params.exceptServiceIds = exceptServiceIds;
-        }
-        else if (parameterWithValueVector[0] == "only_route_ids")
-        {
-          boost::split(onlyRouteIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string onlyRouteId : onlyRouteIdsVector)
-          {
-            onlyRouteIds.push_back(std::stoll(onlyRouteId));
-          }
-          calculator.params.onlyRouteIds = onlyRouteIds;
-        }
-        else if (parameterWithValueVector[0] == "except_route_ids")
-        {
-          boost::split(exceptRouteIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string exceptRouteId : exceptRouteIdsVector)
-          {
-            exceptRouteIds.push_back(std::stoll(exceptRouteId));
-          }
-          calculator.params.exceptRouteIds = exceptRouteIds;
-        }
-        else if (parameterWithValueVector[0] == "only_route_type_ids")
-        {
-          boost::split(onlyRouteTypeIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string onlyRouteTypeId : onlyRouteTypeIdsVector)
-          {
-            onlyRouteTypeIds.push_back(std::stoll(onlyRouteTypeId));
-          }
-          calculator.params.onlyRouteTypeIds = onlyRouteTypeIds;
-        }
-        else if (parameterWithValueVector[0] == "except_route_type_ids")
-        {
-          boost::split(exceptRouteTypeIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string exceptRouteTypeId : exceptRouteTypeIdsVector)
-          {
-            exceptRouteTypeIds.push_back(std::stoll(exceptRouteTypeId));
-          }
-          calculator.params.exceptRouteTypeIds = exceptRouteTypeIds;
-        }
-        else if (parameterWithValueVector[0] == "only_agency_ids")
-        {
-          boost::split(onlyAgencyIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string onlyAgencyId : onlyAgencyIdsVector)
-          {
-            onlyAgencyIds.push_back(std::stoll(onlyAgencyId));
-          }
-          calculator.params.onlyAgencyIds = onlyAgencyIds;
-        }
-        else if (parameterWithValueVector[0] == "except_agency_ids")
-        {
-          boost::split(exceptAgencyIdsVector, parameterWithValueVector[1], boost::is_any_of(","));
-          for(std::string exceptAgencyId : exceptAgencyIdsVector)
-          {
-            exceptAgencyIds.push_back(std::stoll(exceptAgencyId));
-          }
-          calculator.params.exceptAgencyIds = exceptAgencyIds;
-        }
-        else if (parameterWithValueVector[0] == "starting_stop_id"
-                 || parameterWithValueVector[0] == "start_stop_id"
-                 || parameterWithValueVector[0] == "origin_stop_id"
-                )
-        {
-          calculator.params.originStopId = std::stoll(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "ending_stop_id"
-                 || parameterWithValueVector[0] == "end_stop_id"
-                 || parameterWithValueVector[0] == "destination_stop_id"
-                )
-        {
-          calculator.params.destinationStopId = std::stoll(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "max_number_of_transfers" || parameterWithValueVector[0] == "max_transfers")
-        {
-          calculator.params.maxNumberOfTransfers = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "calculate_by_number_of_transfers" || parameterWithValueVector[0] == "by_num_transfers")
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.calculateByNumberOfTransfers = true; }
-        }
-        else if (parameterWithValueVector[0] == "save_to_file")
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { saveToFile = true; }
-        }
-        else if (parameterWithValueVector[0] == "min_waiting_time" || parameterWithValueVector[0] == "min_waiting_time_minutes")
-        {
-          calculator.params.minWaitingTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-          if (calculator.params.minWaitingTimeSeconds < 0)
-          {
-            calculator.params.minWaitingTimeSeconds = 0;
-          }
-        }
-        else if (parameterWithValueVector[0] == "max_travel_time" || parameterWithValueVector[0] == "max_travel_time_minutes")
-        {
-          calculator.params.maxTotalTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-          if (calculator.params.maxTotalTravelTimeSeconds == 0)
-          {
-            calculator.params.maxTotalTravelTimeSeconds = MAX_INT;
-          }
-        }
-        else if (parameterWithValueVector[0] == "max_access_travel_time" || parameterWithValueVector[0] == "max_access_travel_time_minutes")
-        {
-          calculator.params.maxAccessWalkingTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "alternatives_max_added_travel_time_minutes" || parameterWithValueVector[0] == "alt_max_added_travel_time")
-        {
-          calculator.params.alternativesMaxAddedTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "max_only_walking_access_travel_time_ratio")
-        {
-          calculator.params.maxOnlyWalkingAccessTravelTimeRatio = std::stof(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "alternatives_max_travel_time_ratio" || parameterWithValueVector[0] == "alt_max_ratio")
-        {
-          calculator.params.alternativesMaxTravelTimeRatio = std::stof(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "alternatives_min_max_travel_time_minutes" || parameterWithValueVector[0] == "alt_min_max_travel_time")
-        {
-          calculator.params.minAlternativeMaxTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "max_egress_travel_time" || parameterWithValueVector[0] == "max_egress_travel_time_minutes")
-        {
-          calculator.params.maxEgressWalkingTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "max_transfer_travel_time" || parameterWithValueVector[0] == "max_transfer_travel_time_minutes")
-        {
-          calculator.params.maxTransferWalkingTravelTimeSeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "transfer_penalty" || parameterWithValueVector[0] == "transfer_penalty_minutes")
-        {
-          calculator.params.transferPenaltySeconds = std::stoi(parameterWithValueVector[1]) * 60;
-        }
-        else if (parameterWithValueVector[0] == "max_alternatives" || parameterWithValueVector[0] == "max_alt")
-        {
-          calculator.params.maxAlternatives = std::stoi(parameterWithValueVector[1]);
-        }
-        else if (parameterWithValueVector[0] == "alternatives" || parameterWithValueVector[0] == "alt")
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.alternatives = true; }
-        }
-        else if (parameterWithValueVector[0] == "return_all_stops_results"
-                 || parameterWithValueVector[0] == "return_all_stops_result"
-                 || parameterWithValueVector[0] == "all_stops"
-                )
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.returnAllStopsResult = true; }
-        }
-        else if (parameterWithValueVector[0] == "transfer_only_at_same_station"
-                 || parameterWithValueVector[0] == "transfer_only_at_station"
-                )
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.transferOnlyAtSameStation = true; }
-        }
-        else if (parameterWithValueVector[0] == "detailed"
-                 || parameterWithValueVector[0] == "detailed_results"
-                 || parameterWithValueVector[0] == "detailed_result"
-                )
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.detailedResults = true; }
-        }
-        else if (parameterWithValueVector[0] == "transfer_between_same_route"
-                 || parameterWithValueVector[0] == "allow_same_route_transfer"
-                 || parameterWithValueVector[0] == "transfers_between_same_route"
-                 || parameterWithValueVector[0] == "allow_same_route_transfers"
-                )
-        {
-          if (parameterWithValueVector[1] == "false" || parameterWithValueVector[1] == "0") { calculator.params.transferBetweenSameRoute = false; }
-        }
-        else if (parameterWithValueVector[0] == "reverse")
-        {
-          if (parameterWithValueVector[1] == "true" || parameterWithValueVector[1] == "1") { calculator.params.forwardCalculation = false; }
-        }
-        
+        routingState->footpathsCache = previousRoutingState->footpathsCache;
       }
-            
-      if (calculator.params.forwardCalculation)
+      else
+      {
+        routingState->footpathsCache = std::make_shared<FootpathsCache>((long long)footpathsCacheMb * 1024 * 1024, footpathsCacheSnapMeters);
+      }
+    }
+    if (responseCacheMb > 0)
+    {
+      // responses of the previous network are dropped, the cache is kept for its statistics. Responses of requests still
+      // running with the previous network are stored with its version, so they will never be returned:
+      if (previousRoutingState)
       {
-        calculator.params.departureTimeHour    = timeHour;
-        calculator.params.departureTimeMinutes = timeMinute;
+        routingState->responseCache = previousRoutingState->responseCache;
+        routingState->responseCache->clear();
       }
       else
       {
-        calculator.params.arrivalTimeHour    = timeHour;
-        calculator.params.arrivalTimeMinutes = timeMinute;
+        routingState->responseCache = std::make_shared<ResponseCache>((long long)responseCacheMb * 1024 * 1024);
       }
-      
-      //for (auto & ageGroup : odTripsAgeGroups)
-      //{
-      //  std::cerr << ageGroup << std::endl;
-      //}
-      
-      if (calculator.params.alternatives)
+    }
+    return std::shared_ptr<const RoutingState>(routingState);
+  };
+  
+  std::cout << "preparing network..." << std::endl;
+  RoutingStateHolder routingStateHolder(prepareRoutingState(nullptr));
+  
+  if (footpathsCacheMb > 0 && footpathsCachePersist && CacheFetcher::cacheFileExists(dataShortname, "footpaths_cache"))
+  {
+    std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+    try
+    {
+      FootpathsCache::Snapshot savedFootpaths;
+      CacheFetcher::loadFromCacheFile(savedFootpaths, dataShortname, "footpaths_cache");
+      std::cout << "loaded " << routingState->footpathsCache->restore(savedFootpaths, FootpathsCache::stopsSignature(routingState->network->stops)) << " cached footpaths" << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+      std::cerr << "could not read footpaths cache file: " << exception.what() << std::endl;
+    }
+  }
+  
+  // build a new network in the background and publish it when ready. Requests keep being answered with the previous network,
+  // which is freed when the last request using it finishes:
+  auto reloadNetwork = [&routingStateHolder, prepareRoutingState]() {
+    if (!routingStateHolder.startReload())
+    {
+      return false;
+    }
+    std::thread([&routingStateHolder, prepareRoutingState](){
+      CalculationTime reloadTime;
+      reloadTime.start();
+      std::cout << "reloading network..." << std::endl;
+      try
       {
-        RoutingResult routingResult;
-        
-        std::vector<unsigned long long>                 foundRouteIds;
-        std::vector< std::vector<unsigned long long> >  allCombinations;
-        std::map<std::vector<unsigned long long>, bool> alreadyCalculatedCombinations;
-        std::map<std::vector<unsigned long long>, bool> alreadyFoundRouteIds;
-        std::map<std::vector<unsigned long long>, int>  foundRouteIdsTravelTimeSeconds;
-        std::vector<int> combinationsKs;
-        int maxTravelTime;
-        int numAlternatives = 1;
-        int maxAlternatives = calculator.params.maxAlternatives;
-        int lastFoundedAtNum = 0;
-        
-        std:: cout << numAlternatives << "." << std::endl;
-        std::cout << "initialMaxTotalTravelTimeSeconds: " << calculator.params.maxTotalTravelTimeSeconds << std::endl;
-        
-        routingResult = calculator.calculate();
-        numAlternatives += 1;
-        
-        
-        
-        maxTravelTime = calculator.params.alternativesMaxTravelTimeRatio * routingResult.travelTimeSeconds;
-        if (maxTravelTime < calculator.params.minAlternativeMaxTravelTimeSeconds)
-        {
-          calculator.params.maxTotalTravelTimeSeconds = calculator.params.minAlternativeMaxTravelTimeSeconds;
-        }
-        else if (maxTravelTime > routingResult.travelTimeSeconds + calculator.params.alternativesMaxAddedTravelTimeSeconds)
+        std::shared_ptr<const RoutingState> routingState = prepareRoutingState(routingStateHolder.current());
+        if (routingState->network->forwardConnections.size() > 0)
         {
-          calculator.params.maxTotalTravelTimeSeconds = routingResult.travelTimeSeconds + calculator.params.alternativesMaxAddedTravelTimeSeconds;
+          routingStateHolder.publish(routingState);
+          std::cout << "network reloaded (version " << routingState->networkVersion << ", " << routingState->network->forwardConnections.size() << " connections) in " << reloadTime.getDurationMicrosecondsNoStop() / 1000 << " ms" << std::endl;
         }
         else
         {
-          calculator.params.maxTotalTravelTimeSeconds = maxTravelTime;
+          std::cerr << "reloaded network has no connections, keeping the current one" << std::endl;
         }
-        
-        std::cout << "minAlternativeMaxTravelTimeSeconds: " << calculator.params.minAlternativeMaxTravelTimeSeconds << std::endl;
-        std::cout << "alternativesMaxAddedTravelTimeSeconds: " << calculator.params.alternativesMaxAddedTravelTimeSeconds << std::endl;
-        std::cout << "alternativesMaxTravelTimeRatio: " << calculator.params.alternativesMaxTravelTimeRatio << std::endl;
-        std::cout << "fastestTravelTimeSeconds: " << routingResult.travelTimeSeconds << std::endl;
-        std::cout << "maxTotalTravelTimeSeconds: " << calculator.params.maxTotalTravelTimeSeconds << std::endl;
-        
-        foundRouteIds = routingResult.routeIds;
-        std::stable_sort(foundRouteIds.begin(),foundRouteIds.end());
-        alreadyFoundRouteIds[foundRouteIds] = true;
-        foundRouteIdsTravelTimeSeconds[foundRouteIds] = routingResult.travelTimeSeconds;
-        lastFoundedAtNum = 1;
-        std::cout << "fastest route ids: ";
-        for (auto routeId : foundRouteIds)
-        {
-          std::cout << calculator.routes[calculator.routeIndexesById[routeId]].shortname << " ";
-        }
-        std::cout << std::endl;
-        combinationsKs.clear();
-        for (int i = 1; i <= foundRouteIds.size(); i++) { combinationsKs.push_back(i); }
-        for (auto k : combinationsKs)
+      }
+      catch (const std::exception& exception)
+      {
+        std::cerr << "could not reload network, keeping the current one: " << exception.what() << std::endl;
+      }
+      routingStateHolder.finishReload();
+    }).detach();
+    return true;
+  };
+  
+  int i = 0;
+  
+  /////////
+  
+  std::cout << "preparing server..." << std::endl;
+  
+  //HTTP-server using threadsCount threads, each request routes with its own calculator
+  //(shared read-only network, borrowed query context and a copy of the default params):
+  HttpServer server;
+  server.config.port             = serverPort;
+  server.config.thread_pool_size = threadsCount;
+  
+  Metrics metrics(serverHistograms(), serverCounters(algorithmParams.profileHardwareCounters));
+  
+  // threads calculating the od trips and the batch queries of all the requests, so concurrent requests share the cores instead
+  // of each starting its own threads:
+  WorkerPool calculationWorkers(workersThreads);
+  
+  // threads calculating the alternatives batches with the server threads. They are not the calculation workers, which may
+  // wait for the server threads to send the results they stream:
+  WorkerPool alternativesWorkers(alternativesThreads - 1);
+  
+  server.resource["^/admin/reload[/]?$"]["POST"]=[&reloadNetwork, &routingStateHolder](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> /*request*/) {
+    
+    std::string resultStr;
+    if (reloadNetwork())
+    {
+      resultStr = "{\"status\": \"reloading\", \"networkVersion\": " + std::to_string(routingStateHolder.current()->networkVersion) + "}";
+    }
+    else
+    {
+      resultStr = "{\"status\": \"alreadyReloading\", \"networkVersion\": " + std::to_string(routingStateHolder.current()->networkVersion) + "}";
+    }
+    *response << "HTTP/1.1 202 Accepted\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << resultStr.length() << "\r\n\r\n" << resultStr;
+    
+  };
+  
+  server.resource["^/admin/response_cache[/]?$"]["GET"]=[&routingStateHolder](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> /*request*/) {
+    
+    std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+    nlohmann::json json;
+    json["status"]  = "success";
+    json["enabled"] = routingState->responseCache != NULL;
+    if (routingState->responseCache)
+    {
+      ResponseCache & responseCache = *routingState->responseCache;
+      json["hits"]          = responseCache.hits();
+      json["misses"]        = responseCache.misses();
+      json["hitRatio"]      = responseCache.hitRatio();
+      json["evictions"]     = responseCache.evictions();
+      json["invalidations"] = responseCache.invalidations();
+      json["entries"]       = responseCache.size();
+      json["usedBytes"]     = responseCache.usedBytes();
+      json["maxBytes"]      = responseCache.maxBytes();
+      json["shards"]        = responseCache.shardsCount();
+    }
+    json["networkVersion"] = routingState->networkVersion;
+    std::string resultStr = json.dump(2);
+    *response << "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << resultStr.length() << "\r\n\r\n" << resultStr;
+    
+  };
+  
+  // one route query calculated with its hardware counters profiled, whatever --profileHardwareCounters, and returned by
+  // phase instead of the route. Without a query, only tells if the counters are available:
+  server.resource["^/debug/hardware_counters[/]?(\\?[0-9a-zA-Z&=_,:/.-]*)?$"]["GET"]=[&routingStateHolder, &algorithmParams](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
+    
+    std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+    PerfCounters & perfCounters = PerfCounters::ofThisThread(); // the calculation runs on this server thread
+    nlohmann::json json;
+    json["status"]    = "success";
+    json["available"] = perfCounters.available();
+    if (!perfCounters.available())
+    {
+      json["unavailableReason"] = perfCounters.unavailableReason();
+    }
+    
+    std::string queryString = request->path_match[1].matched ? request->path_match[1].str().substr(1) : "";
+    if (!queryString.empty())
+    {
+      Calculator calculator(routingState->network, routingState->queryContextPool->borrow(), algorithmParams);
+      calculator.params.footpathsCache          = routingState->footpathsCache.get();
+      calculator.params.profileHardwareCounters = true;
+      RoutingQuery query;
+      query.reset(calculator.params);
+      if (!query.parse(queryString.c_str(), queryString.c_str() + queryString.size(), calculator.params) || query.calculateAllOdTrips || query.odTripId >= 0 || query.saveToFile)
+      {
+        json = {{"status", "failed"}, {"error", "Wrong or malformed query (od trips and saved results cannot be profiled)"}};
+      }
+      else
+      {
+        calculator.algorithmCalculationTime.start();
+        RoutingResult routingResult = calculator.params.alternatives ? calculator.alternativesCalculation(1) : calculator.calculate();
+        json["routingStatus"] = routingResult.status;
+        for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
         {
-          Combinations<unsigned long long> combinations(foundRouteIds, k);
-          //std::cout << "\nk = " << k << std::endl;
-          for (auto newCombination : combinations)
+          if (calculator.phasesDurationsMicroseconds[phase] < 0)
           {
-            std::stable_sort(newCombination.begin(), newCombination.end());
-            allCombinations.push_back(newCombination);
-            alreadyCalculatedCombinations[newCombination] = true;
+            continue;
           }
-        }
-        
-        std::vector<unsigned long long> combination;
-        for (int i = 0; i < allCombinations.size(); i++)
-        {
-          if (numAlternatives <= maxAlternatives)
+          nlohmann::json phaseJson;
+          phaseJson["durationMicroseconds"] = calculator.phasesDurationsMicroseconds[phase];
+          for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
           {
-            std:: cout << std::endl << numAlternatives << "." << std::endl;
-            combination = allCombinations.at(i);
-            calculator.params.exceptRouteIds = combination;
-            std::cout << "except route Ids: ";
-            for (auto routeId : combination)
-            {
-              std::cout << calculator.routes[calculator.routeIndexesById[routeId]].shortname << " ";
-            }
-            std::cout << std::endl;
-            routingResult = calculator.calculate(false);
-            foundRouteIds = routingResult.routeIds;
-            std::stable_sort(foundRouteIds.begin(),foundRouteIds.end());
-            numAlternatives += 1;
-            std::cout << "travelTimeSeconds: " << routingResult.travelTimeSeconds << " route Ids: ";
-            for (auto routeId : foundRouteIds)
-            {
-              std::cout << calculator.routes[calculator.routeIndexesById[routeId]].shortname << " ";
-            }
-            std::cout << std::endl;
-            combinationsKs.clear();
-            if (numAlternatives <= maxAlternatives && foundRouteIds.size() > 0 && alreadyFoundRouteIds.count(foundRouteIds) == 0)
+            if (calculator.phasesHardwareCounters[phase][event] >= 0)
             {
-              lastFoundedAtNum = numAlternatives;
-              alreadyFoundRouteIds[foundRouteIds] = true;
-              foundRouteIdsTravelTimeSeconds[foundRouteIds] = routingResult.travelTimeSeconds;
-              for (int i = 1; i <= foundRouteIds.size(); i++) { combinationsKs.push_back(i); }
-              for (auto k : combinationsKs)
-              {
-                Combinations<unsigned long long> combinations(foundRouteIds, k);
-                //std::cout << "\nk = " << k << std::endl;
-                for (auto newCombination : combinations)
-                {
-                  newCombination.insert( newCombination.end(), combination.begin(), combination.end() );
-                  std::stable_sort(newCombination.begin(), newCombination.end());
-                  if (alreadyCalculatedCombinations.count(newCombination) == 0)
-                  {
-                    allCombinations.push_back(newCombination);
-                    alreadyCalculatedCombinations[newCombination] = true;
-                  }
-                }
-              }
+              phaseJson[PerfCounters::eventName(event)] = calculator.phasesHardwareCounters[phase][event];
             }
-            combination.clear();
           }
-        }
-        
-        std::cout << std::endl;
-        int i {1};
-        for (auto foundRouteIds : alreadyFoundRouteIds)
-        {
-          std::cout << i << ". ";
-          for(auto routeId : foundRouteIds.first)
+          if (calculator.phasesHardwareCounters[phase][PerfCounters::CYCLES] > 0 && calculator.phasesHardwareCounters[phase][PerfCounters::INSTRUCTIONS] >= 0)
           {
-            std::cout << calculator.routes[calculator.routeIndexesById[routeId]].shortname << " ";
+            phaseJson["instructionsPerCycle"] = (double)calculator.phasesHardwareCounters[phase][PerfCounters::INSTRUCTIONS] / calculator.phasesHardwareCounters[phase][PerfCounters::CYCLES];
           }
-          std::cout << " tt: " << (foundRouteIdsTravelTimeSeconds[foundRouteIds.first] / 60);
-          i++;
-          std::cout << std::endl;
+          json["phases"][Calculator::phaseName(phase)] = phaseJson;
         }
-        
-        std::cout << "last founded at num: " << lastFoundedAtNum << std::endl;
-        
-        //return 0;
-        resultStr = routingResult.json;
+        json["scannedConnections"]   = calculator.counters.scannedConnections;
+        json["reachableConnections"] = calculator.counters.reachableConnections;
+      }
+    }
+    
+    std::string resultStr = json.dump(2);
+    *response << "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << resultStr.length() << "\r\n\r\n" << resultStr;
+    
+  };
+  
+  server.resource["^/route/v1/transit[/]?\\?([0-9a-zA-Z&=_,:/.-]+)$"]["GET"]=[&server, &routingStateHolder, &algorithmParams, &metrics, &calculationWorkers, &alternativesWorkers, odTripsThreads, alternativesThreads](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
+    
+    // keep the routing state for the whole request, even if a reloaded network is published meanwhile:
+    std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+    Calculator calculator(routingState->network, routingState->queryContextPool->borrow(), algorithmParams);
+    calculator.params.footpathsCache          = routingState->footpathsCache.get();
+    calculator.params.alternativesContextPool = routingState->alternativesContextPool.get();
+    calculator.params.alternativesWorkers     = &alternativesWorkers;
+    
+    calculator.algorithmCalculationTime.start();
+    
+    //calculator.algorithmCalculationTime.startStep();
+    
+    if (calculator.params.debugDisplay)
+    {
+      std::cout << "calculating request..." << std::endl;
+      std::cout << request->path << std::endl;
+    }
+    
+    std::string resultStr;
+    std::string csv;
+    bool streamed {false}; // response already sent by parts while calculating
+    
+    // parsed in place into the query of this server thread, reused from one request to the next. The od trips tasks
+    // must use it through this reference, not through their own thread_local instance:
+    static thread_local RoutingQuery threadQuery;
+    RoutingQuery & query = threadQuery;
+    query.reset(calculator.params);
+    
+    const char * queryBegin = request->path.c_str() + request->path_match.position(1);
+    const char * queryEnd   = queryBegin + request->path_match.length(1);
+    if (query.parse(queryBegin, queryEnd, calculator.params))
+    {
+      //for (auto & ageGroup : odTripsAgeGroups)
+      //{
+      //  std::cerr << ageGroup << std::endl;
+      //}
+      
+      // od trips results are streamed and saved results must be written again, so only other results are cached:
+      bool cacheable = routingState->responseCache && !query.saveToFile && !query.calculateAllOdTrips && query.odTripId < 0;
+      std::string cacheKey;
+      bool cached {false};
+      if (cacheable)
+      {
+        cacheKey = ResponseCache::normalizedQuery(queryBegin, queryEnd);
+        cached   = routingState->responseCache->get(routingState->networkVersion, cacheKey, resultStr);
+      }
+      
+      if (calculator.params.alternatives && !cached)
+      {
+        resultStr = calculator.alternativesCalculation(alternativesThreads).json;
+        recordCalculationMetrics(metrics, calculator); // fastest route only, alternatives are calculated by worker calculators
       }
       
       
-      if (calculateAllOdTrips || odTripId >= 0)
+      if (query.calculateAllOdTrips || query.odTripId >= 0)
       {
-        RoutingResult routingResult;
-        std::map<unsigned long long, std::map<int, float>> tripsLegsProfile; // parent map key: trip id, nested map key: connection sequence, value: number of trips using this connection
-        std::map<unsigned long long, std::map<int, std::pair<float, std::vector<unsigned long long>>>> routePathsLegsProfile; // parent map key: trip id, nested map key: connection sequence, value: number of trips using this connection
-        std::map<unsigned long long, float> routesOdTripsCount; // key: route id, value: count od trips using this route
-        unsigned long long legTripId;
-        unsigned long long legRouteId;
-        unsigned long long legRoutePathId;
-        bool atLeastOneOdTrip {false};
         bool atLeastOneCompatiblePeriod {false};
         bool attributesMatches {true};
-        int odTripsCount = calculator.odTrips.size();
-        std::string ageGroup;
+        int odTripsCount = calculator.network->odTrips.size();
         
-        int legBoardingSequence;
-        int legUnboardingSequence;
+        std::shared_ptr<OdTripsRequest> odTripsRequest = std::make_shared<OdTripsRequest>();
+        odTripsRequest->response        = response;
+        odTripsRequest->routingState    = routingState;
+        odTripsRequest->calculationTime = calculator.algorithmCalculationTime;
         
-        nlohmann::json json;
-        nlohmann::json odTripJson;
-        nlohmann::json routesOdTripsCountJson;
-        nlohmann::json routePathsOdTripsProfilesJson;
-        nlohmann::json routePathsOdTripsProfilesSequenceJson;
-        //std::vector<unsigned long long> routePathsOdTripsProfilesOdTripIds;
+        // od trips results are sent (and saved) as soon as they are calculated, so they are never all kept in memory.
+        // http/1.0 clients do not support chunks, so their response ends when the connection is closed:
+        bool chunked = request->http_version >= "1.1";
+        response->close_connection_after_response = !chunked;
+        odTripsRequest->streamedResult.reset(new StreamedResult([response](const std::string& content) {
+          *response << content;
+          return HttpServer::Response::send_part(response);
+        }, chunked));
+        StreamedResult & streamedResult = *odTripsRequest->streamedResult;
+        *response << "HTTP/1.1 200 OK\r\nContent-Type: application/" << query.fileFormat << "; charset=utf-8\r\n" << (chunked ? "Transfer-Encoding: chunked\r\n" : "Connection: close\r\n") << "\r\n";
+        streamed = true;
+        if (query.saveToFile && query.fileFormat != "csv")
+        {
+          streamedResult.openFile(query.calculationName + ".json");
+        }
+        else if (query.saveToFile && query.calculateAllOdTrips)
+        {
+          query.calculationName += "__batch_" + std::to_string(query.batchNumber) + "_of_" + std::to_string(query.batchesCount);
+          streamedResult.openFile(query.calculationName + ".csv");
+        }
         
-        if (fileFormat == "csv" && batchNumber == 1) // write header only on first batch, so we can easily append subsequent batches to the same csv file
+        if (query.fileFormat == "csv" && query.batchNumber == 1) // write header only on first batch, so we can easily append subsequent batches to the same csv file
         {
           // write csv header:
-          csv += "id,status,ageGroup,gender,occupation,activity,mode,expansionFactor,travelTimeSeconds,onlyWalkingTravelTimeSeconds,"
+          streamedResult.write("id,status,ageGroup,gender,occupation,activity,mode,expansionFactor,travelTimeSeconds,onlyWalkingTravelTimeSeconds,"
                  "declaredDepartureTimeSeconds,departureTimeSeconds,arrivalTimeSeconds,numberOfTransfers,inVehicleTravelTimeSeconds,"
                  "transferTravelTimeSeconds,waitingTimeSeconds,accessTravelTimeSeconds,egressTravelTimeSeconds,transferWaitingTimeSeconds,"
-                 "firstWaitingTimeSeconds,nonTransitTravelTimeSeconds,routeIds,routeTypeIds,agencyIds,boardingStopIds,unboardingStopIds,tripIds\n";
+                 "firstWaitingTimeSeconds,nonTransitTravelTimeSeconds,routeIds,routeTypeIds,agencyIds,boardingStopIds,unboardingStopIds,tripIds\n");
         }
-        else
+        else if (query.fileFormat != "csv")
         {
-          json["odTrips"] = nlohmann::json::array();
+          streamedResult.write("{\n  \"odTrips\": [");
         }
-                
+        
+        // select od trips to calculate (in od trips order):
+        std::vector<int> & selectedOdTrips = odTripsRequest->selectedOdTrips;
         int i = 0;
-        int j = 0;
-        for (auto & odTrip : calculator.odTrips)
+        for (auto & odTrip : calculator.network->odTrips)
         {
           
-          if ( i % batchesCount != batchNumber - 1) // when using multiple parallel calculators
+          if ( i % query.batchesCount != query.batchNumber - 1) // when using multiple parallel calculators
           {
             i++;
             continue;
@@ -918,18 +742,18 @@ int main(int argc, char** argv) {
           atLeastOneCompatiblePeriod = false;
           
           // verify that od trip matches selected attributes:
-          if ( (odTripsAgeGroups.size()   > 0 && std::find(odTripsAgeGroups.begin(), odTripsAgeGroups.end(), odTrip.ageGroup)       == odTripsAgeGroups.end()) 
-            || (odTripsGenders.size()     > 0 && std::find(odTripsGenders.begin(), odTripsGenders.end(), odTrip.gender)             == odTripsGenders.end())
-            || (odTripsOccupations.size() > 0 && std::find(odTripsOccupations.begin(), odTripsOccupations.end(), odTrip.occupation) == odTripsOccupations.end())
-            || (odTripsActivities.size()  > 0 && std::find(odTripsActivities.begin(), odTripsActivities.end(), odTrip.activity)     == odTripsActivities.end())
-            || (odTripsModes.size()       > 0 && std::find(odTripsModes.begin(), odTripsModes.end(), odTrip.mode)                   == odTripsModes.end())
+          if ( (query.odTripsAgeGroups.size()   > 0 && std::find(query.odTripsAgeGroups.begin(), query.odTripsAgeGroups.end(), odTrip.ageGroup)       == query.odTripsAgeGroups.end()) 
+            || (query.odTripsGenders.size()     > 0 && std::find(query.odTripsGenders.begin(), query.odTripsGenders.end(), odTrip.gender)             == query.odTripsGenders.end())
+            || (query.odTripsOccupations.size() > 0 && std::find(query.odTripsOccupations.begin(), query.odTripsOccupations.end(), odTrip.occupation) == query.odTripsOccupations.end())
+            || (query.odTripsActivities.size()  > 0 && std::find(query.odTripsActivities.begin(), query.odTripsActivities.end(), odTrip.activity)     == query.odTripsActivities.end())
+            || (query.odTripsModes.size()       > 0 && std::find(query.odTripsModes.begin(), query.odTripsModes.end(), odTrip.mode)                   == query.odTripsModes.end())
           )
           {
             attributesMatches = false;
           }
 
           // verify that od trip matches at least one selected period:
-          for (auto & period : odTripsPeriods)
+          for (auto & period : query.odTripsPeriods)
           {
             if (odTrip.departureTimeSeconds >= period.first && odTrip.departureTimeSeconds < period.second)
             {
@@ -937,20 +761,91 @@ int main(int argc, char** argv) {
             }
           }
           
-          if (attributesMatches && (atLeastOneCompatiblePeriod || odTripsPeriods.size() == 0) && (odTripId == -1 || odTripId == odTrip.id) )
+          if (attributesMatches && (atLeastOneCompatiblePeriod || query.odTripsPeriods.size() == 0) && (query.odTripId == -1 || (unsigned long long)query.odTripId == odTrip.id) )
+          {
+            selectedOdTrips.push_back(i);
+          }
+          i++;
+          if (query.odTripsSampleSize >= 0 && i >= query.odTripsSampleSize)
+          {
+            break;
+          }
+        }
+        
+        int selectedOdTripsCount = selectedOdTrips.size();
+        int odTripsTasksCount    = std::max(1, std::min(odTripsThreads, selectedOdTripsCount));
+        if (calculator.params.debugDisplay)
+        {
+          std::cout << "calculating " << selectedOdTripsCount << " od trips with " << odTripsTasksCount << " tasks" << std::endl;
+        }
+        
+        // calculate selected od trips in parallel on the calculation workers, each task with its own calculator and a pooled
+        // query context. Tasks take the next od trip from a shared counter, so no task stays idle while others still have work.
+        // results are kept by od trip until written, so they are returned in the same order whatever the number of tasks.
+        // Stop calculating if the client is gone and nothing is saved to file:
+        odTripsRequest->params            = calculator.params;
+        odTripsRequest->query             = query;
+        odTripsRequest->runningTasksCount = odTripsTasksCount;
+        odTripsRequest->tasksAggregates.resize(odTripsTasksCount);
+        OdTripsRequest * writtenOdTripsRequest = odTripsRequest.get(); // only written to while its tasks keep it
+        odTripsRequest->odTripsResults.reset(new OrderedResults(selectedOdTripsCount, [writtenOdTripsRequest](int selectedOdTripIndex, const std::string& odTripResult) {
+          StreamedResult & streamedResult = *writtenOdTripsRequest->streamedResult;
+          if (writtenOdTripsRequest->query.fileFormat != "csv")
+          {
+            streamedResult.write(selectedOdTripIndex == 0 ? "\n" : ",\n");
+          }
+          streamedResult.write(odTripResult);
+          if (!streamedResult.isSending() && !streamedResult.isSaving() && writtenOdTripsRequest->nextSelectedOdTripIndex < (int)writtenOdTripsRequest->selectedOdTrips.size())
           {
-            std::cout << "od trip id " << odTrip.id << " (" << (i+1) << "/" << odTripsCount << ")" << std::endl;// << " dts: " << odTrip.departureTimeSeconds << " atLeastOneCompatiblePeriod: " << (atLeastOneCompatiblePeriod ? "true " : "false ") << "attributesMatches: " << (attributesMatches ? "true " : "false ") << std::endl;
+            std::cerr << "client disconnected, od trips calculation stopped" << std::endl;
+            writtenOdTripsRequest->nextSelectedOdTripIndex = writtenOdTripsRequest->selectedOdTrips.size();
+          }
+        }, [writtenOdTripsRequest]() {
+          writtenOdTripsRequest->streamedResult->flush();
+        }));
+        
+        for (int taskIndex = 0; taskIndex < odTripsTasksCount; taskIndex++)
+        {
+          calculationWorkers.post([odTripsRequest, &metrics, odTripsCount, taskIndex]() {
+            
+            const RoutingQuery     & query           = odTripsRequest->query;
+            const std::vector<int> & selectedOdTrips = odTripsRequest->selectedOdTrips;
+            int selectedOdTripsCount = selectedOdTrips.size();
+            Calculator odTripCalculator(odTripsRequest->routingState->network, odTripsRequest->routingState->workersContextPool->borrow(), odTripsRequest->params);
+            OdTripsAggregates & aggregates = odTripsRequest->tasksAggregates[taskIndex];
+            RoutingResult routingResult;
+            nlohmann::json odTripJson;
+            std::string odTripJsonStr;
+            std::string ageGroup;
+            unsigned long long legTripId;
+            unsigned long long legRouteId;
+            unsigned long long legRoutePathId;
+            int legBoardingSequence;
+            int legUnboardingSequence;
+            int j;
+            int selectedOdTripIndex;
             
-            calculator.params.origin = odTrip.origin;
-            calculator.params.destination = odTrip.destination;
-            calculator.params.odTrip = &odTrip;
-            routingResult = calculator.calculate();
-            if (true/*routingResult.status == "success"*/)
+            odTripCalculator.algorithmCalculationTime.start();
+            while ((selectedOdTripIndex = odTripsRequest->nextSelectedOdTripIndex++) < selectedOdTripsCount)
             {
-              atLeastOneOdTrip = true;
+              const OdTrip & odTrip = odTripCalculator.network->odTrips[selectedOdTrips[selectedOdTripIndex]];
+              
+              if (odTripCalculator.params.debugDisplay)
+              {
+                std::cout << "od trip id " << odTrip.id << " (" << (selectedOdTrips[selectedOdTripIndex]+1) << "/" << odTripsCount << ")" << std::endl;
+              }
+              
+              odTripCalculator.params.origin      = odTrip.origin;
+              odTripCalculator.params.destination = odTrip.destination;
+              odTripCalculator.params.odTrip      = &odTrip;
+              routingResult = odTripCalculator.calculate();
+              recordCalculationMetrics(metrics, odTripCalculator);
+              
+              std::string odTripResultStr;
+
               if (routingResult.legs.size() > 0)
               {
-                if (fileFormat != "csv")
+                if (query.fileFormat != "csv")
                 {
                   for (auto & leg : routingResult.legs)
                   {
@@ -959,129 +854,129 @@ int main(int argc, char** argv) {
                     legRoutePathId        = std::get<2>(leg);
                     legBoardingSequence   = std::get<3>(leg);
                     legUnboardingSequence = std::get<4>(leg);
-                    if (routesOdTripsCount.find(legRouteId) == routesOdTripsCount.end())
+                    if (aggregates.routesOdTripsCount.find(legRouteId) == aggregates.routesOdTripsCount.end())
                     {
-                      routesOdTripsCount[legRouteId] = odTrip.expansionFactor;
+                      aggregates.routesOdTripsCount[legRouteId] = odTrip.expansionFactor;
                     }
                     else
                     {
-                      routesOdTripsCount[legRouteId] += odTrip.expansionFactor;
+                      aggregates.routesOdTripsCount[legRouteId] += odTrip.expansionFactor;
                     }
-                    if (tripsLegsProfile.find(legTripId) == tripsLegsProfile.end()) // initialize legs for this trip if not already set
+                    if (aggregates.tripsLegsProfile.find(legTripId) == aggregates.tripsLegsProfile.end()) // initialize legs for this trip if not already set
                     {
-                      tripsLegsProfile[legTripId] = std::map<int, float>();
+                      aggregates.tripsLegsProfile[legTripId] = std::map<int, double>();
                     }
-                    if (routePathsLegsProfile.find(legRoutePathId) == routePathsLegsProfile.end()) // initialize legs for this trip if not already set
+                    if (aggregates.routePathsLegsProfile.find(legRoutePathId) == aggregates.routePathsLegsProfile.end()) // initialize legs for this trip if not already set
                     {
-                      routePathsLegsProfile[legRoutePathId] = std::map<int, std::pair<float, std::vector<unsigned long long>>>();
+                      aggregates.routePathsLegsProfile[legRoutePathId] = std::map<int, std::pair<double, std::vector<unsigned long long>>>();
                     }
                     for (int sequence = legBoardingSequence; sequence <= legUnboardingSequence; sequence++) // loop each connection sequence between boarding and unboarding sequences
                     {
                       // increment in trip profile:
-                      if (tripsLegsProfile[legTripId].find(sequence) == tripsLegsProfile[legTripId].end())
+                      if (aggregates.tripsLegsProfile[legTripId].find(sequence) == aggregates.tripsLegsProfile[legTripId].end())
                       {
-                        tripsLegsProfile[legTripId][sequence] = odTrip.expansionFactor; // create the first od_trip for this connection
+                        aggregates.tripsLegsProfile[legTripId][sequence] = odTrip.expansionFactor; // create the first od_trip for this connection
                       }
                       else
                       {
-                        tripsLegsProfile[legTripId][sequence] += odTrip.expansionFactor; // increment od_trips for this connection
+                        aggregates.tripsLegsProfile[legTripId][sequence] += odTrip.expansionFactor; // increment od_trips for this connection
                       }
                       // increment in route path profile:
-                      if (routePathsLegsProfile[legRoutePathId].find(sequence) == routePathsLegsProfile[legRoutePathId].end())
+                      if (aggregates.routePathsLegsProfile[legRoutePathId].find(sequence) == aggregates.routePathsLegsProfile[legRoutePathId].end())
                       {
                         std::vector<unsigned long long> odTripIds;
                         odTripIds.push_back(odTrip.id);
-                        routePathsLegsProfile[legRoutePathId][sequence] = std::make_pair(odTrip.expansionFactor, odTripIds); // create the first od_trip for this connection
+                        aggregates.routePathsLegsProfile[legRoutePathId][sequence] = std::make_pair(odTrip.expansionFactor, odTripIds); // create the first od_trip for this connection
                       }
                       else
                       {
-                        std::get<0>(routePathsLegsProfile[legRoutePathId][sequence]) += odTrip.expansionFactor; // increment od_trips for this connection
-                        std::get<1>(routePathsLegsProfile[legRoutePathId][sequence]).push_back(odTrip.id);
+                        std::get<0>(aggregates.routePathsLegsProfile[legRoutePathId][sequence]) += odTrip.expansionFactor; // increment od_trips for this connection
+                        std::get<1>(aggregates.routePathsLegsProfile[legRoutePathId][sequence]).push_back(odTrip.id);
                       }
                     }
                   }
                 }
               }
               
-              if (fileFormat == "csv")
+              if (query.fileFormat == "csv")
               {
                 ageGroup = odTrip.ageGroup;
                 std::replace( ageGroup.begin(), ageGroup.end(), '-', '_' ); // remove dash so Excel does not convert to age groups to numbers...
-                csv += std::to_string(odTrip.id) + ",\"" + routingResult.status + "\",\"" + ageGroup + "\",\"" + odTrip.gender + "\",\"" + odTrip.occupation + "\",\"";
-                csv += odTrip.activity + "\",\"" + odTrip.mode + "\"," + std::to_string(odTrip.expansionFactor) + "," + std::to_string(routingResult.travelTimeSeconds) + ",";
-                csv += std::to_string(odTrip.walkingTravelTimeSeconds) + "," + std::to_string(odTrip.departureTimeSeconds) + "," + std::to_string(routingResult.departureTimeSeconds) + ",";
-                csv += std::to_string(routingResult.arrivalTimeSeconds) + "," + std::to_string(routingResult.numberOfTransfers) + "," + std::to_string(routingResult.inVehicleTravelTimeSeconds) + ",";
-                csv += std::to_string(routingResult.transferTravelTimeSeconds) + "," + std::to_string(routingResult.waitingTimeSeconds) + "," + std::to_string(routingResult.accessTravelTimeSeconds) + ",";
-                csv += std::to_string(routingResult.egressTravelTimeSeconds) + "," + std::to_string(routingResult.transferWaitingTimeSeconds) + "," + std::to_string(routingResult.firstWaitingTimeSeconds) + ",";
-                csv += std::to_string(routingResult.nonTransitTravelTimeSeconds) + ",";
+                odTripResultStr += std::to_string(odTrip.id) + ",\"" + routingResult.status + "\",\"" + ageGroup + "\",\"" + odTrip.gender + "\",\"" + odTrip.occupation + "\",\"";
+                odTripResultStr += odTrip.activity + "\",\"" + odTrip.mode + "\"," + std::to_string(odTrip.expansionFactor) + "," + std::to_string(routingResult.travelTimeSeconds) + ",";
+                odTripResultStr += std::to_string(odTrip.walkingTravelTimeSeconds) + "," + std::to_string(odTrip.departureTimeSeconds) + "," + std::to_string(routingResult.departureTimeSeconds) + ",";
+                odTripResultStr += std::to_string(routingResult.arrivalTimeSeconds) + "," + std::to_string(routingResult.numberOfTransfers) + "," + std::to_string(routingResult.inVehicleTravelTimeSeconds) + ",";
+                odTripResultStr += std::to_string(routingResult.transferTravelTimeSeconds) + "," + std::to_string(routingResult.waitingTimeSeconds) + "," + std::to_string(routingResult.accessTravelTimeSeconds) + ",";
+                odTripResultStr += std::to_string(routingResult.egressTravelTimeSeconds) + "," + std::to_string(routingResult.transferWaitingTimeSeconds) + "," + std::to_string(routingResult.firstWaitingTimeSeconds) + ",";
+                odTripResultStr += std::to_string(routingResult.nonTransitTravelTimeSeconds) + ",";
                 
                 int countRouteIds = routingResult.routeIds.size();
                 j = 0;
                 for (auto & routeId : routingResult.routeIds)
                 {
-                  csv += std::to_string(routeId);
+                  odTripResultStr += std::to_string(routeId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += ",";
+                odTripResultStr += ",";
                 j = 0;
                 for (auto & routeTypeId : routingResult.routeTypeIds)
                 {
-                  csv += std::to_string(routeTypeId);
+                  odTripResultStr += std::to_string(routeTypeId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += ",";
+                odTripResultStr += ",";
                 j = 0;
                 for (auto & agencyId : routingResult.agencyIds)
                 {
-                  csv += std::to_string(agencyId);
+                  odTripResultStr += std::to_string(agencyId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += ",";
+                odTripResultStr += ",";
                 j = 0;
                 for (auto & boardingStopId : routingResult.boardingStopIds)
                 {
-                  csv += std::to_string(boardingStopId);
+                  odTripResultStr += std::to_string(boardingStopId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += ",";
+                odTripResultStr += ",";
                 j = 0;
                 for (auto & unboardingStopId : routingResult.unboardingStopIds)
                 {
-                  csv += std::to_string(unboardingStopId);
+                  odTripResultStr += std::to_string(unboardingStopId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += ",";
+                odTripResultStr += ",";
                 j = 0;
                 for (auto & tripId : routingResult.tripIds)
                 {
-                  csv += std::to_string(tripId);
+                  odTripResultStr += std::to_string(tripId);
                   if (j < countRouteIds - 1)
                   {
-                    csv += "|";
+                    odTripResultStr += "|";
                   }
                   j++;
                 }
-                csv += "\n";
+                odTripResultStr += "\n";
               }
               else
               {
@@ -1114,63 +1009,136 @@ int main(int argc, char** argv) {
                 odTripJson["boardingStopIds"]              = routingResult.boardingStopIds;
                 odTripJson["unboardingStopIds"]            = routingResult.unboardingStopIds;
                 odTripJson["tripIds"]                      = routingResult.tripIds;
-                json["odTrips"].push_back(odTripJson);
+                odTripJsonStr                              = odTripJson.dump(2);
+                odTripResultStr.reserve(odTripJsonStr.size() + 256);
+                odTripResultStr += "    "; // indented as an element of the odTrips array
+                for (auto & character : odTripJsonStr)
+                {
+                  odTripResultStr += character;
+                  if (character == '\n')
+                  {
+                    odTripResultStr += "    ";
+                  }
+                }
               }
+              
+              odTripsRequest->odTripsResults->set(selectedOdTripIndex, odTripResultStr);
+              odTripsRequest->response->wait_parts(maxUnsentResultsBytes);
             }
-          }
-          i++;
-          if (odTripsSampleSize >= 0 && i >= odTripsSampleSize)
-          {
-            break;
-          }
-        }
-        if (fileFormat != "csv")
-        {
-          routesOdTripsCountJson = {};
-          for (auto & routeCount : routesOdTripsCount)
-          {
-            routesOdTripsCountJson[std::to_string(routeCount.first)] = routeCount.second;
-          }
-          json["routesOdTripsCount"] = routesOdTripsCountJson;
-          
-          routePathsOdTripsProfilesJson = {};
-          for (auto & routePathProfile : routePathsLegsProfile)
-          {
-            routePathsOdTripsProfilesSequenceJson = {};
-            for (auto & sequenceProfile : routePathProfile.second)
+            
+            if (--odTripsRequest->runningTasksCount > 0)
             {
-              //routePathsOdTripsProfilesOdTripIds.clear();
-              //for (auto & odTripId : std::get<1>(sequenceProfile.second))
-              //{
-              //  routePathsOdTripsProfilesOdTripIds.push_back()
-              //}
-              routePathsOdTripsProfilesSequenceJson[std::to_string(sequenceProfile.first)] = {{"demand", std::get<0>(sequenceProfile.second)}, {"odTripIds", std::get<1>(sequenceProfile.second)}};
+              return;
             }
-            routePathsOdTripsProfilesJson[std::to_string(routePathProfile.first)] = routePathsOdTripsProfilesSequenceJson;
-          }
-          json["routePathsOdTripsProfiles"] = routePathsOdTripsProfilesJson;
-          resultStr = json.dump(2);
-        }
-        if (calculateAllOdTrips && fileFormat == "csv")
-        {
+            
+            // the last task to finish merges the tasks aggregates and ends the response:
+            std::map<unsigned long long, std::map<int, double>> tripsLegsProfile; // parent map key: trip id, nested map key: connection sequence, value: number of trips using this connection
+            std::map<unsigned long long, std::map<int, std::pair<double, std::vector<unsigned long long>>>> routePathsLegsProfile; // parent map key: trip id, nested map key: connection sequence, value: number of trips using this connection
+            std::map<unsigned long long, double> routesOdTripsCount; // key: route id, value: count od trips using this route
+            StreamedResult & streamedResult = *odTripsRequest->streamedResult;
+            std::string resultStr;
+            
+            nlohmann::json json;
+            nlohmann::json routesOdTripsCountJson;
+            nlohmann::json routePathsOdTripsProfilesJson;
+            nlohmann::json routePathsOdTripsProfilesSequenceJson;
+            //std::vector<unsigned long long> routePathsOdTripsProfilesOdTripIds;
+            
+            for (auto & taskAggregates : odTripsRequest->tasksAggregates)
+            {
+              for (auto & routeCount : taskAggregates.routesOdTripsCount)
+              {
+                routesOdTripsCount[routeCount.first] += routeCount.second;
+              }
+              for (auto & tripProfile : taskAggregates.tripsLegsProfile)
+              {
+                for (auto & sequenceProfile : tripProfile.second)
+                {
+                  tripsLegsProfile[tripProfile.first][sequenceProfile.first] += sequenceProfile.second;
+                }
+              }
+              for (auto & routePathProfile : taskAggregates.routePathsLegsProfile)
+              {
+                for (auto & sequenceProfile : routePathProfile.second)
+                {
+                  std::pair<double, std::vector<unsigned long long>> & mergedSequenceProfile = routePathsLegsProfile[routePathProfile.first][sequenceProfile.first];
+                  std::get<0>(mergedSequenceProfile) += std::get<0>(sequenceProfile.second);
+                  std::get<1>(mergedSequenceProfile).insert(std::get<1>(mergedSequenceProfile).end(), std::get<1>(sequenceProfile.second).begin(), std::get<1>(sequenceProfile.second).end());
+                }
+              }
+            }
+            if (odTripsRequest->tasksAggregates.size() > 1) // put back od trip ids in od trips order
+            {
+              const IdIndexMap & odTripIndexesById = odTripCalculator.network->odTripIndexesById;
+              for (auto & routePathProfile : routePathsLegsProfile)
+              {
+                for (auto & sequenceProfile : routePathProfile.second)
+                {
+                  std::sort(std::get<1>(sequenceProfile.second).begin(), std::get<1>(sequenceProfile.second).end(), [&odTripIndexesById](unsigned long long odTripIdA, unsigned long long odTripIdB) {
+                    return odTripIndexesById.at(odTripIdA) < odTripIndexesById.at(odTripIdB);
+                  });
+                }
+              }
+            }
+        
+
+            if (query.fileFormat != "csv")
+            {
+              routesOdTripsCountJson = {};
+              for (auto & routeCount : routesOdTripsCount)
+              {
+                routesOdTripsCountJson[std::to_string(routeCount.first)] = (float)routeCount.second;
+              }
+              json["routesOdTripsCount"] = routesOdTripsCountJson;
           
+              routePathsOdTripsProfilesJson = {};
+              for (auto & routePathProfile : routePathsLegsProfile)
+              {
+                routePathsOdTripsProfilesSequenceJson = {};
+                for (auto & sequenceProfile : routePathProfile.second)
+                {
+                  //routePathsOdTripsProfilesOdTripIds.clear();
+                  //for (auto & odTripId : std::get<1>(sequenceProfile.second))
+                  //{
+                  //  routePathsOdTripsProfilesOdTripIds.push_back()
+                  //}
+                  routePathsOdTripsProfilesSequenceJson[std::to_string(sequenceProfile.first)] = {{"demand", (float)std::get<0>(sequenceProfile.second)}, {"odTripIds", std::get<1>(sequenceProfile.second)}};
+                }
+                routePathsOdTripsProfilesJson[std::to_string(routePathProfile.first)] = routePathsOdTripsProfilesSequenceJson;
+              }
+              json["routePathsOdTripsProfiles"] = routePathsOdTripsProfilesJson;
           
-          if (saveToFile)
-          {
-            calculationName += "__batch_" + std::to_string(batchNumber) + "_of_" + std::to_string(batchesCount);
-            std::cerr << "writing csv file" << std::endl;
-            std::ofstream csvFile;
-            //csvFile.imbue(std::locale("en_US.UTF8"));
-            csvFile.open(calculationName + ".csv", std::ios_base::trunc);
-            csvFile << csv;
-            csvFile.close();
-            //resultStr = "{\"status\": \"success\", \"format\": \"csv\", \"filename\": \"" + calculationName + ".csv\"}";
-          }
+              // the other keys come after odTrips in the json document, written without its opening brace:
+              resultStr = json.dump(2);
+              streamedResult.write((odTripsRequest->odTripsResults->written() == 0 ? "]," : "\n  ],") + resultStr.substr(1));
+              resultStr.clear();
+            }
+            if (streamedResult.isSaving() && odTripsRequest->params.debugDisplay)
+            {
+              std::cerr << "writing " << query.fileFormat << " file" << std::endl;
+            }
+            *odTripsRequest->response << streamedResult.end();
+            
+            long long totalMicroseconds = odTripsRequest->calculationTime.getDurationMicrosecondsNoStop();
+            metrics.record(OdTripsRequestsHistogram, totalMicroseconds);
+            if (odTripsRequest->params.debugDisplay)
+            {
+              std::cerr << "-- od trips result -- " << streamedResult.size() << " bytes\n";
+              std::cerr << "-- total -- " << totalMicroseconds << " microseconds\n";
+            }
+            
+          });
         }
       }
-      else if (!calculator.params.alternatives)
+      else if (!calculator.params.alternatives && !cached)
       {
         resultStr = calculator.calculate().json;
+        recordCalculationMetrics(metrics, calculator);
+      }
+      
+      if (cacheable && !cached)
+      {
+        routingState->responseCache->put(routingState->networkVersion, cacheKey, resultStr);
       }
 
       //calculator.algorithmCalculationTime.stopStep();
@@ -1190,12 +1158,15 @@ int main(int argc, char** argv) {
       
       
       //calculator.algorithmCalculationTime.startStep();
-      if (saveToFile && fileFormat != "csv")
+      if (query.saveToFile && query.fileFormat != "csv" && !streamed)
       {
-        std::cerr << "writing json file" << std::endl;
+        if (calculator.params.debugDisplay)
+        {
+          std::cerr << "writing json file" << std::endl;
+        }
         std::ofstream jsonFile;
         //jsonFile.imbue(std::locale("en_US.UTF8"));
-        jsonFile.open(calculationName + ".json", std::ios_base::trunc);
+        jsonFile.open(query.calculationName + ".json", std::ios_base::trunc);
         jsonFile << resultStr;
         jsonFile.close();
       }
@@ -1204,15 +1175,34 @@ int main(int argc, char** argv) {
     else
     {
       resultStr = "{\"status\": \"failed\", \"error\": \"Wrong or malformed query\"}";
+      metrics.add(FailedQueriesCounter);
+    }
+    
+    if (streamed)
+    {
+      return; // ended (and measured) by the last od trips task
     }
     
-    std::cerr << "-- total -- " << calculator.algorithmCalculationTime.getDurationMicrosecondsNoStop() << " microseconds\n";
+    long long totalMicroseconds = calculator.algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    metrics.record(RouteRequestsHistogram, totalMicroseconds);
+    if (calculator.params.debugDisplay)
+    {
+      std::cerr << "-- total -- " << totalMicroseconds << " microseconds\n";
+      if (calculator.params.footpathsCache != NULL)
+      {
+        std::cerr << "-- footpaths cache -- " << calculator.params.footpathsCache->hits() << " hits, " << calculator.params.footpathsCache->misses() << " misses, " << calculator.params.footpathsCache->size() << " entries\n";
+      }
+      if (routingState->responseCache)
+      {
+        std::cerr << "-- response cache -- " << routingState->responseCache->hits() << " hits, " << routingState->responseCache->misses() << " misses, " << routingState->responseCache->evictions() << " evictions, " << routingState->responseCache->size() << " entries\n";
+      }
+    }
     
     //calculator.algorithmCalculationTime.stop();
       
     //std::cerr << "-- calculation time -- " << calculator.algorithmCalculationTime.getDurationMicroseconds() << " microseconds\n";
     
-    if (fileFormat == "csv")
+    if (query.fileFormat == "csv")
     {
       *response << "HTTP/1.1 200 OK\r\nContent-Type: application/csv; charset=utf-8\r\nContent-Length: " << csv.length() << "\r\n\r\n" << csv;
     }
@@ -1226,6 +1216,225 @@ int main(int argc, char** argv) {
   
   
   
+  // many queries in one request: a json array, or one json by line (ndjson), of query strings or objects with the parameters
+  // of /route/v1/transit. Queries are calculated in parallel by the calculation workers, each task with its own calculator and a pooled
+  // query context, and their results are streamed back in the same order and format (od trips are not calculated in batches):
+  server.resource["^/route/v1/transit/batch[/]?$"]["POST"]=[&routingStateHolder, &algorithmParams, &metrics, &calculationWorkers, batchThreads](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
+    
+    std::shared_ptr<BatchRequest> batchRequest = std::make_shared<BatchRequest>();
+    batchRequest->response     = response;
+    batchRequest->routingState = routingStateHolder.current();
+    std::vector<std::string> & queryStrings     = batchRequest->queryStrings;
+    std::vector<char>        & malformedQueries = batchRequest->malformedQueries;
+    bool                     & ndjson           = batchRequest->ndjson;
+    auto addQuery = [&queryStrings, &malformedQueries](const std::function<nlohmann::json()>& queryJson) {
+      try
+      {
+        queryStrings.push_back(RoutingQuery::queryString(queryJson()));
+        malformedQueries.push_back(0);
+      }
+      catch (const std::exception& exception)
+      {
+        std::cerr << "malformed batch query " << queryStrings.size() << ": " << exception.what() << std::endl;
+        queryStrings.push_back("");
+        malformedQueries.push_back(1);
+      }
+    };
+    
+    batchRequest->calculationTime.start();
+    try
+    {
+      std::string body = request->content.string();
+      size_t firstCharacterIndex = body.find_first_not_of(" \t\r\n");
+      ndjson = firstCharacterIndex == std::string::npos || body[firstCharacterIndex] != '[';
+      if (ndjson)
+      {
+        std::istringstream bodyLines(body);
+        std::string line;
+        while (std::getline(bodyLines, line))
+        {
+          if (line.find_first_not_of(" \t\r") != std::string::npos)
+          {
+            addQuery([&line]() { return nlohmann::json::parse(line); });
+          }
+        }
+      }
+      else
+      {
+        nlohmann::json queriesJson = nlohmann::json::parse(body);
+        for (auto & queryJson : queriesJson)
+        {
+          addQuery([&queryJson]() { return queryJson; });
+        }
+      }
+    }
+    catch (const std::exception& exception)
+    {
+      std::string resultStr = "{\"status\": \"failed\", \"error\": \"Wrong or malformed batch\"}";
+      std::cerr << "malformed batch: " << exception.what() << std::endl;
+      *response << "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << resultStr.length() << "\r\n\r\n" << resultStr;
+      return;
+    }
+    
+    int queriesCount      = queryStrings.size();
+    int batchTasksCount   = std::max(1, std::min(batchThreads, queriesCount));
+    if (algorithmParams.debugDisplay)
+    {
+      std::cout << "calculating a batch of " << queriesCount << " queries with " << batchTasksCount << " tasks" << std::endl;
+    }
+    
+    // results are sent in order while the next ones are calculated, stop calculating if the client is gone:
+    bool chunked = request->http_version >= "1.1";
+    response->close_connection_after_response = !chunked;
+    batchRequest->streamedResult.reset(new StreamedResult([response](const std::string& content) {
+      *response << content;
+      return HttpServer::Response::send_part(response);
+    }, chunked));
+    *response << "HTTP/1.1 200 OK\r\nContent-Type: application/" << (ndjson ? "x-ndjson" : "json") << "; charset=utf-8\r\n" << (chunked ? "Transfer-Encoding: chunked\r\n" : "Connection: close\r\n") << "\r\n";
+    if (!ndjson)
+    {
+      batchRequest->streamedResult->write("[");
+    }
+    BatchRequest * writtenBatchRequest = batchRequest.get(); // only written to while its tasks keep it
+    batchRequest->queriesResults.reset(new OrderedResults(queriesCount, [writtenBatchRequest](int queryIndex, const std::string& queryResult) {
+      StreamedResult & streamedResult = *writtenBatchRequest->streamedResult;
+      if (!writtenBatchRequest->ndjson)
+      {
+        streamedResult.write(queryIndex == 0 ? "\n" : ",\n");
+      }
+      streamedResult.write(queryResult);
+      if (!streamedResult.isSending() && writtenBatchRequest->nextQueryIndex < (int)writtenBatchRequest->queryStrings.size())
+      {
+        std::cerr << "client disconnected, batch calculation stopped" << std::endl;
+        writtenBatchRequest->nextQueryIndex = writtenBatchRequest->queryStrings.size();
+      }
+    }, [writtenBatchRequest]() {
+      writtenBatchRequest->streamedResult->flush();
+    }));
+    
+    // each task calculates the next query not taken yet, until there is none left:
+    batchRequest->runningTasksCount = batchTasksCount;
+    for (int taskIndex = 0; taskIndex < batchTasksCount; taskIndex++)
+    {
+      calculationWorkers.post([batchRequest, &algorithmParams, &metrics]() {
+        
+        const RoutingState & routingState = *batchRequest->routingState;
+        int          queriesCount = batchRequest->queryStrings.size();
+        Calculator   batchCalculator(routingState.network, routingState.workersContextPool->borrow(), algorithmParams);
+        RoutingQuery query;
+        std::string  queryResult;
+        int          queryIndex;
+        
+        batchCalculator.algorithmCalculationTime.start();
+        while ((queryIndex = batchRequest->nextQueryIndex++) < queriesCount)
+        {
+          const std::string & queryString = batchRequest->queryStrings[queryIndex];
+          batchCalculator.params                = algorithmParams;
+          batchCalculator.params.footpathsCache = routingState.footpathsCache.get();
+          query.reset(batchCalculator.params);
+          try
+          {
+            if (batchRequest->malformedQueries[queryIndex] || !query.parse(queryString.c_str(), queryString.c_str() + queryString.size(), batchCalculator.params) || query.calculateAllOdTrips || query.odTripId >= 0)
+            {
+              queryResult = "{\"status\": \"failed\", \"error\": \"Wrong or malformed query\"}";
+              metrics.add(FailedQueriesCounter);
+            }
+            else
+            {
+              // shares the entries of GET requests with the same parameters:
+              bool cacheable = routingState.responseCache && !query.saveToFile;
+              std::string cacheKey;
+              bool cached {false};
+              if (cacheable)
+              {
+                cacheKey = ResponseCache::normalizedQuery(queryString.c_str(), queryString.c_str() + queryString.size());
+                cached   = routingState.responseCache->get(routingState.networkVersion, cacheKey, queryResult);
+              }
+              if (!cached)
+              {
+                queryResult = batchCalculator.params.alternatives ? batchCalculator.alternativesCalculation(1).json : batchCalculator.calculate().json;
+                recordCalculationMetrics(metrics, batchCalculator);
+                if (cacheable)
+                {
+                  routingState.responseCache->put(routingState.networkVersion, cacheKey, queryResult);
+                }
+              }
+            }
+            if (batchRequest->ndjson) // one line by result
+            {
+              queryResult = nlohmann::json::parse(queryResult).dump() + "\n";
+            }
+          }
+          catch (const std::exception& exception)
+          {
+            std::cerr << "batch query " << queryIndex << " failed: " << exception.what() << std::endl;
+            metrics.add(FailedQueriesCounter);
+            queryResult = std::string("{\"status\": \"failed\", \"error\": \"Calculation failed\"}") + (batchRequest->ndjson ? "\n" : "");
+          }
+          batchRequest->queriesResults->set(queryIndex, queryResult);
+          batchRequest->response->wait_parts(maxUnsentResultsBytes);
+        }
+        
+        if (--batchRequest->runningTasksCount > 0)
+        {
+          return;
+        }
+        
+        // the last task to finish ends the response:
+        StreamedResult & streamedResult = *batchRequest->streamedResult;
+        if (!batchRequest->ndjson)
+        {
+          streamedResult.write(queriesCount == 0 ? "]\n" : "\n]\n");
+        }
+        *batchRequest->response << streamedResult.end();
+        
+        long long totalMicroseconds = batchRequest->calculationTime.getDurationMicrosecondsNoStop();
+        metrics.record(BatchRequestsHistogram, totalMicroseconds);
+        if (algorithmParams.debugDisplay)
+        {
+          std::cerr << "-- batch total -- " << totalMicroseconds << " microseconds for " << queriesCount << " queries\n";
+        }
+        
+      });
+    }
+    
+  };
+  
+  // latency histograms and counters in the prometheus text format, with the caches and network version:
+  server.resource["^/metrics[/]?$"]["GET"]=[&metrics, &routingStateHolder](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> /*request*/) {
+    
+    std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+    std::string resultStr = metrics.prometheusText();
+    std::vector<std::pair<std::string, std::pair<long long, long long>>> cachesHitsMisses;
+    if (routingState->footpathsCache)
+    {
+      cachesHitsMisses.push_back(std::make_pair("footpaths", std::make_pair(routingState->footpathsCache->hits(), routingState->footpathsCache->misses())));
+    }
+    if (routingState->responseCache)
+    {
+      cachesHitsMisses.push_back(std::make_pair("response", std::make_pair(routingState->responseCache->hits(), routingState->responseCache->misses())));
+    }
+    for (int i = 0; i < (int)cachesHitsMisses.size(); i++)
+    {
+      Metrics::appendMetric(resultStr, i == 0 ? "counter" : "", {"trrouting_cache_hits_total", "cache=\"" + cachesHitsMisses[i].first + "\"", "Lookups found in the cache."}, std::to_string(cachesHitsMisses[i].second.first));
+    }
+    for (int i = 0; i < (int)cachesHitsMisses.size(); i++)
+    {
+      Metrics::appendMetric(resultStr, i == 0 ? "counter" : "", {"trrouting_cache_misses_total", "cache=\"" + cachesHitsMisses[i].first + "\"", "Lookups not found in the cache."}, std::to_string(cachesHitsMisses[i].second.second));
+    }
+    if (routingState->footpathsCache)
+    {
+      Metrics::appendMetric(resultStr, "gauge", {"trrouting_cache_entries", "cache=\"footpaths\"", "Entries in the cache."}, std::to_string(routingState->footpathsCache->size()));
+    }
+    if (routingState->responseCache)
+    {
+      Metrics::appendMetric(resultStr, routingState->footpathsCache ? "" : "gauge", {"trrouting_cache_entries", "cache=\"response\"", "Entries in the cache."}, std::to_string(routingState->responseCache->size()));
+    }
+    Metrics::appendMetric(resultStr, "gauge", {"trrouting_network_version", "", "Version of the published network, incremented by each reload."}, std::to_string(routingState->networkVersion));
+    *response << "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " << resultStr.length() << "\r\n\r\n" << resultStr;
+    
+  };
+  
   std::cout << "starting server..." << std::endl;
   //server.start();
   std::thread server_thread([&server](){
@@ -1238,6 +1447,40 @@ int main(int argc, char** argv) {
   
   std::cout << "ready." << std::endl;
   
+  // reload the network when receiving SIGHUP:
+  std::thread([&reloadNetwork, reloadSignals](){
+    int signalNumber;
+    while (sigwait(&reloadSignals, &signalNumber) == 0)
+    {
+      if (!reloadNetwork())
+      {
+        std::cerr << "network already reloading, ignoring SIGHUP" << std::endl;
+      }
+    }
+  }).detach();
+  
+  // save the footpaths cache of the current network every minute when it changed:
+  if (footpathsCacheMb > 0 && footpathsCachePersist)
+  {
+    std::thread([&routingStateHolder, &dataShortname](){
+      std::shared_ptr<const RoutingState> routingState = routingStateHolder.current();
+      long long savedChangesCount = routingState->footpathsCache->changesCount();
+      while (true)
+      {
+        std::this_thread::sleep_for(std::chrono::seconds(60));
+        std::shared_ptr<const RoutingState> currentRoutingState = routingStateHolder.current();
+        if (currentRoutingState != routingState || currentRoutingState->footpathsCache->changesCount() != savedChangesCount)
+        {
+          routingState      = currentRoutingState;
+          savedChangesCount = routingState->footpathsCache->changesCount();
+          FootpathsCache::Snapshot footpathsSnapshot = routingState->footpathsCache->snapshot(FootpathsCache::stopsSignature(routingState->network->stops));
+          CacheFetcher::saveToCacheFile(dataShortname, footpathsSnapshot, "footpaths_cache");
+          std::cout << "saved " << footpathsSnapshot.second.size() << " cached footpaths (hits: " << routingState->footpathsCache->hits() << ", misses: " << routingState->footpathsCache->misses() << ")" << std::endl;
+        }
+      }
+    }).detach();
+  }
+  
   server_thread.join();
   
   //calculator.destroy();
@@ -0,0 +1,491 @@
+// trRoutingBench: replay a log of routing queries against a network loaded once, in process, and report throughput and
+// latencies by calculation phase, optionally compared with the report of a previous build.
+//
+// The log has one query by line (json lines): a query string, an object with a "query" (query string or parameters
+// object) or a "path" (/route/v1/transit?...), or directly the parameters object, as in batch requests.
+
+#include <boost/program_options.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+
+#include "json.hpp"
+#include "database_fetcher.hpp"
+#include "gtfs_fetcher.hpp"
+#include "csv_fetcher.hpp"
+#include "cache_fetcher.hpp"
+#include "calculation_time.hpp"
+#include "parameters.hpp"
+#include "calculator.hpp"
+#include "footpaths_cache.hpp"
+#include "perf_counters.hpp"
+#include "routing_query.hpp"
+
+using namespace TrRouting;
+
+int stepCount = 1;
+
+std::string consoleRed        = "";
+std::string consoleGreen      = "";
+std::string consoleYellow     = "";
+std::string consoleCyan       = "";
+std::string consoleMagenta    = "";
+std::string consoleResetColor = "";
+
+// durations in microseconds of the replayed queries, for the whole query and for each calculation phase:
+struct ReplayTimings {
+  std::vector<long long> queries;
+  std::vector<std::vector<long long>> phases {std::vector<std::vector<long long>>(Calculator::PHASES_COUNT)};
+  std::vector<std::vector<long long>> phasesHardwareEvents {std::vector<std::vector<long long>>(Calculator::PHASES_COUNT, std::vector<long long>(PerfCounters::EVENTS_COUNT, 0))}; // totals, with --hardwareCounters
+  int failedCount {0};
+  int skippedCount {0};
+};
+
+// nearest rank percentile of sorted durations:
+long long percentile(const std::vector<long long>& sortedDurations, double percent)
+{
+  if (sortedDurations.empty())
+  {
+    return 0;
+  }
+  size_t rank = (size_t)std::ceil(percent / 100.0 * sortedDurations.size());
+  return sortedDurations[std::max((size_t)1, std::min(rank, sortedDurations.size())) - 1];
+}
+
+nlohmann::json durationsJson(std::vector<long long>& durations)
+{
+  nlohmann::json json;
+  std::sort(durations.begin(), durations.end());
+  long long total {0};
+  for (long long duration : durations)
+  {
+    total += duration;
+  }
+  json["count"] = durations.size();
+  json["mean"]  = durations.empty() ? 0 : total / (long long)durations.size();
+  json["p50"]   = percentile(durations, 50);
+  json["p90"]   = percentile(durations, 90);
+  json["p99"]   = percentile(durations, 99);
+  json["max"]   = durations.empty() ? 0 : durations.back();
+  return json;
+}
+
+// query string of a line of the log, empty for blank lines:
+std::string replayedQueryString(const std::string& line)
+{
+  if (line.find_first_not_of(" \t\r") == std::string::npos)
+  {
+    return "";
+  }
+  nlohmann::json lineJson = nlohmann::json::parse(line);
+  if (lineJson.is_object() && lineJson.count("query") == 1)
+  {
+    return RoutingQuery::queryString(lineJson["query"]);
+  }
+  else if (lineJson.is_object() && lineJson.count("path") == 1)
+  {
+    std::string path = lineJson["path"].get<std::string>();
+    size_t queryStart = path.find('?');
+    return queryStart == std::string::npos ? "" : path.substr(queryStart + 1);
+  }
+  return RoutingQuery::queryString(lineJson);
+}
+
+int main(int argc, char** argv) {
+
+  std::string requestsFilePath {"requests.jsonl"};
+  std::string outputFilePath;
+  std::string baselineFilePath;
+  std::string dataFetcherStr {"cache"};
+  std::string dataShortname;
+  int threadsCount {1};
+  int repeatCount {1};
+  int warmupCount {0};
+  int footpathsCacheMb {0};
+  double tolerancePercent {10.0};
+  bool profileHardwareCounters {false};
+
+  Parameters algorithmParams;
+  algorithmParams.setDefaultValues();
+
+  boost::program_options::options_description optionsDesc("Options");
+  boost::program_options::variables_map variablesMap;
+  optionsDesc.add_options()
+      ("requests",         boost::program_options::value<std::string>(), "json lines file of the queries to replay (default: requests.jsonl)");
+  optionsDesc.add_options()
+      ("dataFetcher",      boost::program_options::value<std::string>(), "data fetcher (csv, database or cache, default: cache)");
+  optionsDesc.add_options()
+      ("dataShortname",    boost::program_options::value<std::string>(), "data shortname (shortname of the application to use)");
+  optionsDesc.add_options()
+      ("osrmWalkPort",     boost::program_options::value<std::string>(), "osrm walk port, for queries without access and egress stops");
+  optionsDesc.add_options()
+      ("threads",          boost::program_options::value<int>(), "number of threads replaying the queries, each with its own calculator (default: 1)");
+  optionsDesc.add_options()
+      ("repeat",           boost::program_options::value<int>(), "number of times the whole log is replayed (default: 1)");
+  optionsDesc.add_options()
+      ("warmup",           boost::program_options::value<int>(), "number of queries calculated before measuring, by each thread (default: 0)");
+  optionsDesc.add_options()
+      ("footpathsCacheMb", boost::program_options::value<int>(), "memory limit in MB of the access/egress footpaths cache (default 0: no cache)");
+  optionsDesc.add_options()
+      ("output",           boost::program_options::value<std::string>(), "save the report to this json file");
+  optionsDesc.add_options()
+      ("baseline",         boost::program_options::value<std::string>(), "json report of a previous build: exit with status 1 if a latency percentile is slower by more than the tolerance");
+  optionsDesc.add_options()
+      ("tolerance",        boost::program_options::value<double>(), "percent of slowdown allowed compared with the baseline (default: 10)");
+  optionsDesc.add_options()
+      ("hardwareCounters", boost::program_options::value<int>(), "also report cpu cycles, instructions, llc misses and branch misses by query for each phase (1 or 0, default 0, linux only)");
+
+  boost::program_options::store(boost::program_options::parse_command_line(argc, argv, optionsDesc), variablesMap);
+
+  if(variablesMap.count("requests") == 1)
+  {
+    requestsFilePath = variablesMap["requests"].as<std::string>();
+  }
+  if(variablesMap.count("dataFetcher") == 1)
+  {
+    dataFetcherStr = variablesMap["dataFetcher"].as<std::string>();
+  }
+  if(variablesMap.count("dataShortname") == 1)
+  {
+    dataShortname = variablesMap["dataShortname"].as<std::string>();
+  }
+  if(variablesMap.count("osrmWalkPort") == 1)
+  {
+    algorithmParams.osrmRoutingWalkingPort = variablesMap["osrmWalkPort"].as<std::string>();
+  }
+  if(variablesMap.count("threads") == 1)
+  {
+    threadsCount = std::max(1, variablesMap["threads"].as<int>());
+  }
+  if(variablesMap.count("repeat") == 1)
+  {
+    repeatCount = std::max(1, variablesMap["repeat"].as<int>());
+  }
+  if(variablesMap.count("warmup") == 1)
+  {
+    warmupCount = std::max(0, variablesMap["warmup"].as<int>());
+  }
+  if(variablesMap.count("footpathsCacheMb") == 1)
+  {
+    footpathsCacheMb = std::max(0, variablesMap["footpathsCacheMb"].as<int>());
+  }
+  if(variablesMap.count("output") == 1)
+  {
+    outputFilePath = variablesMap["output"].as<std::string>();
+  }
+  if(variablesMap.count("baseline") == 1)
+  {
+    baselineFilePath = variablesMap["baseline"].as<std::string>();
+  }
+  if(variablesMap.count("tolerance") == 1)
+  {
+    tolerancePercent = std::max(0.0, variablesMap["tolerance"].as<double>());
+  }
+  if(variablesMap.count("hardwareCounters") == 1)
+  {
+    profileHardwareCounters = variablesMap["hardwareCounters"].as<int>() == 1;
+  }
+
+  // read the whole log before loading the network, so a malformed log fails fast:
+  std::vector<std::string> queryStrings;
+  std::ifstream requestsFile(requestsFilePath);
+  if (!requestsFile.is_open())
+  {
+    std::cerr << "could not open requests file " << requestsFilePath << std::endl;
+    return 1;
+  }
+  std::string line;
+  int lineNumber {0};
+  while (std::getline(requestsFile, line))
+  {
+    lineNumber++;
+    try
+    {
+      std::string queryString = replayedQueryString(line);
+      if (!queryString.empty())
+      {
+        queryStrings.push_back(queryString);
+      }
+    }
+    catch (const std::exception& exception)
+    {
+      std::cerr << "ignoring line " << lineNumber << " of " << requestsFilePath << ": " << exception.what() << std::endl;
+    }
+  }
+  if (queryStrings.empty())
+  {
+    std::cerr << "no query to replay in " << requestsFilePath << std::endl;
+    return 1;
+  }
+
+  std::cout << "Using requests file "  << requestsFilePath << " (" << queryStrings.size() << " queries)" << std::endl;
+  std::cout << "Using data fetcher "   << dataFetcherStr << std::endl;
+  std::cout << "Using data shortname " << dataShortname << std::endl;
+  std::cout << "Using threads "        << threadsCount << std::endl;
+  std::cout << "Using repeat "         << repeatCount << std::endl;
+  std::cout << "Using warmup "         << warmupCount << std::endl;
+  std::cout << "Using footpaths cache MB " << footpathsCacheMb << std::endl;
+  std::cout << "Using hardware counters " << (profileHardwareCounters ? 1 : 0) << std::endl;
+  if (profileHardwareCounters && !PerfCounters::ofThisThread().available())
+  {
+    std::cerr << "hardware counters are not available, only durations will be reported (" << PerfCounters::ofThisThread().unavailableReason() << ")" << std::endl;
+    profileHardwareCounters = false;
+  }
+
+  algorithmParams.applicationShortname    = dataShortname;
+  algorithmParams.profileHardwareCounters = profileHardwareCounters;
+  algorithmParams.dataFetcherShortname = dataFetcherStr;
+
+  DatabaseFetcher databaseFetcher;
+  if (dataFetcherStr == "database")
+  {
+    databaseFetcher = DatabaseFetcher("dbname=" + algorithmParams.databaseName + " user=" + algorithmParams.databaseUser + " hostaddr=" + algorithmParams.databaseHost + " port=" + algorithmParams.databasePort + "");
+  }
+  algorithmParams.databaseFetcher = &databaseFetcher;
+  GtfsFetcher gtfsFetcher         = GtfsFetcher();
+  algorithmParams.gtfsFetcher     = &gtfsFetcher;
+  CsvFetcher csvFetcher           = CsvFetcher();
+  algorithmParams.csvFetcher      = &csvFetcher;
+  CacheFetcher cacheFetcher       = CacheFetcher();
+  algorithmParams.cacheFetcher    = &cacheFetcher;
+
+  CalculationTime loadTime;
+  loadTime.start();
+  std::cout << "preparing network..." << std::endl;
+  std::shared_ptr<const TransitNetwork> network = std::make_shared<const TransitNetwork>(algorithmParams);
+  std::shared_ptr<FootpathsCache> footpathsCache;
+  if (footpathsCacheMb > 0)
+  {
+    footpathsCache = std::make_shared<FootpathsCache>((long long)footpathsCacheMb * 1024 * 1024);
+  }
+  std::cout << "network loaded (" << network->forwardConnections.size() << " connections) in " << loadTime.getDurationMicrosecondsNoStop() / 1000 << " ms" << std::endl;
+
+  // each thread replays the whole log (repeatCount times), starting at a different query so threads do not calculate
+  // the same query at the same time:
+  std::vector<ReplayTimings> threadsTimings(threadsCount);
+  std::vector<std::thread>   replayThreads;
+  std::atomic<int>           readyThreadsCount {0};
+  std::atomic<bool>          start {false};
+  std::chrono::steady_clock::time_point replayStart, replayEnd;
+  for (int threadIndex = 0; threadIndex < threadsCount; threadIndex++)
+  {
+    replayThreads.push_back(std::thread([&, threadIndex]() {
+      Calculator   calculator(network, std::make_shared<QueryContext>(*network), algorithmParams);
+      RoutingQuery query;
+      ReplayTimings & timings = threadsTimings[threadIndex];
+      int queriesCount = queryStrings.size();
+      int offset       = (long long)threadIndex * queriesCount / threadsCount;
+
+      auto replay = [&](const std::string& queryString, bool measured) {
+        calculator.params                = algorithmParams;
+        calculator.params.footpathsCache = footpathsCache.get();
+        query.reset(calculator.params);
+        auto queryStart = std::chrono::steady_clock::now();
+        calculator.algorithmCalculationTime.start();
+        if (!query.parse(queryString.c_str(), queryString.c_str() + queryString.size(), calculator.params) || query.calculateAllOdTrips || query.odTripId >= 0)
+        {
+          if (measured)
+          {
+            timings.skippedCount++;
+          }
+          return;
+        }
+        try
+        {
+          RoutingResult result = calculator.params.alternatives ? calculator.alternativesCalculation(1) : calculator.calculate();
+          if (!measured)
+          {
+            return;
+          }
+          timings.queries.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queryStart).count());
+          for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
+          {
+            if (calculator.phasesDurationsMicroseconds[phase] >= 0)
+            {
+              timings.phases[phase].push_back(calculator.phasesDurationsMicroseconds[phase]);
+            }
+            for (int event = 0; profileHardwareCounters && event < PerfCounters::EVENTS_COUNT; event++)
+            {
+              timings.phasesHardwareEvents[phase][event] += std::max(0LL, calculator.phasesHardwareCounters[phase][event]);
+            }
+          }
+        }
+        catch (const std::exception& exception)
+        {
+          if (measured)
+          {
+            timings.failedCount++;
+          }
+        }
+      };
+
+      for (int i = 0; i < warmupCount; i++)
+      {
+        replay(queryStrings[(offset + i) % queriesCount], false);
+      }
+      readyThreadsCount++;
+      while (!start)
+      {
+        std::this_thread::yield();
+      }
+      for (int repeat = 0; repeat < repeatCount; repeat++)
+      {
+        for (int i = 0; i < queriesCount; i++)
+        {
+          replay(queryStrings[(offset + i) % queriesCount], true);
+        }
+      }
+    }));
+  }
+  while (readyThreadsCount < threadsCount)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::cout << "replaying..." << std::endl;
+  replayStart = std::chrono::steady_clock::now();
+  start = true;
+  for (auto & replayThread : replayThreads)
+  {
+    replayThread.join();
+  }
+  replayEnd = std::chrono::steady_clock::now();
+
+  ReplayTimings timings;
+  for (auto & threadTimings : threadsTimings)
+  {
+    timings.queries.insert(timings.queries.end(), threadTimings.queries.begin(), threadTimings.queries.end());
+    for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
+    {
+      timings.phases[phase].insert(timings.phases[phase].end(), threadTimings.phases[phase].begin(), threadTimings.phases[phase].end());
+      for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+      {
+        timings.phasesHardwareEvents[phase][event] += threadTimings.phasesHardwareEvents[phase][event];
+      }
+    }
+    timings.failedCount  += threadTimings.failedCount;
+    timings.skippedCount += threadTimings.skippedCount;
+  }
+
+  double replaySeconds = std::chrono::duration_cast<std::chrono::microseconds>(replayEnd - replayStart).count() / 1000000.0;
+  nlohmann::json report;
+  report["threads"]          = threadsCount;
+  report["calculatedCount"]  = timings.queries.size();
+  report["failedCount"]      = timings.failedCount;
+  report["skippedCount"]     = timings.skippedCount;
+  report["durationSeconds"]  = replaySeconds;
+  report["queriesPerSecond"] = replaySeconds > 0 ? timings.queries.size() / replaySeconds : 0.0;
+  report["latency"]          = durationsJson(timings.queries);
+  struct rusage resourceUsage;
+  getrusage(RUSAGE_SELF, &resourceUsage);
+  report["maxResidentMemoryMb"] = resourceUsage.ru_maxrss / 1024; // network, contexts and caches (ru_maxrss is in KB on linux)
+  for (int phase = 0; phase < Calculator::PHASES_COUNT; phase++)
+  {
+    if (!timings.phases[phase].empty()) // only the phases used by the replayed queries
+    {
+      report["phases"][Calculator::phaseName(phase)] = durationsJson(timings.phases[phase]);
+    }
+  }
+  // mean events by query running the phase, and instructions per cycle:
+  for (int phase = 0; profileHardwareCounters && phase < Calculator::PHASES_COUNT; phase++)
+  {
+    if (!timings.phases[phase].empty())
+    {
+      nlohmann::json phaseEvents;
+      for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+      {
+        phaseEvents[PerfCounters::eventName(event)] = timings.phasesHardwareEvents[phase][event] / (long long)timings.phases[phase].size();
+      }
+      long long cycles = timings.phasesHardwareEvents[phase][PerfCounters::CYCLES];
+      phaseEvents["instructionsPerCycle"] = cycles > 0 ? (double)timings.phasesHardwareEvents[phase][PerfCounters::INSTRUCTIONS] / cycles : 0.0;
+      report["hardwareCounters"][Calculator::phaseName(phase)] = phaseEvents;
+    }
+  }
+
+  std::cout << std::endl << timings.queries.size() << " queries calculated, " << timings.failedCount << " failed, " << timings.skippedCount << " skipped (malformed or od trips)" << std::endl;
+  std::cout << "throughput: " << std::fixed << std::setprecision(1) << report["queriesPerSecond"].get<double>() << " queries/s (" << replaySeconds << " s)" << std::endl;
+  std::cout << "max resident memory: " << report["maxResidentMemoryMb"].get<long>() << " MB" << std::endl << std::endl;
+  std::cout << std::left << std::setw(14) << "microseconds" << std::right << std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+  auto printDurations = [](const std::string& name, const nlohmann::json& durations) {
+    std::cout << std::left << std::setw(14) << name << std::right;
+    for (auto key : {"count", "mean", "p50", "p90", "p99", "max"})
+    {
+      std::cout << std::setw(10) << durations[key].get<long long>();
+    }
+    std::cout << std::endl;
+  };
+  printDurations("query", report["latency"]);
+  if (report.count("phases") == 1)
+  {
+    for (auto phase = report["phases"].begin(); phase != report["phases"].end(); phase++)
+    {
+      printDurations(phase.key(), phase.value());
+    }
+  }
+  if (report.count("hardwareCounters") == 1)
+  {
+    std::cout << std::endl << std::left << std::setw(14) << "by query" << std::right;
+    for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+    {
+      std::cout << std::setw(14) << PerfCounters::eventName(event);
+    }
+    std::cout << std::setw(14) << "ipc" << std::endl;
+    for (auto phase = report["hardwareCounters"].begin(); phase != report["hardwareCounters"].end(); phase++)
+    {
+      std::cout << std::left << std::setw(14) << phase.key() << std::right;
+      for (int event = 0; event < PerfCounters::EVENTS_COUNT; event++)
+      {
+        std::cout << std::setw(14) << phase.value()[PerfCounters::eventName(event)].get<long long>();
+      }
+      std::cout << std::setw(14) << std::setprecision(2) << phase.value()["instructionsPerCycle"].get<double>() << std::endl;
+    }
+  }
+
+  if (!outputFilePath.empty())
+  {
+    std::ofstream outputFile(outputFilePath, std::ios_base::trunc);
+    outputFile << report.dump(2) << std::endl;
+    std::cout << std::endl << "report saved to " << outputFilePath << std::endl;
+  }
+
+  int exitStatus {0};
+  if (!baselineFilePath.empty())
+  {
+    nlohmann::json baseline;
+    try
+    {
+      std::ifstream baselineFile(baselineFilePath);
+      baselineFile >> baseline;
+    }
+    catch (const std::exception& exception)
+    {
+      std::cerr << "could not read baseline " << baselineFilePath << ": " << exception.what() << std::endl;
+      return 1;
+    }
+    std::cout << std::endl << "compared with " << baselineFilePath << " (tolerance " << tolerancePercent << "%):" << std::endl;
+    for (auto key : {"p50", "p90", "p99"})
+    {
+      long long baselineLatency = baseline["latency"][key].get<long long>();
+      long long latency         = report["latency"][key].get<long long>();
+      double    changePercent   = baselineLatency > 0 ? 100.0 * (latency - baselineLatency) / baselineLatency : 0.0;
+      bool      regression      = changePercent > tolerancePercent;
+      std::cout << "  " << key << " " << baselineLatency << " -> " << latency << " microseconds (" << std::showpos << changePercent << std::noshowpos << "%)" << (regression ? " REGRESSION" : "") << std::endl;
+      if (regression)
+      {
+        exitStatus = 1;
+      }
+    }
+  }
+
+  return exitStatus;
+
+}
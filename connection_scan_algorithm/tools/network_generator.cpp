@@ -0,0 +1,363 @@
+// trRoutingGenerator: write a synthetic network as the .cache files read by the cache data fetcher, so benchmarks can
+// be run and reproduced without a database or private data.
+//
+// Stops are on a grid (slightly jittered), lines run along rows and columns of the grid in both directions, with a
+// headway by line over the service span, and footpaths join the stops within a walking radius. The same options and
+// seed always write the same network (only the mt19937 output is used, never the distributions of the standard library,
+// which differ between implementations).
+//
+// Trips run every day of the two weeks around the reference date (monday 2020-01-06), so benchmark queries must set a
+// date in that span, like date=2020/01/06, or no date at all.
+
+#include <boost/program_options.hpp>
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <string>
+#include <iostream>
+#include <math.h>
+
+#include "stop.hpp"
+#include "route.hpp"
+#include "trip.hpp"
+#include "service.hpp"
+#include "od_trip.hpp"
+#include "point.hpp"
+#include "stop_table.hpp"
+#include "stops_spatial_index.hpp"
+#include "connection_table.hpp"
+#include "cache_fetcher.hpp"
+
+using namespace TrRouting;
+
+const double walkingSpeedMetersPerSecond {1.38}; // same as the footpaths fetched from the database
+const int    dwellTimeSeconds            {20};
+
+// integer between min and max (included):
+int randomInt(std::mt19937& randomGenerator, int min, int max)
+{
+  return min + (int)(randomGenerator() % (unsigned int)(max - min + 1));
+}
+
+float distanceMeters(const Point& pointA, const Point& pointB)
+{
+  double middleLatitude = (pointA.latitude + pointB.latitude) / 2;
+  float  distanceX      = (pointB.longitude - pointA.longitude) * StopsSpatialIndex::lengthOfOneDegreeOfLongitude(middleLatitude);
+  float  distanceY      = (pointB.latitude  - pointA.latitude)  * StopsSpatialIndex::lengthOfOneDegreeOfLatitude(middleLatitude);
+  return sqrt(distanceX * distanceX + distanceY * distanceY);
+}
+
+int main(int argc, char** argv) {
+
+  std::string dataShortname {"synthetic"};
+  int   stopsCount            {10000};
+  int   linesCount            {-1}; // default: stopsCount / 20
+  int   lineStopsCount        {30};
+  int   stopSpacingMeters     {400};
+  int   minHeadwayMinutes     {5};
+  int   maxHeadwayMinutes     {20};
+  int   serviceStartHour      {5};
+  int   serviceEndHour        {24};
+  int   footpathsRadiusMeters {400};
+  int   speedKmH              {25};
+  int   odTripsCount          {1000};
+  int   seed                  {1};
+
+  boost::program_options::options_description optionsDesc("Options");
+  boost::program_options::variables_map variablesMap;
+  optionsDesc.add_options()
+      ("dataShortname",   boost::program_options::value<std::string>(), "shortname of the written cache files (default: synthetic)");
+  optionsDesc.add_options()
+      ("stops",           boost::program_options::value<int>(), "number of stops (default: 10000)");
+  optionsDesc.add_options()
+      ("lines",           boost::program_options::value<int>(), "number of lines, each with trips in both directions (default: stops / 20)");
+  optionsDesc.add_options()
+      ("lineStops",       boost::program_options::value<int>(), "number of stops of each line (default: 30)");
+  optionsDesc.add_options()
+      ("stopSpacing",     boost::program_options::value<int>(), "distance between neighbour stops of the grid in meters (default: 400)");
+  optionsDesc.add_options()
+      ("minHeadway",      boost::program_options::value<int>(), "minimum headway of a line in minutes (default: 5)");
+  optionsDesc.add_options()
+      ("maxHeadway",      boost::program_options::value<int>(), "maximum headway of a line in minutes (default: 20)");
+  optionsDesc.add_options()
+      ("serviceStart",    boost::program_options::value<int>(), "hour of the first departures (default: 5)");
+  optionsDesc.add_options()
+      ("serviceEnd",      boost::program_options::value<int>(), "hour after which no trip departs (default: 24)");
+  optionsDesc.add_options()
+      ("footpathsRadius", boost::program_options::value<int>(), "stops within this bird distance in meters are joined by footpaths (default: 400)");
+  optionsDesc.add_options()
+      ("speed",           boost::program_options::value<int>(), "speed of vehicles between stops in km/h (default: 25)");
+  optionsDesc.add_options()
+      ("odTrips",         boost::program_options::value<int>(), "number of od trips (default: 1000)");
+  optionsDesc.add_options()
+      ("seed",            boost::program_options::value<int>(), "seed of the random generator (default: 1)");
+
+  boost::program_options::store(boost::program_options::parse_command_line(argc, argv, optionsDesc), variablesMap);
+
+  if(variablesMap.count("dataShortname") == 1)
+  {
+    dataShortname = variablesMap["dataShortname"].as<std::string>();
+  }
+  if(variablesMap.count("stops") == 1)
+  {
+    stopsCount = std::max(4, variablesMap["stops"].as<int>());
+  }
+  if(variablesMap.count("lines") == 1)
+  {
+    linesCount = std::max(1, variablesMap["lines"].as<int>());
+  }
+  if(variablesMap.count("lineStops") == 1)
+  {
+    lineStopsCount = std::max(2, variablesMap["lineStops"].as<int>());
+  }
+  if(variablesMap.count("stopSpacing") == 1)
+  {
+    stopSpacingMeters = std::max(1, variablesMap["stopSpacing"].as<int>());
+  }
+  if(variablesMap.count("minHeadway") == 1)
+  {
+    minHeadwayMinutes = std::max(1, variablesMap["minHeadway"].as<int>());
+  }
+  if(variablesMap.count("maxHeadway") == 1)
+  {
+    maxHeadwayMinutes = variablesMap["maxHeadway"].as<int>();
+  }
+  if(variablesMap.count("serviceStart") == 1)
+  {
+    serviceStartHour = std::max(0, variablesMap["serviceStart"].as<int>());
+  }
+  if(variablesMap.count("serviceEnd") == 1)
+  {
+    serviceEndHour = variablesMap["serviceEnd"].as<int>();
+  }
+  if(variablesMap.count("footpathsRadius") == 1)
+  {
+    footpathsRadiusMeters = std::max(0, variablesMap["footpathsRadius"].as<int>());
+  }
+  if(variablesMap.count("speed") == 1)
+  {
+    speedKmH = std::max(1, variablesMap["speed"].as<int>());
+  }
+  if(variablesMap.count("odTrips") == 1)
+  {
+    odTripsCount = std::max(0, variablesMap["odTrips"].as<int>());
+  }
+  if(variablesMap.count("seed") == 1)
+  {
+    seed = variablesMap["seed"].as<int>();
+  }
+  if (linesCount < 0)
+  {
+    linesCount = std::max(1, stopsCount / 20);
+  }
+  maxHeadwayMinutes = std::max(minHeadwayMinutes, maxHeadwayMinutes);
+  serviceEndHour    = std::max(serviceStartHour + 1, serviceEndHour);
+
+  std::cout << "Using data shortname "    << dataShortname << std::endl;
+  std::cout << "Using stops "             << stopsCount << " (spacing " << stopSpacingMeters << " m)" << std::endl;
+  std::cout << "Using lines "             << linesCount << " (" << lineStopsCount << " stops, " << speedKmH << " km/h)" << std::endl;
+  std::cout << "Using headways "          << minHeadwayMinutes << " to " << maxHeadwayMinutes << " minutes from " << serviceStartHour << ":00 to " << serviceEndHour << ":00" << std::endl;
+  std::cout << "Using footpaths radius "  << footpathsRadiusMeters << " m" << std::endl;
+  std::cout << "Using od trips "          << odTripsCount << std::endl;
+  std::cout << "Using seed "              << seed << std::endl;
+
+  std::mt19937 randomGenerator(seed);
+
+  // stops, by rows of the grid:
+  int    columnsCount     = (int)ceil(sqrt((double)stopsCount));
+  int    fullRowsCount    = stopsCount / columnsCount;
+  double originLatitude   {45.5};
+  double originLongitude  {-73.6};
+  double metersLatitude   = 1.0 / StopsSpatialIndex::lengthOfOneDegreeOfLatitude(originLatitude);
+  double metersLongitude  = 1.0 / StopsSpatialIndex::lengthOfOneDegreeOfLongitude(originLatitude);
+  std::vector<Stop>                 stops(stopsCount);
+  std::map<unsigned long long, int> stopIndexesById;
+  for (int stopIndex = 0; stopIndex < stopsCount; stopIndex++)
+  {
+    Stop & stop = stops[stopIndex];
+    int row     = stopIndex / columnsCount;
+    int column  = stopIndex % columnsCount;
+    stop.id        = stopIndex + 1;
+    stop.code      = std::to_string(stop.id);
+    stop.name      = "Stop " + std::to_string(row) + "-" + std::to_string(column);
+    stop.stationId = -1;
+    stop.point     = Point(
+      originLatitude  + (row    * stopSpacingMeters + randomInt(randomGenerator, -stopSpacingMeters / 4, stopSpacingMeters / 4)) * metersLatitude,
+      originLongitude + (column * stopSpacingMeters + randomInt(randomGenerator, -stopSpacingMeters / 4, stopSpacingMeters / 4)) * metersLongitude
+    );
+    stopIndexesById[stop.id] = stopIndex;
+  }
+
+  // one service running every day, from the week before the reference date to the week after it:
+  std::vector<Service>              services(1);
+  std::map<unsigned long long, int> serviceIndexesById {{1, 0}};
+  services[0].id        = 1;
+  services[0].monday    = services[0].tuesday = services[0].wednesday = services[0].thursday = services[0].friday = services[0].saturday = services[0].sunday = true;
+  services[0].startDate = 20191230;
+  services[0].endDate   = 20200112;
+
+  // lines along a row or a column, trips in both directions with the same travel times:
+  std::vector<Route>                routes(linesCount);
+  std::map<unsigned long long, int> routeIndexesById;
+  std::vector<Trip>                 trips;
+  std::map<unsigned long long, int> tripIndexesById;
+  std::vector<ConnectionTuple>      connections;
+  for (int lineIndex = 0; lineIndex < linesCount; lineIndex++)
+  {
+    Route & route = routes[lineIndex];
+    route.id            = lineIndex + 1;
+    route.agencyId      = 1 + lineIndex % 2;
+    route.routeTypeId   = lineIndex % 10 == 0 ? 2 : 3;
+    route.agencyAcronym = route.agencyId == 1 ? "SYA" : "SYB";
+    route.agencyName    = route.agencyId == 1 ? "Synthetic A" : "Synthetic B";
+    route.shortname     = std::to_string(route.id);
+    route.longname      = "Line " + std::to_string(route.id);
+    route.routeTypeName = route.routeTypeId == 2 ? "tram" : "bus";
+    routeIndexesById[route.id] = lineIndex;
+
+    bool horizontal       = randomInt(randomGenerator, 0, 1) == 0 || fullRowsCount < 2;
+    int  lineLength       = std::min(lineStopsCount, horizontal ? columnsCount : fullRowsCount);
+    int  gridLine         = randomInt(randomGenerator, 0, (horizontal ? fullRowsCount : columnsCount) - 1);
+    int  firstGridStop    = randomInt(randomGenerator, 0, (horizontal ? columnsCount : fullRowsCount) - lineLength);
+    std::vector<int> lineStopIndexes;
+    for (int i = 0; i < lineLength; i++)
+    {
+      lineStopIndexes.push_back(horizontal ? gridLine * columnsCount + firstGridStop + i : (firstGridStop + i) * columnsCount + gridLine);
+    }
+    std::vector<int> travelTimesSeconds;
+    for (int i = 0; i + 1 < lineLength; i++)
+    {
+      float seconds = distanceMeters(stops[lineStopIndexes[i]].point, stops[lineStopIndexes[i + 1]].point) * 3.6 / speedKmH;
+      travelTimesSeconds.push_back(std::max(30, (int)(seconds * randomInt(randomGenerator, 85, 115) / 100)));
+    }
+
+    int headwaySeconds = randomInt(randomGenerator, minHeadwayMinutes, maxHeadwayMinutes) * 60;
+    for (int direction = 0; direction < 2; direction++)
+    {
+      for (int departureTimeSeconds = serviceStartHour * 3600 + randomInt(randomGenerator, 0, headwaySeconds - 1); departureTimeSeconds < serviceEndHour * 3600; departureTimeSeconds += headwaySeconds)
+      {
+        Trip trip;
+        trip.id          = trips.size() + 1;
+        trip.routeId     = route.id;
+        trip.routePathId = route.id * 2 + direction;
+        trip.routeTypeId = route.routeTypeId;
+        trip.agencyId    = route.agencyId;
+        trip.serviceId   = 1;
+        tripIndexesById[trip.id] = trips.size();
+        trips.push_back(trip);
+
+        int timeSeconds = departureTimeSeconds;
+        for (int sequence = 1; sequence < lineLength; sequence++)
+        {
+          int segment = direction == 0 ? sequence - 1 : lineLength - 1 - sequence;
+          int arrivalTimeSeconds = timeSeconds + travelTimesSeconds[segment];
+          connections.push_back(ConnectionTuple(
+            lineStopIndexes[direction == 0 ? segment     : segment + 1],
+            lineStopIndexes[direction == 0 ? segment + 1 : segment],
+            timeSeconds, arrivalTimeSeconds, trips.size() - 1, 1, 1, sequence
+          )); // departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
+          timeSeconds = arrivalTimeSeconds + dwellTimeSeconds;
+        }
+      }
+    }
+  }
+
+  // same orders as the connections fetched from the database: forward by departure time, trip and sequence, reverse
+  // by arrival time, trip and sequence, all descending:
+  std::sort(connections.begin(), connections.end(), [](const ConnectionTuple& connectionA, const ConnectionTuple& connectionB) {
+    return std::make_tuple(std::get<2>(connectionA), std::get<4>(connectionA), std::get<7>(connectionA)) < std::make_tuple(std::get<2>(connectionB), std::get<4>(connectionB), std::get<7>(connectionB));
+  });
+  std::vector<ConnectionTuple> reverseConnections(connections);
+  std::sort(reverseConnections.begin(), reverseConnections.end(), [](const ConnectionTuple& connectionA, const ConnectionTuple& connectionB) {
+    return std::make_tuple(std::get<3>(connectionA), std::get<4>(connectionA), std::get<7>(connectionA)) > std::make_tuple(std::get<3>(connectionB), std::get<4>(connectionB), std::get<7>(connectionB));
+  });
+
+  // footpaths by stop (the stop itself included), sorted by travel time:
+  StopTable                            stopTable = StopTable::fromStops(stops);
+  StopsSpatialIndex                    stopsSpatialIndex(stopTable);
+  std::vector<std::tuple<int,int,int>> footpaths;
+  std::vector<std::pair<int,int>>      footpathsRanges(stopsCount);
+  std::vector<std::pair<int,int>>      stopFootpaths; // travel time, stop index
+  for (int stopIndex = 0; stopIndex < stopsCount; stopIndex++)
+  {
+    stopFootpaths.clear();
+    for (int aroundStopIndex : stopsSpatialIndex.getStopIndexesAround(stops[stopIndex].point, footpathsRadiusMeters))
+    {
+      stopFootpaths.push_back(std::make_pair((int)ceil(distanceMeters(stops[stopIndex].point, stops[aroundStopIndex].point) / walkingSpeedMetersPerSecond), aroundStopIndex));
+    }
+    if (stopFootpaths.empty()) // radius 0
+    {
+      stopFootpaths.push_back(std::make_pair(0, stopIndex));
+    }
+    std::sort(stopFootpaths.begin(), stopFootpaths.end());
+    footpathsRanges[stopIndex].first = footpaths.size();
+    for (auto & stopFootpath : stopFootpaths)
+    {
+      footpaths.push_back(std::make_tuple(stopIndex, stopFootpath.second, stopFootpath.first));
+    }
+    footpathsRanges[stopIndex].second = footpaths.size() - 1;
+  }
+
+  // od trips between random stops, accessing and leaving the network by the footpaths of these stops:
+  std::vector<std::string>          ageGroups   {"ag0-14", "ag15-24", "ag25-44", "ag45-64", "ag65+"};
+  std::vector<std::string>          genders     {"female", "male"};
+  std::vector<std::string>          occupations {"fullTimeWorker", "partTimeWorker", "student", "retired", "other"};
+  std::vector<std::string>          activities  {"workUsual", "schoolUsual", "shopping", "leisure", "other"};
+  std::vector<OdTrip>               odTrips(odTripsCount);
+  std::map<unsigned long long, int> odTripIndexesById;
+  for (int odTripIndex = 0; odTripIndex < odTripsCount; odTripIndex++)
+  {
+    OdTrip & odTrip = odTrips[odTripIndex];
+    int originStopIndex      = randomInt(randomGenerator, 0, stopsCount - 1);
+    int destinationStopIndex = randomInt(randomGenerator, 0, stopsCount - 1);
+    odTrip.id                       = odTripIndex + 1;
+    odTrip.personId                 = odTripIndex + 1;
+    odTrip.householdId              = odTripIndex / 2 + 1;
+    odTrip.age                      = randomInt(randomGenerator, 5, 85);
+    odTrip.departureTimeSeconds     = randomInt(randomGenerator, serviceStartHour * 3600, serviceEndHour * 3600 - 1);
+    odTrip.walkingTravelTimeSeconds = -1;
+    odTrip.cyclingTravelTimeSeconds = -1;
+    odTrip.drivingTravelTimeSeconds = -1;
+    odTrip.expansionFactor          = 1.0;
+    odTrip.ageGroup                 = ageGroups[randomInt(randomGenerator, 0, ageGroups.size() - 1)];
+    odTrip.gender                   = genders[randomInt(randomGenerator, 0, genders.size() - 1)];
+    odTrip.mode                     = "transit";
+    odTrip.occupation               = occupations[randomInt(randomGenerator, 0, occupations.size() - 1)];
+    odTrip.activity                 = activities[randomInt(randomGenerator, 0, activities.size() - 1)];
+    odTrip.origin                   = stops[originStopIndex].point;
+    odTrip.destination              = stops[destinationStopIndex].point;
+    for (int i = footpathsRanges[originStopIndex].first; i <= footpathsRanges[originStopIndex].second; i++)
+    {
+      odTrip.accessFootpaths.push_back(std::make_pair(std::get<1>(footpaths[i]), std::get<2>(footpaths[i])));
+    }
+    for (int i = footpathsRanges[destinationStopIndex].first; i <= footpathsRanges[destinationStopIndex].second; i++)
+    {
+      odTrip.egressFootpaths.push_back(std::make_pair(std::get<1>(footpaths[i]), std::get<2>(footpaths[i])));
+    }
+    odTripIndexesById[odTrip.id] = odTripIndex;
+  }
+
+  std::cout << "saving " << stops.size() << " stops, " << routes.size() << " lines, " << trips.size() << " trips, " << connections.size() << " connections, " << footpaths.size() << " footpaths and " << odTrips.size() << " od trips..." << std::endl;
+  CacheFetcher::saveToCacheFile(dataShortname, stops,              "stops");
+  CacheFetcher::saveToCacheFile(dataShortname, stopIndexesById,    "stop_indexes");
+  CacheFetcher::saveToCacheFile(dataShortname, routes,             "routes");
+  CacheFetcher::saveToCacheFile(dataShortname, routeIndexesById,   "route_indexes");
+  CacheFetcher::saveToCacheFile(dataShortname, trips,              "trips");
+  CacheFetcher::saveToCacheFile(dataShortname, tripIndexesById,    "trip_indexes");
+  CacheFetcher::saveToCacheFile(dataShortname, services,           "services");
+  CacheFetcher::saveToCacheFile(dataShortname, serviceIndexesById, "service_indexes");
+  CacheFetcher::saveToCacheFile(dataShortname, connections,        "connections_forward");
+  CacheFetcher::saveToCacheFile(dataShortname, reverseConnections, "connections_reverse");
+  CacheFetcher::saveToCacheFile(dataShortname, footpaths,          "footpaths");
+  CacheFetcher::saveToCacheFile(dataShortname, footpathsRanges,    "footpaths_ranges");
+  CacheFetcher::saveToCacheFile(dataShortname, odTrips,            "od_trips");
+  CacheFetcher::saveToCacheFile(dataShortname, odTripIndexesById,  "od_trip_indexes");
+  std::cout << "network saved to " << dataShortname << "_*.cache" << std::endl;
+
+  return 0;
+
+}
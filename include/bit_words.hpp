@@ -0,0 +1,55 @@
+#ifndef TR_BIT_WORDS
+#define TR_BIT_WORDS
+
+#include <cstdint>
+#include <cstddef>
+
+namespace TrRouting
+{
+
+  // bitsets stored as plain arrays of 64-bit words (bit i is bit i % 64 of word i / 64), so they can live in flat columns
+  // and be combined word by word:
+  namespace BitWords
+  {
+
+    inline size_t wordsCount(size_t bitsCount) { return (bitsCount + 63) / 64; }
+
+    inline bool test(const uint64_t * words, size_t i) { return (words[i >> 6] >> (i & 63)) & 1; }
+    inline void set(uint64_t * words, size_t i)        { words[i >> 6] |=  ((uint64_t)1 << (i & 63)); }
+    inline void clear(uint64_t * words, size_t i)      { words[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+
+    // sets all the bits below bitsCount and clears the unused bits of the last word:
+    inline void setAll(uint64_t * words, size_t bitsCount)
+    {
+      size_t count = wordsCount(bitsCount);
+      for (size_t i = 0; i < count; i++)
+      {
+        words[i] = ~(uint64_t)0;
+      }
+      if (bitsCount % 64 != 0)
+      {
+        words[count - 1] = ((uint64_t)1 << (bitsCount % 64)) - 1;
+      }
+    }
+
+    inline void andWith(uint64_t * words, const uint64_t * otherWords, size_t count)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        words[i] &= otherWords[i];
+      }
+    }
+
+    inline void andNotWith(uint64_t * words, const uint64_t * otherWords, size_t count)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        words[i] &= ~otherWords[i];
+      }
+    }
+
+  }
+
+}
+
+#endif // TR_BIT_WORDS
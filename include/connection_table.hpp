@@ -0,0 +1,151 @@
+#ifndef TR_CONNECTION_TABLE
+#define TR_CONNECTION_TABLE
+
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+
+#include "flat_column.hpp"
+
+namespace TrRouting
+{
+
+  // legacy connection tuple, still used as the on-disk cache format:
+  // departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
+  typedef std::tuple<int,int,int,int,int,short,short,int> ConnectionTuple;
+
+  // column-wise (struct of arrays) storage for connections, so the scan loops
+  // only pull the columns they actually test (times and trip index) through the cache.
+  // columns can also be views of a memory-mapped network cache file (see FlatNetworkCache):
+  struct ConnectionTable {
+
+  public:
+
+    enum connectionIndexes : short { STOP_DEP = 0, STOP_ARR = 1, TIME_DEP = 2, TIME_ARR = 3, TRIP = 4, CAN_BOARD = 5, CAN_UNBOARD = 6, SEQUENCE = 7 };
+    enum boardingFlag : unsigned char { CAN_BOARD_FLAG = 1, CAN_UNBOARD_FLAG = 2 };
+
+    FlatColumn<int>           departureTimes;
+    FlatColumn<int>           arrivalTimes;
+    FlatColumn<int>           tripIndexes;
+    FlatColumn<int>           departureStopIndexes;
+    FlatColumn<int>           arrivalStopIndexes;
+    FlatColumn<unsigned char> boardingFlags; // bit 0: can board, bit 1: can unboard
+    FlatColumn<int>           sequences;
+
+    int size() const { return departureTimes.size(); }
+
+    bool canBoard(int connectionIndex) const   { return boardingFlags[connectionIndex] & CAN_BOARD_FLAG;   }
+    bool canUnboard(int connectionIndex) const { return boardingFlags[connectionIndex] & CAN_UNBOARD_FLAG; }
+
+    void reserve(int connectionsCount)
+    {
+      departureTimes.reserve(connectionsCount);
+      arrivalTimes.reserve(connectionsCount);
+      tripIndexes.reserve(connectionsCount);
+      departureStopIndexes.reserve(connectionsCount);
+      arrivalStopIndexes.reserve(connectionsCount);
+      boardingFlags.reserve(connectionsCount);
+      sequences.reserve(connectionsCount);
+    }
+
+    void clear()
+    {
+      departureTimes.clear();
+      arrivalTimes.clear();
+      tripIndexes.clear();
+      departureStopIndexes.clear();
+      arrivalStopIndexes.clear();
+      boardingFlags.clear();
+      sequences.clear();
+    }
+
+    void push_back(int departureStopIndex, int arrivalStopIndex, int departureTime, int arrivalTime, int tripIndex, short canBoard, short canUnboard, int sequence)
+    {
+      departureTimes.push_back(departureTime);
+      arrivalTimes.push_back(arrivalTime);
+      tripIndexes.push_back(tripIndex);
+      departureStopIndexes.push_back(departureStopIndex);
+      arrivalStopIndexes.push_back(arrivalStopIndex);
+      boardingFlags.push_back((canBoard == 1 ? CAN_BOARD_FLAG : 0) | (canUnboard == 1 ? CAN_UNBOARD_FLAG : 0));
+      sequences.push_back(sequence);
+    }
+
+    void push_back(const ConnectionTuple& connection)
+    {
+      push_back(std::get<STOP_DEP>(connection), std::get<STOP_ARR>(connection), std::get<TIME_DEP>(connection), std::get<TIME_ARR>(connection), std::get<TRIP>(connection), std::get<CAN_BOARD>(connection), std::get<CAN_UNBOARD>(connection), std::get<SEQUENCE>(connection));
+    }
+
+    ConnectionTuple tuple(int connectionIndex) const
+    {
+      return std::make_tuple(departureStopIndexes[connectionIndex], arrivalStopIndexes[connectionIndex], departureTimes[connectionIndex], arrivalTimes[connectionIndex], tripIndexes[connectionIndex], (short)(canBoard(connectionIndex) ? 1 : 0), (short)(canUnboard(connectionIndex) ? 1 : 0), sequences[connectionIndex]);
+    }
+
+    // binary searches on the time columns, so a scan can start (and end) at the first relevant connection.
+    // forward tables must be sorted by departure time ascending, reverse tables by arrival time descending:
+    int firstDepartingAtOrAfter(int timeSeconds) const
+    {
+      return std::lower_bound(departureTimes.begin(), departureTimes.end(), timeSeconds) - departureTimes.begin();
+    }
+
+    int firstDepartingAfter(int timeSeconds) const
+    {
+      return std::upper_bound(departureTimes.begin(), departureTimes.end(), timeSeconds) - departureTimes.begin();
+    }
+
+    int firstArrivingAtOrBefore(int timeSeconds) const
+    {
+      return std::lower_bound(arrivalTimes.begin(), arrivalTimes.end(), timeSeconds, std::greater<int>()) - arrivalTimes.begin();
+    }
+
+    int firstArrivingBefore(int timeSeconds) const
+    {
+      return std::upper_bound(arrivalTimes.begin(), arrivalTimes.end(), timeSeconds, std::greater<int>()) - arrivalTimes.begin();
+    }
+
+    // new table with the connections at the given indexes, in that order (used to build the reverse table from the forward one):
+    ConnectionTable select(const std::vector<int>& connectionIndexes) const
+    {
+      ConnectionTable table;
+      table.reserve(connectionIndexes.size());
+      for (auto & connectionIndex : connectionIndexes)
+      {
+        table.departureTimes.push_back(departureTimes[connectionIndex]);
+        table.arrivalTimes.push_back(arrivalTimes[connectionIndex]);
+        table.tripIndexes.push_back(tripIndexes[connectionIndex]);
+        table.departureStopIndexes.push_back(departureStopIndexes[connectionIndex]);
+        table.arrivalStopIndexes.push_back(arrivalStopIndexes[connectionIndex]);
+        table.boardingFlags.push_back(boardingFlags[connectionIndex]);
+        table.sequences.push_back(sequences[connectionIndex]);
+      }
+      return table;
+    }
+
+    static ConnectionTable fromTuples(const std::vector<ConnectionTuple>& connections)
+    {
+      ConnectionTable table;
+      table.reserve(connections.size());
+      for (auto & connection : connections)
+      {
+        table.push_back(connection);
+      }
+      return table;
+    }
+
+    std::vector<ConnectionTuple> toTuples() const
+    {
+      std::vector<ConnectionTuple> connections;
+      int connectionsCount = size();
+      connections.reserve(connectionsCount);
+      for (int i = 0; i < connectionsCount; i++)
+      {
+        connections.push_back(tuple(i));
+      }
+      return connections;
+    }
+
+  };
+
+}
+
+#endif // TR_CONNECTION_TABLE
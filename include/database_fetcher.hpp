@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <iterator>
 #include <vector>
+#include <numeric>
 #include <math.h>
 #include <boost/algorithm/string.hpp>
 //#include <cereal/archives/binary.hpp>
@@ -27,9 +28,12 @@
 
 #include "calculation_time.hpp"
 #include "stop.hpp"
+#include "stop_table.hpp"
 #include "route.hpp"
 #include "point.hpp"
 #include "trip.hpp"
+#include "service.hpp"
+#include "connection_table.hpp"
 #include "od_trip.hpp"
 #include "tuple_boost_serialize.hpp"
 #include "toolbox.hpp"
@@ -59,9 +63,10 @@ namespace TrRouting
     const std::pair<std::vector<Stop> , std::map<unsigned long long, int>> getStops( std::string applicationShortname);
     const std::pair<std::vector<Route>, std::map<unsigned long long, int>> getRoutes(std::string applicationShortname);
     const std::pair<std::vector<Trip> , std::map<unsigned long long, int>> getTrips( std::string applicationShortname);
-    const std::pair<std::vector<std::tuple<int,int,int,int,int,short,short,int>>, std::vector<std::tuple<int,int,int,int,int,short,short,int>>> getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById);
+    const std::pair<std::vector<Service>, std::map<unsigned long long, int>> getServices(std::string applicationShortname);
+    const std::pair<ConnectionTable, ConnectionTable> getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById);
     const std::pair<std::vector<std::tuple<int,int,int>>, std::vector<std::pair<int,int>>> getFootpaths(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById);
-    const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> getOdTrips(std::string applicationShortname, std::vector<Stop> stops, Parameters& params);
+    const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> getOdTrips(std::string applicationShortname, const StopTable& stops, Parameters& params);
     //static const std::pair<int, int> getTripTravelTimeAndDistance(Point startingPoint, Point endingPoint, std::string mode, Parameters& params);
     
   private:
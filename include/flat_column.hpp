@@ -0,0 +1,132 @@
+#ifndef TR_FLAT_COLUMN
+#define TR_FLAT_COLUMN
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace TrRouting
+{
+
+  // contiguous array of fixed-width values, either owned (filled with push_back or from a vector)
+  // or a read-only view of memory owned by someone else (a memory-mapped network cache file for instance).
+  // reads always go through the same pointer, so the scan loops do not care where the values live:
+  template <typename T>
+  class FlatColumn {
+
+  public:
+
+    typedef T        value_type;
+    typedef const T* const_iterator;
+
+    FlatColumn() : values(nullptr), count(0) {}
+    FlatColumn(const std::vector<T>& theValues) : ownedValues(theValues) { pointToOwnedValues(); }
+    FlatColumn(std::vector<T>&& theValues) : ownedValues(std::move(theValues)) { pointToOwnedValues(); }
+    FlatColumn(const FlatColumn& other) : ownedValues(other.ownedValues), owner(other.owner), values(other.values), count(other.count)
+    {
+      if (!owner) { pointToOwnedValues(); }
+    }
+    FlatColumn(FlatColumn&& other) : ownedValues(std::move(other.ownedValues)), owner(std::move(other.owner)), values(other.values), count(other.count)
+    {
+      if (!owner) { pointToOwnedValues(); }
+      other.clear();
+    }
+
+    FlatColumn& operator=(const FlatColumn& other)
+    {
+      if (this != &other)
+      {
+        ownedValues = other.ownedValues;
+        owner       = other.owner;
+        values      = other.values;
+        count       = other.count;
+        if (!owner) { pointToOwnedValues(); }
+      }
+      return *this;
+    }
+    FlatColumn& operator=(FlatColumn&& other)
+    {
+      if (this != &other)
+      {
+        ownedValues = std::move(other.ownedValues);
+        owner       = std::move(other.owner);
+        values      = other.values;
+        count       = other.count;
+        if (!owner) { pointToOwnedValues(); }
+        other.clear();
+      }
+      return *this;
+    }
+    FlatColumn& operator=(const std::vector<T>& theValues) { return *this = FlatColumn(theValues); }
+    FlatColumn& operator=(std::vector<T>&& theValues)      { return *this = FlatColumn(std::move(theValues)); }
+
+    // view of count values at data, kept valid as long as theOwner lives:
+    static FlatColumn view(const T* data, size_t count, std::shared_ptr<const void> theOwner)
+    {
+      FlatColumn column;
+      column.owner  = theOwner;
+      column.values = data;
+      column.count  = count;
+      return column;
+    }
+
+    size_t size()  const { return count; }
+    bool   empty() const { return count == 0; }
+    bool   isView() const { return (bool)owner; }
+
+    const T& operator[](size_t index) const { return values[index]; }
+    const T* data()  const { return values; }
+    const T* begin() const { return values; }
+    const T* end()   const { return values + count; }
+    const T& back()  const { return values[count - 1]; }
+
+    // building (owned values only, a view is copied to owned values first):
+    void reserve(size_t capacity)
+    {
+      makeOwned();
+      ownedValues.reserve(capacity);
+      pointToOwnedValues();
+    }
+
+    void push_back(const T& value)
+    {
+      makeOwned();
+      ownedValues.push_back(value);
+      pointToOwnedValues();
+    }
+
+    void clear()
+    {
+      owner.reset();
+      ownedValues.clear();
+      pointToOwnedValues();
+    }
+
+  private:
+
+    void pointToOwnedValues()
+    {
+      values = ownedValues.data();
+      count  = ownedValues.size();
+    }
+
+    void makeOwned()
+    {
+      if (owner)
+      {
+        ownedValues.assign(values, values + count);
+        owner.reset();
+        pointToOwnedValues();
+      }
+    }
+
+    std::vector<T>              ownedValues;
+    std::shared_ptr<const void> owner; // set for views only
+    const T*                    values;
+    size_t                      count;
+
+  };
+
+}
+
+#endif // TR_FLAT_COLUMN
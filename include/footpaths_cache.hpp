@@ -0,0 +1,217 @@
+#ifndef TR_FOOTPATHS_CACHE
+#define TR_FOOTPATHS_CACHE
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <math.h>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
+
+#include "point.hpp"
+#include "stop_table.hpp"
+#include "stops_spatial_index.hpp"
+
+namespace TrRouting
+{
+
+  // key of cached access or egress footpaths: the point snapped to a small grid cell, the access mode, max travel time and speed.
+  // every point in the same cell gets the footpaths calculated for the first point seen in this cell:
+  struct FootpathsCacheKey {
+
+  public:
+
+    int         latitudeCell;
+    int         longitudeCell;
+    std::string mode;
+    int         maxTravelTimeSeconds;
+    int         speedMillimetersPerSecond;
+
+    FootpathsCacheKey() {}
+    FootpathsCacheKey(const Point& point, float snapMeters, std::string _mode, int _maxTravelTimeSeconds, float speedMetersPerSecond) : mode(_mode), maxTravelTimeSeconds(_maxTravelTimeSeconds)
+    {
+      double cellLatitudeDegrees = snapMeters / 111132.92;
+      latitudeCell               = (int)floor(point.latitude / cellLatitudeDegrees);
+      // use the latitude of the cell, not of the point, so all points of a cell get the same longitude cell size:
+      double cellLongitudeDegrees = snapMeters / std::max(1.0f, StopsSpatialIndex::lengthOfOneDegreeOfLongitude(latitudeCell * cellLatitudeDegrees));
+      longitudeCell               = (int)floor(point.longitude / cellLongitudeDegrees);
+      speedMillimetersPerSecond   = (int)round(speedMetersPerSecond * 1000);
+    }
+
+    bool operator==(const FootpathsCacheKey& other) const
+    {
+      return latitudeCell == other.latitudeCell && longitudeCell == other.longitudeCell && maxTravelTimeSeconds == other.maxTravelTimeSeconds && speedMillimetersPerSecond == other.speedMillimetersPerSecond && mode == other.mode;
+    }
+
+    struct Hash {
+      size_t operator()(const FootpathsCacheKey& key) const
+      {
+        size_t hash = std::hash<std::string>()(key.mode);
+        hash = hash * 31 + std::hash<int>()(key.latitudeCell);
+        hash = hash * 31 + std::hash<int>()(key.longitudeCell);
+        hash = hash * 31 + std::hash<int>()(key.maxTravelTimeSeconds);
+        hash = hash * 31 + std::hash<int>()(key.speedMillimetersPerSecond);
+        return hash;
+      }
+    };
+
+  private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive& ar, const unsigned int /*version*/)
+    {
+      ar & latitudeCell;
+      ar & longitudeCell;
+      ar & mode;
+      ar & maxTravelTimeSeconds;
+      ar & speedMillimetersPerSecond;
+    }
+
+  };
+
+  // least recently used cache of access/egress footpaths (pair: stop index, travel time seconds) calculated with osrm,
+  // shared by all server threads. Entries are evicted when the estimated memory used goes over maxMemoryBytes:
+  class FootpathsCache {
+
+  public:
+
+    typedef std::pair<FootpathsCacheKey, std::vector<std::pair<int,int>>> Entry;
+
+    // entries with the stops signature of their network, as saved to the footpaths_cache .cache file:
+    typedef std::pair<unsigned long long, std::vector<Entry>> Snapshot;
+
+    FootpathsCache(long long _maxMemoryBytes, float _snapMeters = 10.0) : maxMemoryBytes(_maxMemoryBytes), snapMeters(_snapMeters), memoryBytes(0), hitsCount(0), missesCount(0), version(0) {}
+
+    FootpathsCacheKey key(const Point& point, std::string mode, int maxTravelTimeSeconds, float speedMetersPerSecond) const
+    {
+      return FootpathsCacheKey(point, snapMeters, mode, maxTravelTimeSeconds, speedMetersPerSecond);
+    }
+
+    // copy the cached footpaths into footpaths and mark them as recently used, false if not cached:
+    bool get(const FootpathsCacheKey& key, std::vector<std::pair<int,int>>& footpaths)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto entryIterator = entriesByKey.find(key);
+      if (entryIterator == entriesByKey.end())
+      {
+        missesCount++;
+        return false;
+      }
+      entries.splice(entries.begin(), entries, entryIterator->second);
+      footpaths = entryIterator->second->second;
+      hitsCount++;
+      return true;
+    }
+
+    void put(const FootpathsCacheKey& key, const std::vector<std::pair<int,int>>& footpaths)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      insert(key, footpaths);
+      version++;
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entries.clear();
+      entriesByKey.clear();
+      memoryBytes = 0;
+      version++;
+    }
+
+    // most recently used entries first:
+    Snapshot snapshot(unsigned long long stopsSignature) const
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return Snapshot(stopsSignature, std::vector<Entry>(entries.begin(), entries.end()));
+    }
+
+    // restore saved entries, ignored if they were calculated for other stops. Returns the number of restored entries:
+    int restore(const Snapshot& savedSnapshot, unsigned long long stopsSignature)
+    {
+      if (savedSnapshot.first != stopsSignature)
+      {
+        return 0;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto entryIterator = savedSnapshot.second.rbegin(); entryIterator != savedSnapshot.second.rend(); ++entryIterator)
+      {
+        insert(entryIterator->first, entryIterator->second);
+      }
+      return entries.size();
+    }
+
+    // stop indexes in cached footpaths are only valid for the same stops, in the same order and at the same places:
+    static unsigned long long stopsSignature(const StopTable& stops)
+    {
+      unsigned long long signature = 14695981039346656037ULL; // fnv-1a
+      for (int i = 0; i < stops.size(); i++)
+      {
+        for (unsigned long long value : {(unsigned long long)stops.ids[i], (unsigned long long)llround(stops.points[i].latitude * 1e7), (unsigned long long)llround(stops.points[i].longitude * 1e7)})
+        {
+          signature = (signature ^ value) * 1099511628211ULL;
+        }
+      }
+      return signature;
+    }
+
+    int       size()         const { std::lock_guard<std::mutex> lock(mutex); return entries.size(); }
+    long long usedBytes()    const { std::lock_guard<std::mutex> lock(mutex); return memoryBytes;     }
+    long long hits()         const { return hitsCount;   }
+    long long misses()       const { return missesCount; }
+    long long changesCount() const { return version;     } // incremented at each change, used to know if the cache must be saved again
+
+  private:
+
+    static long long entryBytes(const FootpathsCacheKey& key, const std::vector<std::pair<int,int>>& footpaths)
+    {
+      // list node, hash map node and string/vector buffers (approximation):
+      return sizeof(Entry) + 4 * sizeof(void*) + key.mode.capacity() + footpaths.size() * sizeof(std::pair<int,int>) + 32;
+    }
+
+    void insert(const FootpathsCacheKey& key, const std::vector<std::pair<int,int>>& footpaths)
+    {
+      long long bytes = entryBytes(key, footpaths);
+      if (bytes > maxMemoryBytes)
+      {
+        return;
+      }
+      auto entryIterator = entriesByKey.find(key);
+      if (entryIterator != entriesByKey.end())
+      {
+        memoryBytes -= entryBytes(entryIterator->second->first, entryIterator->second->second);
+        entries.erase(entryIterator->second);
+        entriesByKey.erase(entryIterator);
+      }
+      while (memoryBytes + bytes > maxMemoryBytes && !entries.empty())
+      {
+        memoryBytes -= entryBytes(entries.back().first, entries.back().second);
+        entriesByKey.erase(entries.back().first);
+        entries.pop_back();
+      }
+      entries.push_front(Entry(key, footpaths));
+      entriesByKey[key] = entries.begin();
+      memoryBytes += bytes;
+    }
+
+    long long                                                                            maxMemoryBytes;
+    float                                                                                snapMeters;
+    long long                                                                            memoryBytes;
+    std::list<Entry>                                                                     entries; // most recently used first
+    std::unordered_map<FootpathsCacheKey, std::list<Entry>::iterator, FootpathsCacheKey::Hash> entriesByKey;
+    std::atomic<long long>                                                               hitsCount;
+    std::atomic<long long>                                                               missesCount;
+    std::atomic<long long>                                                               version;
+    mutable std::mutex                                                                   mutex;
+
+  };
+
+}
+
+#endif // TR_FOOTPATHS_CACHE
@@ -0,0 +1,60 @@
+#ifndef TR_ID_INDEX_MAP
+#define TR_ID_INDEX_MAP
+
+#include <map>
+#include <stdexcept>
+#include <algorithm>
+
+#include "flat_column.hpp"
+
+namespace TrRouting
+{
+
+  // read-only id -> index map stored as two flat arrays sorted by id (binary search instead of walking map nodes).
+  // same lookups as the std::map it replaces: at() throws std::out_of_range for unknown ids, count() returns 0 or 1:
+  class IdIndexMap {
+
+  public:
+
+    FlatColumn<unsigned long long> ids; // sorted ascending
+    FlatColumn<int>                indexes;
+
+    IdIndexMap() {}
+    IdIndexMap(const std::map<unsigned long long, int>& indexesById)
+    {
+      ids.reserve(indexesById.size());
+      indexes.reserve(indexesById.size());
+      for (auto & idIndex : indexesById)
+      {
+        ids.push_back(idIndex.first);
+        indexes.push_back(idIndex.second);
+      }
+    }
+
+    int at(unsigned long long id) const
+    {
+      int position = find(id);
+      if (position < 0)
+      {
+        throw std::out_of_range("unknown id " + std::to_string(id));
+      }
+      return indexes[position];
+    }
+
+    int count(unsigned long long id) const { return find(id) >= 0 ? 1 : 0; }
+
+    int size() const { return ids.size(); }
+
+  private:
+
+    int find(unsigned long long id) const
+    {
+      const unsigned long long * idIterator = std::lower_bound(ids.begin(), ids.end(), id);
+      return idIterator != ids.end() && *idIterator == id ? idIterator - ids.begin() : -1;
+    }
+
+  };
+
+}
+
+#endif // TR_ID_INDEX_MAP
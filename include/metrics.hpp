@@ -0,0 +1,234 @@
+#ifndef TR_METRICS
+#define TR_METRICS
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+
+namespace TrRouting
+{
+
+  // name, labels (prometheus syntax without braces, can be empty) and description of a histogram or counter:
+  struct MetricDefinition {
+    std::string name;
+    std::string labels;
+    std::string help;
+  };
+
+  // latency histograms and counters shared by all server threads, exported in the prometheus text format. Each thread
+  // writes to its own slot with relaxed atomic additions (no lock, no cache line shared with other threads unless there
+  // are more threads than slots), slots are only summed when exported. Histogram buckets are logarithmic with 16 linear
+  // sub-buckets by power of two (like hdr histograms), so any percentile is known within about 6% from 1 microsecond to
+  // 25 days:
+  class Metrics {
+
+  public:
+
+    static const int subBucketsCount {16};
+    static const int bucketsCount    {subBucketsCount + 37 * subBucketsCount};
+
+    Metrics(const std::vector<MetricDefinition>& _histograms, const std::vector<MetricDefinition>& _counters, int slotsCount = 32) : histograms(_histograms), counters(_counters), nextSlotIndex(0)
+    {
+      for (int slotIndex = 0; slotIndex < std::max(1, slotsCount); slotIndex++)
+      {
+        slots.push_back(std::unique_ptr<Slot>(new Slot(histograms.size(), counters.size())));
+      }
+    }
+
+    void record(int histogramIndex, long long microseconds)
+    {
+      Slot & slot = threadSlot();
+      unsigned long long value = std::max(0LL, microseconds);
+      slot.histogramsCounts[histogramIndex * bucketsCount + bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+      slot.histogramsSums[histogramIndex].fetch_add(value, std::memory_order_relaxed);
+      unsigned long long maxValue = slot.histogramsMaxs[histogramIndex].load(std::memory_order_relaxed);
+      while (value > maxValue && !slot.histogramsMaxs[histogramIndex].compare_exchange_weak(maxValue, value, std::memory_order_relaxed)) {}
+    }
+
+    void add(int counterIndex, long long value = 1)
+    {
+      threadSlot().counters[counterIndex].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // histograms (with cumulative buckets from 100 microseconds to 10 seconds), their quantiles and the counters:
+    std::string prometheusText() const
+    {
+      static const double bucketsUpperBoundsSeconds[] {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+      static const double quantiles[] {0.5, 0.9, 0.99, 0.999};
+      std::string text;
+      std::vector<unsigned long long> counts(bucketsCount);
+      for (int histogramIndex = 0; histogramIndex < (int)histograms.size(); histogramIndex++)
+      {
+        const MetricDefinition & histogram = histograms[histogramIndex];
+        std::fill(counts.begin(), counts.end(), 0);
+        unsigned long long sum {0};
+        unsigned long long max {0};
+        for (auto & slot : slots)
+        {
+          for (int bucket = 0; bucket < bucketsCount; bucket++)
+          {
+            counts[bucket] += slot->histogramsCounts[histogramIndex * bucketsCount + bucket].load(std::memory_order_relaxed);
+          }
+          sum += slot->histogramsSums[histogramIndex].load(std::memory_order_relaxed);
+          max  = std::max(max, slot->histogramsMaxs[histogramIndex].load(std::memory_order_relaxed));
+        }
+        unsigned long long count {0};
+        for (auto bucketCount : counts)
+        {
+          count += bucketCount;
+        }
+
+        if (isFirstOfFamily(histograms, histogramIndex))
+        {
+          text += "# HELP " + histogram.name + " " + histogram.help + "\n# TYPE " + histogram.name + " histogram\n";
+        }
+        int bucket {0};
+        unsigned long long cumulativeCount {0};
+        for (double upperBoundSeconds : bucketsUpperBoundsSeconds)
+        {
+          unsigned long long upperBoundMicroseconds = (unsigned long long)(upperBoundSeconds * 1000000 + 0.5);
+          for (; bucket < bucketsCount && bucketLowerBound(bucket + 1) - 1 <= upperBoundMicroseconds; bucket++)
+          {
+            cumulativeCount += counts[bucket];
+          }
+          text += histogram.name + "_bucket{" + labelsWith(histogram.labels, "le=\"" + number(upperBoundSeconds) + "\"") + "} " + std::to_string(cumulativeCount) + "\n";
+        }
+        text += histogram.name + "_bucket{" + labelsWith(histogram.labels, "le=\"+Inf\"") + "} " + std::to_string(count) + "\n";
+        text += histogram.name + "_sum" + braced(histogram.labels) + " " + number(sum / 1000000.0) + "\n";
+        text += histogram.name + "_count" + braced(histogram.labels) + " " + std::to_string(count) + "\n";
+
+        // quantiles (upper bound of the bucket of the quantile, and exact max) since the server started:
+        if (isFirstOfFamily(histograms, histogramIndex))
+        {
+          text += "# HELP " + histogram.name + "_quantile " + histogram.help + " (quantiles since start)\n# TYPE " + histogram.name + "_quantile gauge\n";
+        }
+        for (double quantile : quantiles)
+        {
+          text += histogram.name + "_quantile{" + labelsWith(histogram.labels, "quantile=\"" + number(quantile) + "\"") + "} " + number(std::min(max, quantileMicroseconds(counts, count, quantile)) / 1000000.0) + "\n";
+        }
+        text += histogram.name + "_quantile{" + labelsWith(histogram.labels, "quantile=\"1\"") + "} " + number(max / 1000000.0) + "\n";
+      }
+
+      for (int counterIndex = 0; counterIndex < (int)counters.size(); counterIndex++)
+      {
+        const MetricDefinition & counter = counters[counterIndex];
+        long long value {0};
+        for (auto & slot : slots)
+        {
+          value += slot->counters[counterIndex].load(std::memory_order_relaxed);
+        }
+        appendMetric(text, isFirstOfFamily(counters, counterIndex) ? "counter" : "", counter, std::to_string(value));
+      }
+      return text;
+    }
+
+    // one line of a metric, preceded by its help and type when type is not empty (first metric of a family):
+    static void appendMetric(std::string& text, const std::string& type, const MetricDefinition& metric, const std::string& value)
+    {
+      if (!type.empty())
+      {
+        text += "# HELP " + metric.name + " " + metric.help + "\n# TYPE " + metric.name + " " + type + "\n";
+      }
+      text += metric.name + braced(metric.labels) + " " + value + "\n";
+    }
+
+  private:
+
+    struct Slot {
+      std::vector<std::atomic<unsigned long long>> histogramsCounts;
+      std::vector<std::atomic<unsigned long long>> histogramsSums;
+      std::vector<std::atomic<unsigned long long>> histogramsMaxs;
+      std::vector<std::atomic<long long>>          counters;
+      Slot(int histogramsCount, int countersCount) : histogramsCounts(histogramsCount * bucketsCount), histogramsSums(histogramsCount), histogramsMaxs(histogramsCount), counters(countersCount) {}
+    };
+
+    // slot of the calling thread, given in turn to each new thread:
+    Slot & threadSlot()
+    {
+      static thread_local int slotIndex {-1};
+      if (slotIndex < 0)
+      {
+        slotIndex = nextSlotIndex.fetch_add(1) % slots.size();
+      }
+      return *slots[slotIndex];
+    }
+
+    // values below 16 have their own bucket, then 16 buckets by power of two:
+    static int bucketIndex(unsigned long long value)
+    {
+      if (value < subBucketsCount)
+      {
+        return value;
+      }
+      int powerOfTwo = 63 - __builtin_clzll(value); // 4 or more
+      int bucket     = subBucketsCount + (powerOfTwo - 4) * subBucketsCount + (int)((value >> (powerOfTwo - 4)) - subBucketsCount);
+      return std::min(bucket, bucketsCount - 1);
+    }
+
+    static unsigned long long bucketLowerBound(int bucket)
+    {
+      if (bucket < subBucketsCount)
+      {
+        return bucket;
+      }
+      int powerOfTwo = 4 + (bucket - subBucketsCount) / subBucketsCount;
+      return (unsigned long long)(subBucketsCount + (bucket - subBucketsCount) % subBucketsCount) << (powerOfTwo - 4);
+    }
+
+    static unsigned long long quantileMicroseconds(const std::vector<unsigned long long>& counts, unsigned long long count, double quantile)
+    {
+      unsigned long long rank = (unsigned long long)(quantile * count + 0.999999);
+      unsigned long long cumulativeCount {0};
+      for (int bucket = 0; bucket < bucketsCount; bucket++)
+      {
+        cumulativeCount += counts[bucket];
+        if (cumulativeCount >= rank && cumulativeCount > 0)
+        {
+          return bucketLowerBound(bucket + 1) - 1;
+        }
+      }
+      return 0;
+    }
+
+    static bool isFirstOfFamily(const std::vector<MetricDefinition>& metrics, int metricIndex)
+    {
+      for (int i = 0; i < metricIndex; i++)
+      {
+        if (metrics[i].name == metrics[metricIndex].name)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    static std::string braced(const std::string& labels)
+    {
+      return labels.empty() ? "" : "{" + labels + "}";
+    }
+
+    static std::string labelsWith(const std::string& labels, const std::string& label)
+    {
+      return labels.empty() ? label : labels + "," + label;
+    }
+
+    static std::string number(double value)
+    {
+      char formatted[32];
+      snprintf(formatted, sizeof(formatted), "%.9g", value);
+      return formatted;
+    }
+
+    std::vector<MetricDefinition>     histograms;
+    std::vector<MetricDefinition>     counters;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::atomic<int>                  nextSlotIndex;
+
+  };
+
+}
+
+#endif // TR_METRICS
@@ -13,9 +13,18 @@
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <sstream>
 
 #include "point.hpp"
 #include "stop.hpp"
+#include "stop_table.hpp"
+#include "stops_spatial_index.hpp"
 
 namespace TrRouting
 {
@@ -30,7 +39,16 @@ namespace TrRouting
       
     }
     
-    static std::vector<std::pair<int,int>> getAccessibleStopsFootpathsFromPoint(const Point point, const std::vector<Stop> stops, std::string mode, int maxTravelTimeSeconds, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort);
+    static std::vector<std::pair<int,int>> getAccessibleStopsFootpathsFromPoint(const Point& point, const StopTable& stops, const StopsSpatialIndex& stopsSpatialIndex, std::string mode, int maxTravelTimeSeconds, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort);
+    
+    // same for several points (for instance origin and destination) with a single osrm table request, one result per point:
+    static std::vector<std::vector<std::pair<int,int>>> getAccessibleStopsFootpathsFromPoints(const std::vector<Point>& points, const std::vector<int>& maxTravelTimesSeconds, const StopTable& stops, const StopsSpatialIndex& stopsSpatialIndex, std::string mode, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort);
+    
+    // read only the durations matrix of an osrm table response (null durations are set to -1), false if not found or malformed:
+    static bool parseDurations(const std::string& responseJson, std::vector<std::vector<double>>& durations);
+    
+    // http get using a persistent (keep-alive) connection to host:port, reused between calls and threads. empty string if the request failed:
+    static std::string httpGet(const std::string& path, std::string host, std::string port);
     
   };
     
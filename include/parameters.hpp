@@ -22,6 +22,9 @@ namespace TrRouting
   class CacheFetcher;
   class GtfsFetcher;
   class CsvFetcher;
+  class FootpathsCache;
+  class QueryContextPool;
+  class WorkerPool;
 
   struct Parameters {
     
@@ -31,10 +34,13 @@ namespace TrRouting
     CacheFetcher*    cacheFetcher;
     GtfsFetcher*     gtfsFetcher;
     CsvFetcher*      csvFetcher;
+    FootpathsCache*  footpathsCache; // cache of access/egress footpaths fetched from osrm, NULL to always ask osrm
+    QueryContextPool* alternativesContextPool; // query contexts borrowed by the alternatives workers, NULL to allocate one by worker
+    WorkerPool*       alternativesWorkers; // threads calculating the alternatives batches with this calculator, NULL to calculate them all in its thread
     
-    int routingDateYear;   // not implemented, use onlyServiceIds or exceptServiceIds for now
-    int routingDateMonth;  // not implemented, use onlyServiceIds or exceptServiceIds for now
-    int routingDateDay;    // not implemented, use onlyServiceIds or exceptServiceIds for now
+    int routingDateYear;   // 0: any date. Only trips running on this date are used, if the network has service calendars
+    int routingDateMonth;
+    int routingDateDay;
     std::vector<int> onlyServiceIds;
     std::vector<unsigned long long> exceptServiceIds;
     std::vector<unsigned long long> onlyRouteIds;
@@ -60,6 +66,7 @@ namespace TrRouting
     int arrivalTimeHour;
     int arrivalTimeMinutes;
     int maxTotalTravelTimeSeconds;
+    int departureWindowSeconds; // profile query when > 0: all pareto-optimal journeys (departure time, arrival time) leaving between departure time and departure time + window
     int maxNumberOfTransfers;
     int minWaitingTimeSeconds;
     int transferPenaltySeconds;
@@ -77,7 +84,7 @@ namespace TrRouting
     Point destination;
     long long originStopId;
     long long destinationStopId;
-    OdTrip* odTrip;
+    const OdTrip* odTrip;
     
     std::string databaseName;
     std::string databaseHost;
@@ -95,6 +102,7 @@ namespace TrRouting
     std::string accessMode;
     std::string egressMode;
     bool debugDisplay; // display performance and debug info when set to true
+    bool profileHardwareCounters; // count cpu cycles, instructions, llc misses and branch misses of each calculation phase (linux perf events)
     bool tryNextModeIfRoutingFails;
     std::string noResultSecondMode;
     int noResultNextAccessTimeSecondsIncrement;
@@ -109,16 +117,24 @@ namespace TrRouting
     bool detailedResults;              // return detailed results when using results for all stops
     bool transferOnlyAtSameStation;    // will transfer only between stops having the same station_id (better performance, but make sure your stations are well designed and specified)
     bool transferBetweenSameRoute;     // allow transfers between the same route_id
-    bool calculateByNumberOfTransfers; // calculate first the fastest route, then calculate with decreasing number of transfers until no route is found, return results for each number of transfers.
+    bool calculateByNumberOfTransfers; // return the pareto front of journeys trading arrival time against number of transfers (one scan, at most maxNumberOfTransfers transfers when set, and never more than QueryContext::maxParetoBoardings - 1 = 7 transfers: journeys needing more are only found without this option)
     bool alternatives;                 // calculate alternatives or not
+    bool alternativesList;             // return every alternative found, with the calculations counts, instead of the result of the last calculation
     
     void setDefaultValues()
     {
       odTrip                                 = NULL;
+      footpathsCache                         = NULL;
+      alternativesContextPool                = NULL;
+      alternativesWorkers                    = NULL;
+      routingDateYear                        = 0;
+      routingDateMonth                       = 0;
+      routingDateDay                         = 0;
       walkingSpeedMetersPerSecond            = 5/3.6; // 5 km/h
       drivingSpeedMetersPerSecond            = 90/3.6; // 90 km/h
       cyclingSpeedMetersPerSecond            = 25/3.6; // 25 km/h
       maxTotalTravelTimeSeconds              = MAX_INT;
+      departureWindowSeconds                 = 0;
       maxNumberOfTransfers                   = -1; // -1 means no limit
       minWaitingTimeSeconds                  = 5*60;
       maxAccessWalkingTravelTimeSeconds      = 20*60;
@@ -152,8 +168,10 @@ namespace TrRouting
       transferBetweenSameRoute               = true;
       calculateByNumberOfTransfers           = false;
       alternatives                           = false;
+      alternativesList                       = false;
       maxAlternatives                        = 100;
       debugDisplay                           = false;
+      profileHardwareCounters                = false;
       alternativesMaxTravelTimeRatio         = 1.5;
       minAlternativeMaxTravelTimeSeconds     = 30*60;
       alternativesMaxAddedTravelTimeSeconds  = 30*60;
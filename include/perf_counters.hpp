@@ -0,0 +1,134 @@
+#ifndef TR_PERF_COUNTERS
+#define TR_PERF_COUNTERS
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace TrRouting
+{
+
+  // hardware performance counters of the calling thread (linux perf_event_open), counting user space events only so they
+  // are allowed with the default perf_event_paranoid setting. Events are opened as one group, so they are counted over the
+  // same cycles and can be compared. Events the cpu or the virtual machine does not support are skipped (-1), and nothing
+  // is counted when perf events are not available at all (other systems, containers without the permission):
+  class PerfCounters {
+
+  public:
+
+    enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, EVENTS_COUNT };
+
+    static const char * eventName(int event)
+    {
+      static const char * eventsNames[EVENTS_COUNT] {"cycles", "instructions", "llcMisses", "branchMisses"};
+      return event >= 0 && event < EVENTS_COUNT ? eventsNames[event] : "";
+    }
+
+    // counters of the calling thread, opened by its first call. The counts of a thread must only be read by this thread:
+    static PerfCounters & ofThisThread()
+    {
+      static thread_local PerfCounters threadPerfCounters;
+      return threadPerfCounters;
+    }
+
+    bool available() const { return groupFd >= 0; }
+
+    // why no event could be opened, empty if available:
+    const std::string & unavailableReason() const { return reason; }
+
+    // events counted by this thread since the counters were opened, -1 for the unavailable events:
+    void read(long long values[EVENTS_COUNT]) const
+    {
+      for (int event = 0; event < EVENTS_COUNT; event++)
+      {
+        values[event] = -1;
+      }
+#ifdef __linux__
+      // PERF_FORMAT_GROUP: number of events, then their counts in the order they were opened:
+      unsigned long long groupValues[1 + EVENTS_COUNT];
+      if (groupFd < 0 || ::read(groupFd, groupValues, sizeof(groupValues)) < (ssize_t)sizeof(unsigned long long))
+      {
+        return;
+      }
+      for (int groupIndex = 0; groupIndex < (int)groupValues[0] && groupIndex < openedEventsCount; groupIndex++)
+      {
+        values[openedEvents[groupIndex]] = groupValues[1 + groupIndex];
+      }
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+      for (int groupIndex = 0; groupIndex < openedEventsCount; groupIndex++)
+      {
+        close(eventsFds[groupIndex]);
+      }
+#endif
+    }
+
+  private:
+
+    PerfCounters() : groupFd(-1), openedEventsCount(0)
+    {
+#ifdef __linux__
+      static const unsigned long long eventsConfigs[EVENTS_COUNT] {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+      for (int event = 0; event < EVENTS_COUNT; event++)
+      {
+        struct perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size           = sizeof(attributes);
+        attributes.type           = PERF_TYPE_HARDWARE;
+        attributes.config         = eventsConfigs[event];
+        attributes.read_format    = PERF_FORMAT_GROUP;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv     = 1;
+        attributes.disabled       = groupFd < 0 ? 1 : 0; // the group is enabled once all its events are opened
+        int eventFd = syscall(__NR_perf_event_open, &attributes, 0, -1, groupFd, 0); // this thread, any cpu
+        if (eventFd < 0)
+        {
+          if (reason.empty())
+          {
+            reason = std::string("perf_event_open failed for ") + eventName(event) + ": " + strerror(errno);
+          }
+          continue;
+        }
+        if (groupFd < 0)
+        {
+          groupFd = eventFd;
+        }
+        eventsFds[openedEventsCount]    = eventFd;
+        openedEvents[openedEventsCount] = event;
+        openedEventsCount++;
+      }
+      if (groupFd >= 0)
+      {
+        reason.clear();
+        ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      }
+#else
+      reason = "perf events are only available on linux";
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    int         groupFd; // leader: first event opened
+    int         eventsFds[EVENTS_COUNT];
+    int         openedEvents[EVENTS_COUNT]; // event of each opened fd, in group order
+    int         openedEventsCount;
+    std::string reason;
+
+  };
+
+}
+
+#endif // TR_PERF_COUNTERS
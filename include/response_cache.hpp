@@ -0,0 +1,194 @@
+#ifndef TR_RESPONSE_CACHE
+#define TR_RESPONSE_CACHE
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+
+namespace TrRouting
+{
+
+  // least recently used cache of routing responses by normalized query string, shared by all server threads. Entries are
+  // split in shards, each with its own lock and an equal part of maxMemoryBytes. A response is only valid for the network
+  // version it was calculated with, so entries of other versions are dropped when found and the whole cache is cleared
+  // when a new network is loaded:
+  class ResponseCache {
+
+  public:
+
+    ResponseCache(long long _maxMemoryBytes, int _shardsCount = 16) : shards(std::max(1, _shardsCount)), maxShardMemoryBytes(_maxMemoryBytes / std::max(1, _shardsCount)), hitsCount(0), missesCount(0), evictionsCount(0), invalidationsCount(0) {}
+
+    // parameters sorted by name, so the same parameters in another order share the same entry. The sort is stable, so
+    // repeated parameters keep their order and a query where it matters never gets the response of another:
+    static std::string normalizedQuery(const char * queryBegin, const char * queryEnd)
+    {
+      std::vector<std::pair<const char *, const char *>> parameters;
+      const char * parameterBegin = queryBegin;
+      for (const char * character = queryBegin; character <= queryEnd; character++)
+      {
+        if (character == queryEnd || *character == '&')
+        {
+          if (character > parameterBegin)
+          {
+            parameters.push_back(std::make_pair(parameterBegin, character));
+          }
+          parameterBegin = character + 1;
+        }
+      }
+      std::stable_sort(parameters.begin(), parameters.end(), [](const std::pair<const char *, const char *>& parameterA, const std::pair<const char *, const char *>& parameterB) {
+        return std::lexicographical_compare(parameterA.first, std::find(parameterA.first, parameterA.second, '='), parameterB.first, std::find(parameterB.first, parameterB.second, '='));
+      });
+      std::string query;
+      query.reserve(queryEnd - queryBegin);
+      for (auto & parameter : parameters)
+      {
+        if (!query.empty())
+        {
+          query += '&';
+        }
+        query.append(parameter.first, parameter.second);
+      }
+      return query;
+    }
+
+    // copy the cached response into response and mark it as recently used, false if not cached for this network version:
+    bool get(int networkVersion, const std::string& query, std::string& response)
+    {
+      Shard & shard = shardOf(query);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto entryIterator = shard.entriesByQuery.find(query);
+      if (entryIterator == shard.entriesByQuery.end())
+      {
+        missesCount++;
+        return false;
+      }
+      if (entryIterator->second->networkVersion != networkVersion)
+      {
+        shard.memoryBytes -= entryBytes(*entryIterator->second);
+        shard.entries.erase(entryIterator->second);
+        shard.entriesByQuery.erase(entryIterator);
+        invalidationsCount++;
+        missesCount++;
+        return false;
+      }
+      shard.entries.splice(shard.entries.begin(), shard.entries, entryIterator->second);
+      response = entryIterator->second->response;
+      hitsCount++;
+      return true;
+    }
+
+    void put(int networkVersion, const std::string& query, const std::string& response)
+    {
+      Entry entry {query, response, networkVersion};
+      long long bytes = entryBytes(entry);
+      if (bytes > maxShardMemoryBytes)
+      {
+        return;
+      }
+      Shard & shard = shardOf(query);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto entryIterator = shard.entriesByQuery.find(query);
+      if (entryIterator != shard.entriesByQuery.end())
+      {
+        shard.memoryBytes -= entryBytes(*entryIterator->second);
+        shard.entries.erase(entryIterator->second);
+        shard.entriesByQuery.erase(entryIterator);
+      }
+      while (shard.memoryBytes + bytes > maxShardMemoryBytes && !shard.entries.empty())
+      {
+        shard.memoryBytes -= entryBytes(shard.entries.back());
+        shard.entriesByQuery.erase(shard.entries.back().query);
+        shard.entries.pop_back();
+        evictionsCount++;
+      }
+      shard.entries.push_front(std::move(entry));
+      shard.entriesByQuery[query] = shard.entries.begin();
+      shard.memoryBytes += bytes;
+    }
+
+    // when a new network is published, its responses could differ:
+    void clear()
+    {
+      for (auto & shard : shards)
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        invalidationsCount += shard.entries.size();
+        shard.entries.clear();
+        shard.entriesByQuery.clear();
+        shard.memoryBytes = 0;
+      }
+    }
+
+    int size() const
+    {
+      int entriesCount {0};
+      for (auto & shard : shards)
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        entriesCount += shard.entries.size();
+      }
+      return entriesCount;
+    }
+
+    long long usedBytes() const
+    {
+      long long bytes {0};
+      for (auto & shard : shards)
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bytes += shard.memoryBytes;
+      }
+      return bytes;
+    }
+
+    long long maxBytes()      const { return maxShardMemoryBytes * shards.size(); }
+    int       shardsCount()   const { return shards.size();     }
+    long long hits()          const { return hitsCount;          }
+    long long misses()        const { return missesCount;        }
+    long long evictions()     const { return evictionsCount;     } // removed to make room for new entries
+    long long invalidations() const { return invalidationsCount; } // removed because the network changed
+    double    hitRatio()      const { long long lookups = hitsCount + missesCount; return lookups > 0 ? (double)hitsCount / lookups : 0.0; }
+
+  private:
+
+    struct Entry {
+      std::string query;
+      std::string response;
+      int         networkVersion;
+    };
+
+    struct Shard {
+      std::list<Entry>                                             entries; // most recently used first
+      std::unordered_map<std::string, std::list<Entry>::iterator> entriesByQuery;
+      long long                                                    memoryBytes {0};
+      mutable std::mutex                                           mutex;
+    };
+
+    Shard & shardOf(const std::string& query)
+    {
+      return shards[std::hash<std::string>()(query) % shards.size()];
+    }
+
+    static long long entryBytes(const Entry& entry)
+    {
+      // list node, hash map node with its copy of the query and string buffers (approximation):
+      return sizeof(Entry) + 4 * sizeof(void*) + sizeof(std::string) + 2 * entry.query.capacity() + entry.response.capacity() + 32;
+    }
+
+    std::vector<Shard>     shards;
+    long long              maxShardMemoryBytes;
+    std::atomic<long long> hitsCount;
+    std::atomic<long long> missesCount;
+    std::atomic<long long> evictionsCount;
+    std::atomic<long long> invalidationsCount;
+
+  };
+
+}
+
+#endif // TR_RESPONSE_CACHE
@@ -0,0 +1,75 @@
+#ifndef TR_ROUTE_TABLE
+#define TR_ROUTE_TABLE
+
+#include <string>
+#include <vector>
+
+#include "route.hpp"
+#include "flat_column.hpp"
+#include "string_pool.hpp"
+
+namespace TrRouting
+{
+
+  // column-wise routes of a loaded network (fetchers still return std::vector<Route>).
+  // names are interned in a string pool (agency and route type names are shared by many routes),
+  // a Route can be rebuilt with route(routeIndex) when needed:
+  struct RouteTable {
+
+  public:
+
+    FlatColumn<unsigned long long> ids;
+    FlatColumn<unsigned long long> agencyIds;
+    FlatColumn<unsigned long long> routeTypeIds;
+    FlatColumn<unsigned int>       agencyAcronyms; // string pool indexes
+    FlatColumn<unsigned int>       agencyNames;    // string pool indexes
+    FlatColumn<unsigned int>       shortnames;     // string pool indexes
+    FlatColumn<unsigned int>       longnames;      // string pool indexes
+    FlatColumn<unsigned int>       routeTypeNames; // string pool indexes
+    StringPool                     strings;
+
+    int size() const { return ids.size(); }
+
+    std::string shortname(int routeIndex) const { return strings.get(shortnames[routeIndex]); }
+
+    void push_back(const Route& route)
+    {
+      ids.push_back(route.id);
+      agencyIds.push_back(route.agencyId);
+      routeTypeIds.push_back(route.routeTypeId);
+      agencyAcronyms.push_back(strings.intern(route.agencyAcronym));
+      agencyNames.push_back(strings.intern(route.agencyName));
+      shortnames.push_back(strings.intern(route.shortname));
+      longnames.push_back(strings.intern(route.longname));
+      routeTypeNames.push_back(strings.intern(route.routeTypeName));
+    }
+
+    Route route(int routeIndex) const
+    {
+      Route route;
+      route.id            = ids[routeIndex];
+      route.agencyId      = agencyIds[routeIndex];
+      route.routeTypeId   = routeTypeIds[routeIndex];
+      route.agencyAcronym = strings.get(agencyAcronyms[routeIndex]);
+      route.agencyName    = strings.get(agencyNames[routeIndex]);
+      route.shortname     = strings.get(shortnames[routeIndex]);
+      route.longname      = strings.get(longnames[routeIndex]);
+      route.routeTypeName = strings.get(routeTypeNames[routeIndex]);
+      return route;
+    }
+
+    static RouteTable fromRoutes(const std::vector<Route>& routes)
+    {
+      RouteTable table;
+      for (auto & route : routes)
+      {
+        table.push_back(route);
+      }
+      return table;
+    }
+
+  };
+
+}
+
+#endif // TR_ROUTE_TABLE
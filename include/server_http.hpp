@@ -7,7 +7,10 @@
 
 #include <map>
 #include <unordered_map>
+#include <deque>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -68,13 +71,88 @@ namespace SimpleWeb {
 
             std::shared_ptr<socket_type> socket;
 
-            Response(const std::shared_ptr<socket_type> &socket): std::ostream(&streambuf), socket(socket) {}
+            std::shared_ptr<boost::asio::io_service::strand> strand;
+            std::shared_ptr<boost::asio::deadline_timer> timer;
+
+            std::mutex parts_mutex;
+            std::condition_variable part_written;
+            std::deque<std::string> parts;
+            size_t parts_size=0;
+            bool parts_writing=false;
+            bool parts_failed=false;
+            bool streaming=false;
+
+            Response(const std::shared_ptr<socket_type> &socket, const std::shared_ptr<boost::asio::io_service::strand> &strand,
+                    const std::shared_ptr<boost::asio::deadline_timer> &timer): std::ostream(&streambuf), socket(socket), strand(strand), timer(timer) {}
+
+            //On the strand, each part keeps the response until written
+            static void write_next_part(const std::shared_ptr<Response> &response) {
+                std::string *part;
+                {
+                    std::lock_guard<std::mutex> lock(response->parts_mutex);
+                    part=&response->parts.front();
+                }
+                boost::asio::async_write(*response->socket, boost::asio::buffer(*part), response->strand->wrap([response](const boost::system::error_code &ec, size_t /*bytes_transferred*/) {
+                    bool more;
+                    {
+                        std::lock_guard<std::mutex> lock(response->parts_mutex);
+                        response->parts_size-=response->parts.front().size();
+                        response->parts.pop_front();
+                        if(ec) {
+                            response->parts_failed=true;
+                            response->parts.clear();
+                            response->parts_size=0;
+                        }
+                        more=!response->parts.empty();
+                        response->parts_writing=more;
+                    }
+                    response->part_written.notify_all();
+                    if(more)
+                        write_next_part(response);
+                }));
+            }
 
         public:
             size_t size() {
                 return streambuf.size();
             }
 
+            /// Send what was written to the response so far as its next part, without waiting for it to be written. The rest of
+            /// the response can then be sent by parts from any thread, one thread at a time, after the resource function returned.
+            /// The content timeout is cancelled by the first part since streamed responses can take hours. Parts are written in
+            /// order by an async_write chain on the strand of the response, what is written after the last one is sent when the
+            /// response is destroyed. Returns false once a part could not be written (client gone).
+            static bool send_part(const std::shared_ptr<Response> &response) {
+                std::string part(boost::asio::buffers_begin(response->streambuf.data()), boost::asio::buffers_end(response->streambuf.data()));
+                response->streambuf.consume(part.size());
+                std::lock_guard<std::mutex> lock(response->parts_mutex);
+                if(!response->streaming) {
+                    response->streaming=true;
+                    auto timer=response->timer;
+                    if(timer)
+                        response->strand->post([timer]() { timer->cancel(); });
+                }
+                if(response->parts_failed)
+                    return false;
+                if(part.empty())
+                    return true;
+                response->parts_size+=part.size();
+                response->parts.push_back(std::move(part));
+                if(!response->parts_writing) {
+                    response->parts_writing=true;
+                    response->strand->post([response]() { write_next_part(response); });
+                }
+                return true;
+            }
+
+            /// Wait until at most max_size bytes of the parts sent are not written yet. Returns false once a part could not be
+            /// written. Must not be called from a thread running the io_service, as it writes them.
+            bool wait_parts(size_t max_size) {
+                std::unique_lock<std::mutex> lock(parts_mutex);
+                part_written.wait(lock, [this, max_size]() { return parts_failed || parts_size<=max_size; });
+                return !parts_failed;
+            }
+
             /// If true, force server to close the connection after the response have been sent.
             ///
             /// This is useful when implementing a HTTP/1.0-server sending content
@@ -234,19 +312,25 @@ namespace SimpleWeb {
         
         virtual void accept()=0;
         
-        std::shared_ptr<boost::asio::deadline_timer> get_timeout_timer(const std::shared_ptr<socket_type> &socket, long seconds) {
+        std::shared_ptr<boost::asio::deadline_timer> get_timeout_timer(const std::shared_ptr<socket_type> &socket, long seconds,
+                const std::shared_ptr<boost::asio::io_service::strand> &strand=nullptr) {
             if(seconds==0)
                 return nullptr;
             
             auto timer=std::make_shared<boost::asio::deadline_timer>(*io_service);
             timer->expires_from_now(boost::posix_time::seconds(seconds));
-            timer->async_wait([socket](const boost::system::error_code& ec){
+            auto handler=[socket](const boost::system::error_code& ec){
                 if(!ec) {
                     boost::system::error_code ec;
                     socket->lowest_layer().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
                     socket->lowest_layer().close();
                 }
-            });
+            };
+            //With a strand, the socket is not closed while one of its writes on this strand is running
+            if(strand)
+                timer->async_wait(strand->wrap(handler));
+            else
+                timer->async_wait(handler);
             return timer;
         }
         
@@ -382,27 +466,31 @@ namespace SimpleWeb {
                 std::function<void(std::shared_ptr<typename ServerBase<socket_type>::Response>,
                                    std::shared_ptr<typename ServerBase<socket_type>::Request>)>& resource_function) {
             //Set timeout on the following boost::asio::async-read or write function
-            auto timer=this->get_timeout_timer(socket, config.timeout_content);
+            //The response writes and the timeout run on the same strand, since parts of the response can be sent from other threads
+            auto strand=std::make_shared<boost::asio::io_service::strand>(*io_service);
+            auto timer=this->get_timeout_timer(socket, config.timeout_content, strand);
 
-            auto response=std::shared_ptr<Response>(new Response(socket), [this, request, timer](Response *response_ptr) {
+            auto response=std::shared_ptr<Response>(new Response(socket, strand, timer), [this, request](Response *response_ptr) {
                 auto response=std::shared_ptr<Response>(response_ptr);
-                this->send(response, [this, response, request, timer](const boost::system::error_code& ec) {
-                    if(timer)
-                        timer->cancel();
-                    if(!ec) {
-                        if (response->close_connection_after_response)
-                            return;
-
-                        auto range=request->header.equal_range("Connection");
-                        for(auto it=range.first;it!=range.second;it++) {
-                            if(boost::iequals(it->second, "close"))
+                response->strand->post([this, response, request]() {
+                    boost::asio::async_write(*response->socket, response->streambuf, response->strand->wrap([this, response, request](const boost::system::error_code& ec, size_t /*bytes_transferred*/) {
+                        if(response->timer)
+                            response->timer->cancel();
+                        if(!ec) {
+                            if (response->close_connection_after_response)
                                 return;
+
+                            auto range=request->header.equal_range("Connection");
+                            for(auto it=range.first;it!=range.second;it++) {
+                                if(boost::iequals(it->second, "close"))
+                                    return;
+                            }
+                            if(request->http_version >= "1.1")
+                                this->read_request_and_content(response->socket);
                         }
-                        if(request->http_version >= "1.1")
-                            this->read_request_and_content(response->socket);
-                    }
-                    else if(on_error)
-                        on_error(request, ec);
+                        else if(on_error)
+                            on_error(request, ec);
+                    }));
                 });
             });
 
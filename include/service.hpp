@@ -0,0 +1,51 @@
+#ifndef TR_SERVICE
+#define TR_SERVICE
+
+#include <vector>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace TrRouting
+{
+  
+  // service calendar, dates are yyyymmdd integers (20181231):
+  struct Service {
+  
+  public:
+   
+    unsigned long long id;
+    bool monday;
+    bool tuesday;
+    bool wednesday;
+    bool thursday;
+    bool friday;
+    bool saturday;
+    bool sunday;
+    int startDate;
+    int endDate;
+    std::vector<int> onlyDates;   // if not empty, the service runs only on these dates (weekdays and start/end dates are ignored)
+    std::vector<int> exceptDates; // the service does not run on these dates
+  
+  private:
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive&ar, const unsigned int version)
+    {
+        ar & id;
+        ar & monday;
+        ar & tuesday;
+        ar & wednesday;
+        ar & thursday;
+        ar & friday;
+        ar & saturday;
+        ar & sunday;
+        ar & startDate;
+        ar & endDate;
+        ar & onlyDates;
+        ar & exceptDates;
+    }
+  };
+
+}
+
+#endif // TR_SERVICE
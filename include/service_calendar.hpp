@@ -0,0 +1,174 @@
+#ifndef TR_SERVICE_CALENDAR
+#define TR_SERVICE_CALENDAR
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "service.hpp"
+#include "trip_table.hpp"
+#include "flat_column.hpp"
+
+namespace TrRouting
+{
+
+  // rules of the service of each trips service id (the distinct values of trips.serviceIds, at the same positions), evaluated
+  // for the requested day only: the trips running that day are the trips of its running services (see TripsBitsets). Calendars
+  // of any span are kept whole this way, a service running from 2000 to 2099 does not push the other ones out of a window of days.
+  // trips whose service has no calendar run every day:
+  struct ServiceCalendar {
+
+  public:
+
+    FlatColumn<unsigned long long> serviceIds;
+    FlatColumn<int>                startDays;         // days since 1970-01-01
+    FlatColumn<int>                endDays;           // included
+    FlatColumn<int>                weekdays;          // bit 0: monday to bit 6: sunday, -1 when the service has no calendar (runs every day)
+    FlatColumn<int>                onlyDaysOffsets;   // the only days of the service at position p are between onlyDaysOffsets[p] and onlyDaysOffsets[p + 1]
+    FlatColumn<int>                onlyDays;          // sorted by service, when not empty weekdays and start/end days are ignored
+    FlatColumn<int>                exceptDaysOffsets;
+    FlatColumn<int>                exceptDays;        // sorted by service, days the service does not run
+
+    bool hasCalendars() const { return serviceIds.size() > 0; } // false when there is no service calendar: trips are not filtered by date
+
+    // ids of the services running that day, services without calendar included:
+    void runningServiceIds(int year, int month, int day, std::vector<unsigned long long>& ids) const
+    {
+      int date    = daysFromCivil(year, month, day);
+      int weekday = ((date + 3) % 7 + 7) % 7; // 1970-01-01 was a thursday
+      ids.clear();
+      for (int position = 0; position < (int)serviceIds.size(); position++)
+      {
+        if (weekdays[position] < 0)
+        {
+          ids.push_back(serviceIds[position]);
+        }
+        else if (containsDay(exceptDays, exceptDaysOffsets[position], exceptDaysOffsets[position + 1], date))
+        {
+          continue;
+        }
+        else if (onlyDaysOffsets[position + 1] > onlyDaysOffsets[position])
+        {
+          if (containsDay(onlyDays, onlyDaysOffsets[position], onlyDaysOffsets[position + 1], date))
+          {
+            ids.push_back(serviceIds[position]);
+          }
+        }
+        else if (date >= startDays[position] && date <= endDays[position] && (weekdays[position] >> weekday & 1) != 0)
+        {
+          ids.push_back(serviceIds[position]);
+        }
+      }
+    }
+
+    static int daysFromCivil(int year, int month, int day)
+    {
+      year -= month <= 2;
+      int era       = (year >= 0 ? year : year - 399) / 400;
+      int yearOfEra = year - era * 400;
+      int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+      return era * 146097 + yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear - 719468;
+    }
+
+    static int daysFromDate(int date) { return daysFromCivil(date / 10000, date / 100 % 100, date % 100); } // date: yyyymmdd
+
+    static ServiceCalendar fromServices(const std::vector<Service>& services, const TripTable& trips)
+    {
+      ServiceCalendar calendar;
+      if (trips.size() == 0 || services.size() == 0)
+      {
+        return calendar;
+      }
+
+      std::unordered_map<unsigned long long, const Service *> servicesById;
+      for (auto & service : services)
+      {
+        servicesById[service.id] = &service;
+      }
+      int servicesCount = trips.serviceIds.size();
+      std::vector<unsigned long long> serviceIds(trips.serviceIds.begin(), trips.serviceIds.end());
+      std::vector<int> startDays(servicesCount, 0);
+      std::vector<int> endDays(servicesCount, -1);
+      std::vector<int> weekdays(servicesCount, -1);
+      std::vector<int> onlyDaysOffsets {0};
+      std::vector<int> onlyDays;
+      std::vector<int> exceptDaysOffsets {0};
+      std::vector<int> exceptDays;
+      for (int position = 0; position < servicesCount; position++)
+      {
+        auto serviceIterator = servicesById.find(serviceIds[position]);
+        if (serviceIterator != servicesById.end())
+        {
+          const Service & service = *serviceIterator->second;
+          const bool serviceWeekdays[7] = {service.monday, service.tuesday, service.wednesday, service.thursday, service.friday, service.saturday, service.sunday};
+          startDays[position] = daysFromDate(service.startDate);
+          endDays[position]   = daysFromDate(service.endDate);
+          weekdays[position]  = 0;
+          for (int weekday = 0; weekday < 7; weekday++)
+          {
+            weekdays[position] |= serviceWeekdays[weekday] ? 1 << weekday : 0;
+          }
+          addDays(service.onlyDates,   onlyDays);
+          addDays(service.exceptDates, exceptDays);
+        }
+        onlyDaysOffsets.push_back(onlyDays.size());
+        exceptDaysOffsets.push_back(exceptDays.size());
+      }
+      calendar.serviceIds        = std::move(serviceIds);
+      calendar.startDays         = std::move(startDays);
+      calendar.endDays           = std::move(endDays);
+      calendar.weekdays          = std::move(weekdays);
+      calendar.onlyDaysOffsets   = std::move(onlyDaysOffsets);
+      calendar.onlyDays          = std::move(onlyDays);
+      calendar.exceptDaysOffsets = std::move(exceptDaysOffsets);
+      calendar.exceptDays        = std::move(exceptDays);
+      return calendar;
+    }
+
+    // same number of rules for every service and offsets within the days, when loaded from a file:
+    bool isValid() const
+    {
+      size_t servicesCount = serviceIds.size();
+      return startDays.size() == servicesCount && endDays.size() == servicesCount && weekdays.size() == servicesCount
+          && areValidOffsets(onlyDaysOffsets, onlyDays.size()) && areValidOffsets(exceptDaysOffsets, exceptDays.size());
+    }
+
+  private:
+
+    bool areValidOffsets(const FlatColumn<int>& offsets, size_t daysCount) const
+    {
+      if (offsets.size() != serviceIds.size() + 1 || offsets[0] != 0 || offsets[serviceIds.size()] != (int)daysCount)
+      {
+        return false;
+      }
+      for (size_t position = 0; position < serviceIds.size(); position++)
+      {
+        if (offsets[position] > offsets[position + 1])
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    static bool containsDay(const FlatColumn<int>& days, int begin, int end, int day)
+    {
+      return std::binary_search(days.data() + begin, days.data() + end, day);
+    }
+
+    static void addDays(const std::vector<int>& dates, std::vector<int>& days)
+    {
+      size_t firstIndex = days.size();
+      for (int date : dates)
+      {
+        days.push_back(daysFromDate(date));
+      }
+      std::sort(days.begin() + firstIndex, days.end());
+    }
+
+  };
+
+}
+
+#endif // TR_SERVICE_CALENDAR
@@ -0,0 +1,68 @@
+#ifndef TR_STAMPED_VECTOR
+#define TR_STAMPED_VECTOR
+
+#include <vector>
+#include <algorithm>
+
+namespace TrRouting
+{
+  
+  // fixed size vector which can be reset to a default value in O(1):
+  // each slot keeps the epoch of its last write and is reinitialized with the default value
+  // the first time it is accessed after a reset, so a query only pays for the slots it touches.
+  template <typename T>
+  class StampedVector {
+  
+  public:
+    
+    StampedVector() : defaultValue(T()), epoch(1) {}
+    StampedVector(int size, const T& theDefaultValue = T()) : slots(size), defaultValue(theDefaultValue), epoch(1) {}
+    
+    int size() const { return slots.size(); }
+    
+    T& operator[](int index)
+    {
+      Slot & slot = slots[index];
+      if (slot.stamp != epoch)
+      {
+        slot.stamp = epoch;
+        slot.value = defaultValue;
+      }
+      return slot.value;
+    }
+    
+    void reset()
+    {
+      epoch++;
+      if (epoch == 0) // wrapped around: old stamps could match again, clear them all once
+      {
+        for (auto & slot : slots)
+        {
+          slot.stamp = 0;
+        }
+        epoch = 1;
+      }
+    }
+    
+    void reset(const T& theDefaultValue)
+    {
+      defaultValue = theDefaultValue;
+      reset();
+    }
+    
+  private:
+    
+    struct Slot {
+      T            value;
+      unsigned int stamp {0};
+    };
+    
+    std::vector<Slot> slots;
+    T                 defaultValue;
+    unsigned int      epoch;
+    
+  };
+  
+}
+
+#endif // TR_STAMPED_VECTOR
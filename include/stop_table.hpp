@@ -0,0 +1,68 @@
+#ifndef TR_STOP_TABLE
+#define TR_STOP_TABLE
+
+#include <vector>
+
+#include "stop.hpp"
+#include "point.hpp"
+#include "flat_column.hpp"
+#include "string_pool.hpp"
+
+namespace TrRouting
+{
+
+  // column-wise stops of a loaded network (fetchers still return std::vector<Stop>).
+  // code and name are interned in a string pool, a Stop can be rebuilt with stop(stopIndex) when needed:
+  struct StopTable {
+
+  public:
+
+    FlatColumn<unsigned long long> ids;
+    FlatColumn<Point>              points;
+    FlatColumn<long long>          stationIds;
+    FlatColumn<unsigned int>       codes; // string pool indexes
+    FlatColumn<unsigned int>       names; // string pool indexes
+    StringPool                     strings;
+
+    int size() const { return ids.size(); }
+
+    void push_back(const Stop& stop)
+    {
+      ids.push_back(stop.id);
+      points.push_back(stop.point);
+      stationIds.push_back(stop.stationId);
+      codes.push_back(strings.intern(stop.code));
+      names.push_back(strings.intern(stop.name));
+    }
+
+    Stop stop(int stopIndex) const
+    {
+      Stop stop;
+      stop.id        = ids[stopIndex];
+      stop.code      = strings.get(codes[stopIndex]);
+      stop.name      = strings.get(names[stopIndex]);
+      stop.stationId = stationIds[stopIndex];
+      stop.point     = points[stopIndex];
+      return stop;
+    }
+
+    static StopTable fromStops(const std::vector<Stop>& stops)
+    {
+      StopTable table;
+      table.ids.reserve(stops.size());
+      table.points.reserve(stops.size());
+      table.stationIds.reserve(stops.size());
+      table.codes.reserve(stops.size());
+      table.names.reserve(stops.size());
+      for (auto & stop : stops)
+      {
+        table.push_back(stop);
+      }
+      return table;
+    }
+
+  };
+
+}
+
+#endif // TR_STOP_TABLE
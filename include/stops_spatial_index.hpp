@@ -0,0 +1,159 @@
+#ifndef TR_STOPS_SPATIAL_INDEX
+#define TR_STOPS_SPATIAL_INDEX
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "point.hpp"
+#include "stop_table.hpp"
+
+namespace TrRouting
+{
+  
+  // uniform grid over the stops coordinates, so stops around a point can be found
+  // by checking only the cells near the point instead of every stop.
+  // stops of each cell are stored contiguously (with their coordinates) in cell order:
+  class StopsSpatialIndex {
+  
+  public:
+    
+    StopsSpatialIndex() : minLatitude(0.0), minLongitude(0.0), cellLatitudeDegrees(1.0), cellLongitudeDegrees(1.0), latitudeCellsCount(0), longitudeCellsCount(0) {}
+    
+    StopsSpatialIndex(const StopTable& stops, float cellSizeMeters = 500.0)
+    {
+      latitudeCellsCount  = 0;
+      longitudeCellsCount = 0;
+      if (stops.size() == 0)
+      {
+        return;
+      }
+      
+      double maxLatitude  {stops.points[0].latitude};
+      double maxLongitude {stops.points[0].longitude};
+      minLatitude  = stops.points[0].latitude;
+      minLongitude = stops.points[0].longitude;
+      for (auto & point : stops.points)
+      {
+        minLatitude  = std::min(minLatitude,  point.latitude);
+        minLongitude = std::min(minLongitude, point.longitude);
+        maxLatitude  = std::max(maxLatitude,  point.latitude);
+        maxLongitude = std::max(maxLongitude, point.longitude);
+      }
+      
+      double middleLatitude = (minLatitude + maxLatitude) / 2;
+      cellLatitudeDegrees   = cellSizeMeters / lengthOfOneDegreeOfLatitude(middleLatitude);
+      cellLongitudeDegrees  = cellSizeMeters / std::max(1.0f, lengthOfOneDegreeOfLongitude(middleLatitude));
+      
+      // enlarge cells if stops are spread so much that the grid would be mostly empty:
+      long long maxCellsCount = std::max((long long)1024, 4 * (long long)stops.size());
+      while (((long long)((maxLatitude - minLatitude) / cellLatitudeDegrees) + 1) * ((long long)((maxLongitude - minLongitude) / cellLongitudeDegrees) + 1) > maxCellsCount)
+      {
+        cellLatitudeDegrees  *= 2;
+        cellLongitudeDegrees *= 2;
+      }
+      latitudeCellsCount  = (int)((maxLatitude  - minLatitude)  / cellLatitudeDegrees)  + 1;
+      longitudeCellsCount = (int)((maxLongitude - minLongitude) / cellLongitudeDegrees) + 1;
+      
+      // counting sort of stops by cell:
+      std::vector<int> stopsCellIndexes(stops.size());
+      cellsFirstIndexes = std::vector<int>(latitudeCellsCount * longitudeCellsCount + 1, 0);
+      int i {0};
+      for (auto & point : stops.points)
+      {
+        stopsCellIndexes[i] = cellIndex(latitudeCell(point.latitude), longitudeCell(point.longitude));
+        cellsFirstIndexes[stopsCellIndexes[i] + 1]++;
+        i++;
+      }
+      for (int cellIndex = 0; cellIndex < latitudeCellsCount * longitudeCellsCount; cellIndex++)
+      {
+        cellsFirstIndexes[cellIndex + 1] += cellsFirstIndexes[cellIndex];
+      }
+      std::vector<int> cellsNextIndexes(cellsFirstIndexes.begin(), cellsFirstIndexes.end() - 1);
+      cellsStopIndexes = std::vector<int>(stops.size());
+      cellsStopPoints  = std::vector<Point>(stops.size());
+      for (i = 0; i < (int)stops.size(); i++)
+      {
+        cellsStopIndexes[cellsNextIndexes[stopsCellIndexes[i]]] = i;
+        cellsStopPoints[cellsNextIndexes[stopsCellIndexes[i]]]  = stops.points[i];
+        cellsNextIndexes[stopsCellIndexes[i]]++;
+      }
+    }
+    
+    // indexes (ascending) of the stops within bird distance of the point.
+    // uses the same equirectangular approximation as before the index existed, so results are unchanged:
+    std::vector<int> getStopIndexesAround(const Point& point, float maxDistanceMeters) const
+    {
+      std::vector<int> stopIndexes;
+      if (latitudeCellsCount == 0)
+      {
+        return stopIndexes;
+      }
+      
+      float lengthOfOneDegreeOfLongitude = this->lengthOfOneDegreeOfLongitude(point.latitude);
+      float lengthOfOneDegreeOflatitude  = lengthOfOneDegreeOfLatitude(point.latitude);
+      float maxDistanceMetersSquared     = maxDistanceMeters * maxDistanceMeters;
+      float distanceMetersSquared;
+      float distanceXMeters;
+      float distanceYMeters;
+      
+      // cells overlapping the bounding box of the circle (slightly enlarged to be safe with rounding):
+      double latitudeDegrees  = 1.01 * maxDistanceMeters / lengthOfOneDegreeOflatitude;
+      double longitudeDegrees = 1.01 * maxDistanceMeters / std::max(1.0f, std::abs(lengthOfOneDegreeOfLongitude));
+      int firstLatitudeCell   = latitudeCell(point.latitude   - latitudeDegrees);
+      int lastLatitudeCell    = latitudeCell(point.latitude   + latitudeDegrees);
+      int firstLongitudeCell  = longitudeCell(point.longitude - longitudeDegrees);
+      int lastLongitudeCell   = longitudeCell(point.longitude + longitudeDegrees);
+      
+      for (int latitudeCellIndex = firstLatitudeCell; latitudeCellIndex <= lastLatitudeCell; latitudeCellIndex++)
+      {
+        for (int cellIndex = this->cellIndex(latitudeCellIndex, firstLongitudeCell); cellIndex <= this->cellIndex(latitudeCellIndex, lastLongitudeCell); cellIndex++)
+        {
+          for (int i = cellsFirstIndexes[cellIndex]; i < cellsFirstIndexes[cellIndex + 1]; i++)
+          {
+            distanceXMeters       = (cellsStopPoints[i].longitude - point.longitude) * lengthOfOneDegreeOfLongitude;
+            distanceYMeters       = (cellsStopPoints[i].latitude  - point.latitude)  * lengthOfOneDegreeOflatitude ;
+            distanceMetersSquared = distanceXMeters * distanceXMeters + distanceYMeters * distanceYMeters;
+            if (distanceMetersSquared <= maxDistanceMetersSquared)
+            {
+              stopIndexes.push_back(cellsStopIndexes[i]);
+            }
+          }
+        }
+      }
+      std::sort(stopIndexes.begin(), stopIndexes.end());
+      return stopIndexes;
+    }
+    
+    static float lengthOfOneDegreeOfLongitude(double latitude) { return 111412.84 * cos(latitude * M_PI / 180) -93.5 * cos (3 * latitude * M_PI / 180); }
+    static float lengthOfOneDegreeOfLatitude(double latitude)  { return 111132.92 - 559.82 * cos(2 * latitude * M_PI / 180) + 1.175 * cos(4 * latitude * M_PI / 180); }
+    
+  private:
+    
+    int latitudeCell(double latitude) const
+    {
+      return std::min(latitudeCellsCount - 1, std::max(0, (int)floor((latitude - minLatitude) / cellLatitudeDegrees)));
+    }
+    
+    int longitudeCell(double longitude) const
+    {
+      return std::min(longitudeCellsCount - 1, std::max(0, (int)floor((longitude - minLongitude) / cellLongitudeDegrees)));
+    }
+    
+    int cellIndex(int latitudeCellIndex, int longitudeCellIndex) const { return latitudeCellIndex * longitudeCellsCount + longitudeCellIndex; }
+    
+    double             minLatitude;
+    double             minLongitude;
+    double             cellLatitudeDegrees;
+    double             cellLongitudeDegrees;
+    int                latitudeCellsCount;
+    int                longitudeCellsCount;
+    std::vector<int>   cellsFirstIndexes; // index: cell index, value: index of the first stop of the cell in cellsStopIndexes (last value is the stops count)
+    std::vector<int>   cellsStopIndexes;
+    std::vector<Point> cellsStopPoints;
+    
+  };
+  
+}
+
+#endif // TR_STOPS_SPATIAL_INDEX
@@ -0,0 +1,152 @@
+#ifndef TR_STREAMED_RESULT
+#define TR_STREAMED_RESULT
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <cstdio>
+
+namespace TrRouting
+{
+
+  // result written by parts while it is being calculated, to the response with the http/1.1 chunked transfer encoding
+  // (or as is when the connection is closed after the response) and/or to a file. Content is buffered until the buffer
+  // reaches the chunk size or flush() is called, so large results are never kept in memory as a whole:
+  class StreamedResult {
+
+  public:
+
+    StreamedResult(std::function<bool(const std::string&)> theSendFunction, bool theChunked, size_t theChunkSize = 65536) : sendFunction(theSendFunction), chunked(theChunked), chunkSize(theChunkSize)
+    {
+      buffer.reserve(chunkSize + 4096);
+    }
+
+    void openFile(const std::string& filePath)
+    {
+      file.open(filePath, std::ios_base::trunc);
+    }
+
+    void write(const std::string& content)
+    {
+      buffer += content;
+      if (buffer.size() >= chunkSize)
+      {
+        flush();
+      }
+    }
+
+    void flush()
+    {
+      if (buffer.size() == 0)
+      {
+        return;
+      }
+      if (file.is_open())
+      {
+        file << buffer;
+      }
+      if (sending)
+      {
+        sending = sendFunction(chunked ? chunk(buffer) : buffer);
+      }
+      bytesCount += buffer.size();
+      buffer.clear();
+    }
+
+    // flush and close the file, returns what ends the response:
+    std::string end()
+    {
+      flush();
+      if (file.is_open())
+      {
+        file.close();
+      }
+      return chunked ? "0\r\n\r\n" : "";
+    }
+
+    bool isSending() const // false once the client is gone
+    {
+      return sending;
+    }
+
+    bool isSaving() const
+    {
+      return file.is_open();
+    }
+
+    size_t size() const // bytes already flushed
+    {
+      return bytesCount;
+    }
+
+  private:
+
+    std::string chunk(const std::string& content) const
+    {
+      char sizeHex[20];
+      snprintf(sizeHex, sizeof(sizeHex), "%zx\r\n", content.size());
+      return sizeHex + content + "\r\n";
+    }
+
+    std::function<bool(const std::string&)> sendFunction;
+    bool          chunked;
+    size_t        chunkSize;
+    bool          sending {true};
+    size_t        bytesCount {0};
+    std::string   buffer;
+    std::ofstream file;
+
+  };
+
+  // results calculated in any order by several tasks, written in order by the task setting the next one to write, so no
+  // thread waits for them. What a task wrote is flushed when the next result is not ready yet, so the client gets the first
+  // results right away:
+  class OrderedResults {
+
+  public:
+
+    OrderedResults(int resultsCount, std::function<void(int, const std::string&)> theWriteFunction, std::function<void()> theFlushFunction) : results(resultsCount), ready(resultsCount, 0), writeFunction(theWriteFunction), flushFunction(theFlushFunction) {}
+
+    void set(int index, std::string& result)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      results[index].swap(result);
+      ready[index] = 1;
+      if (index != writtenCount)
+      {
+        return;
+      }
+      while (writtenCount < (int)results.size() && ready[writtenCount] != 0)
+      {
+        writeFunction(writtenCount, results[writtenCount]);
+        std::string().swap(results[writtenCount]); // not kept once written
+        writtenCount++;
+      }
+      if (writtenCount < (int)results.size())
+      {
+        flushFunction();
+      }
+    }
+
+    int written()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return writtenCount;
+    }
+
+  private:
+
+    std::vector<std::string> results;
+    std::vector<char>        ready;
+    std::function<void(int, const std::string&)> writeFunction;
+    std::function<void()>    flushFunction;
+    int                      writtenCount {0};
+    std::mutex               mutex;
+
+  };
+
+}
+
+#endif // TR_STREAMED_RESULT
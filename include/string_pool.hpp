@@ -0,0 +1,67 @@
+#ifndef TR_STRING_POOL
+#define TR_STRING_POOL
+
+#include <string>
+#include <unordered_map>
+
+#include "flat_column.hpp"
+
+namespace TrRouting
+{
+
+  // interned strings (stop names, agency names, etc.) stored one after the other in a single characters array.
+  // identical strings are stored only once and referenced by their index:
+  class StringPool {
+
+  public:
+
+    FlatColumn<char>         characters;
+    FlatColumn<unsigned int> offsets; // index: string index, value: offset of its first character (one more value at the end, the characters count)
+
+    StringPool() {}
+
+    // index of the string, adding it if not already in the pool:
+    unsigned int intern(const std::string& value)
+    {
+      if (offsets.empty())
+      {
+        offsets.push_back(0);
+      }
+      if (indexesByString.size() + 1 < offsets.size()) // loaded pool: rebuild the lookup before adding more strings
+      {
+        for (unsigned int stringIndex = 0; stringIndex + 1 < offsets.size(); stringIndex++)
+        {
+          indexesByString.emplace(get(stringIndex), stringIndex);
+        }
+      }
+      auto stringIterator = indexesByString.find(value);
+      if (stringIterator != indexesByString.end())
+      {
+        return stringIterator->second;
+      }
+      unsigned int stringIndex = offsets.size() - 1;
+      for (auto & character : value)
+      {
+        characters.push_back(character);
+      }
+      offsets.push_back(characters.size());
+      indexesByString.emplace(value, stringIndex);
+      return stringIndex;
+    }
+
+    std::string get(unsigned int stringIndex) const
+    {
+      return std::string(characters.data() + offsets[stringIndex], offsets[stringIndex + 1] - offsets[stringIndex]);
+    }
+
+    int size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+  private:
+
+    std::unordered_map<std::string, unsigned int> indexesByString; // only used while adding strings
+
+  };
+
+}
+
+#endif // TR_STRING_POOL
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <iterator>
 #include <vector>
+#include <limits>
 #include <math.h>
 
 namespace TrRouting
@@ -0,0 +1,94 @@
+#ifndef TR_TRIP_TABLE
+#define TR_TRIP_TABLE
+
+#include <vector>
+#include <unordered_map>
+
+#include "trip.hpp"
+#include "flat_column.hpp"
+
+namespace TrRouting
+{
+
+  // column-wise trips of a loaded network (fetchers still return std::vector<Trip>).
+  // route, route path, service, route type and agency ids are replaced by 32-bit indexes in small tables
+  // of distinct ids, so filtering trips only reads 4 bytes per trip and attribute instead of 8 (48 bytes per Trip):
+  struct TripTable {
+
+  public:
+
+    FlatColumn<unsigned long long> ids;
+    FlatColumn<int>                routeIdIndexes;
+    FlatColumn<int>                routePathIdIndexes;
+    FlatColumn<int>                serviceIdIndexes;
+    FlatColumn<int>                routeTypeIdIndexes;
+    FlatColumn<int>                agencyIdIndexes;
+
+    // distinct ids, referenced by the indexes above:
+    FlatColumn<unsigned long long> routeIds;
+    FlatColumn<unsigned long long> routePathIds;
+    FlatColumn<unsigned long long> serviceIds;
+    FlatColumn<unsigned long long> routeTypeIds;
+    FlatColumn<unsigned long long> agencyIds;
+
+    int size() const { return ids.size(); }
+
+    unsigned long long routeId(int tripIndex)     const { return routeIds[routeIdIndexes[tripIndex]];         }
+    unsigned long long routePathId(int tripIndex) const { return routePathIds[routePathIdIndexes[tripIndex]]; }
+    unsigned long long serviceId(int tripIndex)   const { return serviceIds[serviceIdIndexes[tripIndex]];     }
+    unsigned long long routeTypeId(int tripIndex) const { return routeTypeIds[routeTypeIdIndexes[tripIndex]]; }
+    unsigned long long agencyId(int tripIndex)    const { return agencyIds[agencyIdIndexes[tripIndex]];       }
+
+    Trip trip(int tripIndex) const
+    {
+      Trip trip;
+      trip.id          = ids[tripIndex];
+      trip.routeId     = routeId(tripIndex);
+      trip.routePathId = routePathId(tripIndex);
+      trip.routeTypeId = routeTypeId(tripIndex);
+      trip.agencyId    = agencyId(tripIndex);
+      trip.serviceId   = serviceId(tripIndex);
+      return trip;
+    }
+
+    static TripTable fromTrips(const std::vector<Trip>& trips)
+    {
+      TripTable table;
+      std::unordered_map<unsigned long long, int> routeIdIndexes, routePathIdIndexes, serviceIdIndexes, routeTypeIdIndexes, agencyIdIndexes;
+      table.ids.reserve(trips.size());
+      table.routeIdIndexes.reserve(trips.size());
+      table.routePathIdIndexes.reserve(trips.size());
+      table.serviceIdIndexes.reserve(trips.size());
+      table.routeTypeIdIndexes.reserve(trips.size());
+      table.agencyIdIndexes.reserve(trips.size());
+      for (auto & trip : trips)
+      {
+        table.ids.push_back(trip.id);
+        table.routeIdIndexes.push_back(    distinctIdIndex(trip.routeId,     routeIdIndexes,     table.routeIds));
+        table.routePathIdIndexes.push_back(distinctIdIndex(trip.routePathId, routePathIdIndexes, table.routePathIds));
+        table.serviceIdIndexes.push_back(  distinctIdIndex(trip.serviceId,   serviceIdIndexes,   table.serviceIds));
+        table.routeTypeIdIndexes.push_back(distinctIdIndex(trip.routeTypeId, routeTypeIdIndexes, table.routeTypeIds));
+        table.agencyIdIndexes.push_back(   distinctIdIndex(trip.agencyId,    agencyIdIndexes,    table.agencyIds));
+      }
+      return table;
+    }
+
+  private:
+
+    static int distinctIdIndex(unsigned long long id, std::unordered_map<unsigned long long, int>& indexesById, FlatColumn<unsigned long long>& distinctIds)
+    {
+      auto idIterator = indexesById.find(id);
+      if (idIterator != indexesById.end())
+      {
+        return idIterator->second;
+      }
+      distinctIds.push_back(id);
+      indexesById.emplace(id, distinctIds.size() - 1);
+      return distinctIds.size() - 1;
+    }
+
+  };
+
+}
+
+#endif // TR_TRIP_TABLE
@@ -0,0 +1,123 @@
+#ifndef TR_TRIPS_BITSETS
+#define TR_TRIPS_BITSETS
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+
+#include "flat_column.hpp"
+#include "id_index_map.hpp"
+#include "bit_words.hpp"
+
+namespace TrRouting
+{
+
+  // for each distinct value of a trips attribute (route, route type, agency or service id), the bitset of its trips (see BitWords).
+  // only the non-empty words of each bitset are kept: the trips of a route are usually close to each other, and all the bitsets
+  // of an attribute never take more than one word per trip. Built once when the network is loaded:
+  struct TripsBitsets {
+
+  public:
+
+    IdIndexMap           indexesById;  // id -> position in wordsOffsets
+    FlatColumn<int>      wordsOffsets; // the words of the id at position p are between wordsOffsets[p] and wordsOffsets[p + 1]
+    FlatColumn<int>      wordIndexes;  // index of each word in the full trips bitset
+    FlatColumn<uint64_t> words;
+
+    // distinctIds and idIndexes are the trips table columns of the attribute:
+    static TripsBitsets fromTrips(const FlatColumn<unsigned long long>& distinctIds, const FlatColumn<int>& idIndexes)
+    {
+      TripsBitsets bitsets;
+      int distinctIdsCount = distinctIds.size();
+      int tripsCount       = idIndexes.size();
+
+      // trips are visited in order, so the words of each id are created in ascending word index:
+      std::vector<int> lastWordIndexes(distinctIdsCount, -1);
+      std::vector<int> wordsCounts(distinctIdsCount, 0);
+      for (int tripIndex = 0; tripIndex < tripsCount; tripIndex++)
+      {
+        if (lastWordIndexes[idIndexes[tripIndex]] != tripIndex / 64)
+        {
+          lastWordIndexes[idIndexes[tripIndex]] = tripIndex / 64;
+          wordsCounts[idIndexes[tripIndex]]++;
+        }
+      }
+      std::vector<int> wordsOffsets(distinctIdsCount + 1, 0);
+      for (int position = 0; position < distinctIdsCount; position++)
+      {
+        wordsOffsets[position + 1] = wordsOffsets[position] + wordsCounts[position];
+      }
+      std::vector<int>      wordIndexes(wordsOffsets.back());
+      std::vector<uint64_t> words(wordsOffsets.back(), 0);
+      std::vector<int>      nextWords(wordsOffsets.begin(), wordsOffsets.end() - 1);
+      std::fill(lastWordIndexes.begin(), lastWordIndexes.end(), -1);
+      for (int tripIndex = 0; tripIndex < tripsCount; tripIndex++)
+      {
+        int position = idIndexes[tripIndex];
+        if (lastWordIndexes[position] != tripIndex / 64)
+        {
+          lastWordIndexes[position]        = tripIndex / 64;
+          wordIndexes[nextWords[position]] = tripIndex / 64;
+          nextWords[position]++;
+        }
+        words[nextWords[position] - 1] |= (uint64_t)1 << (tripIndex % 64);
+      }
+
+      std::map<unsigned long long, int> indexesById;
+      for (int position = 0; position < distinctIdsCount; position++)
+      {
+        indexesById[distinctIds[position]] = position;
+      }
+      bitsets.indexesById  = IdIndexMap(indexesById);
+      bitsets.wordsOffsets = std::move(wordsOffsets);
+      bitsets.wordIndexes  = std::move(wordIndexes);
+      bitsets.words        = std::move(words);
+      return bitsets;
+    }
+
+    // ORs the trips of these ids into tripsWords (unknown ids are ignored):
+    void addTrips(const std::vector<unsigned long long>& ids, uint64_t * tripsWords) const
+    {
+      for (auto & id : ids)
+      {
+        if (indexesById.count(id) == 1)
+        {
+          int position = indexesById.at(id);
+          for (int wordPosition = wordsOffsets[position]; wordPosition < wordsOffsets[position + 1]; wordPosition++)
+          {
+            tripsWords[wordIndexes[wordPosition]] |= words[wordPosition];
+          }
+        }
+      }
+    }
+
+    // clears the trips of these ids from tripsWords:
+    void removeTrips(const std::vector<unsigned long long>& ids, uint64_t * tripsWords) const
+    {
+      for (auto & id : ids)
+      {
+        if (indexesById.count(id) == 1)
+        {
+          int position = indexesById.at(id);
+          for (int wordPosition = wordsOffsets[position]; wordPosition < wordsOffsets[position + 1]; wordPosition++)
+          {
+            tripsWords[wordIndexes[wordPosition]] &= ~words[wordPosition];
+          }
+        }
+      }
+    }
+
+    // keeps only the trips of these ids in tripsWords, using filterWords (wordsCount words) as scratch:
+    void keepTrips(const std::vector<unsigned long long>& ids, uint64_t * tripsWords, uint64_t * filterWords, int wordsCount) const
+    {
+      std::fill(filterWords, filterWords + wordsCount, 0);
+      addTrips(ids, filterWords);
+      BitWords::andWith(tripsWords, filterWords, wordsCount);
+    }
+
+  };
+
+}
+
+#endif // TR_TRIPS_BITSETS
@@ -0,0 +1,121 @@
+#ifndef TR_WORKER_POOL
+#define TR_WORKER_POOL
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace TrRouting
+{
+
+  // fixed set of threads shared by all the requests, running the tasks posted to it in order. However many requests post
+  // tasks at the same time, no more than threadsCount tasks run at once:
+  class WorkerPool {
+
+  public:
+
+    WorkerPool(int threadsCount) : stopping(false)
+    {
+      for (int i = 0; i < std::max(1, threadsCount); i++)
+      {
+        threads.push_back(std::thread([this]() { work(); }));
+      }
+    }
+
+    ~WorkerPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      taskPosted.notify_all();
+      for (auto & thread : threads)
+      {
+        thread.join();
+      }
+    }
+
+    void post(std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+      }
+      taskPosted.notify_one();
+    }
+
+    int size() const { return threads.size(); }
+
+  private:
+
+    void work()
+    {
+      while (true)
+      {
+        std::function<void()> task; // released once run, with what it captured
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          taskPosted.wait(lock, [this]() { return stopping || !tasks.empty(); });
+          if (tasks.empty())
+          {
+            return;
+          }
+          task = std::move(tasks.front());
+          tasks.pop_front();
+        }
+        task();
+      }
+    }
+
+    std::vector<std::thread>          threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex                        mutex;
+    std::condition_variable           taskPosted;
+    bool                              stopping;
+
+  };
+
+  // wait in the posting thread until the tasks it posted have all run, so they can use its local variables:
+  class TasksGroup {
+
+  public:
+
+    TasksGroup() : pendingCount(0) {}
+
+    void post(WorkerPool& pool, std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingCount++;
+      }
+      pool.post([this, task]() {
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pendingCount == 0)
+        {
+          allDone.notify_all();
+        }
+      });
+    }
+
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      allDone.wait(lock, [this]() { return pendingCount == 0; });
+    }
+
+  private:
+
+    int                     pendingCount;
+    std::mutex              mutex;
+    std::condition_variable allDone;
+
+  };
+
+}
+
+#endif // TR_WORKER_POOL
@@ -78,15 +78,35 @@ namespace TrRouting
     return std::make_pair(trips, tripIndexesById);
   }
   
-  const std::pair<std::vector<std::tuple<int,int,int,int,int,short,short,int>>, std::vector<std::tuple<int,int,int,int,int,short,short,int>>> CacheFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  const std::pair<std::vector<Service>, std::map<unsigned long long, int>> CacheFetcher::getServices(std::string applicationShortname)
   {
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> forwardConnections;
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> reverseConnections;
+    std::vector<Service> services;
+    std::map<unsigned long long, int> serviceIndexesById;
+    
+    // service calendars are optional (trips are then not filtered by date), so no error when missing:
+    std::cout << "Fetching services from cache..." << std::endl;
+    if (CacheFetcher::cacheFileExists(applicationShortname, "services"))
+    {
+      services = loadFromCacheFile(services, applicationShortname, "services");
+    }
+    if (CacheFetcher::cacheFileExists(applicationShortname, "service_indexes"))
+    {
+      serviceIndexesById = loadFromCacheFile(serviceIndexesById, applicationShortname, "service_indexes");
+    }
+    return std::make_pair(services, serviceIndexesById);
+  }
+  
+  const std::pair<ConnectionTable, ConnectionTable> CacheFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  {
+    ConnectionTable forwardConnections;
+    ConnectionTable reverseConnections;
+    std::vector<ConnectionTuple> connectionTuples; // cache files keep the tuple format, so existing caches can still be loaded
     
     std::cout << "Fetching connections from cache..." << std::endl;
     if (CacheFetcher::cacheFileExists(applicationShortname, "connections_forward"))
     {
-      forwardConnections = loadFromCacheFile(forwardConnections, applicationShortname, "connections_forward");
+      connectionTuples   = loadFromCacheFile(connectionTuples, applicationShortname, "connections_forward");
+      forwardConnections = ConnectionTable::fromTuples(connectionTuples);
     }
     else
     {
@@ -94,7 +114,9 @@ namespace TrRouting
     }
     if (CacheFetcher::cacheFileExists(applicationShortname, "connections_forward"))
     {
-      reverseConnections = loadFromCacheFile(reverseConnections, applicationShortname, "connections_reverse");
+      connectionTuples.clear();
+      connectionTuples   = loadFromCacheFile(connectionTuples, applicationShortname, "connections_reverse");
+      reverseConnections = ConnectionTable::fromTuples(connectionTuples);
     }
     else
     {
@@ -130,7 +152,7 @@ namespace TrRouting
     
   }
 
-  const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> CacheFetcher::getOdTrips(std::string applicationShortname, std::vector<Stop> stops, Parameters& params)
+  const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> CacheFetcher::getOdTrips(std::string applicationShortname, const StopTable& stops, Parameters& params)
   {
     std::vector<OdTrip> odTrips;
     std::map<unsigned long long, int> odTripIndexesById;
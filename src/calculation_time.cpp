@@ -7,8 +7,9 @@ namespace TrRouting
 
   long long CalculationTime::getEpoch()
   {
+    // monotonic clock: durations are never distorted by system clock adjustments (the epoch is not the unix epoch):
     calculationEpoch = std::chrono::duration_cast< std::chrono::microseconds >(
-      std::chrono::system_clock::now().time_since_epoch()
+      std::chrono::steady_clock::now().time_since_epoch()
     );
     return calculationEpoch.count();
   }
@@ -24,10 +24,17 @@ namespace TrRouting
     return std::make_pair(trips, tripIndexesById);
   }
   
-  const std::pair<std::vector<std::tuple<int,int,int,int,int,short,short,int>>, std::vector<std::tuple<int,int,int,int,int,short,short,int>>> CsvFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  const std::pair<std::vector<Service>, std::map<unsigned long long, int>> CsvFetcher::getServices(std::string applicationShortname)
   {
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> forwardConnections;
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> reverseConnections;
+    std::vector<Service> services;
+    std::map<unsigned long long, int> serviceIndexesById;
+    return std::make_pair(services, serviceIndexesById);
+  }
+  
+  const std::pair<ConnectionTable, ConnectionTable> CsvFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  {
+    ConnectionTable forwardConnections;
+    ConnectionTable reverseConnections;
     return std::make_pair(forwardConnections, reverseConnections);
     
   }
@@ -230,10 +230,81 @@ namespace TrRouting
   }
   
   
-  const std::pair<std::vector<std::tuple<int,int,int,int,int,short,short,int>>, std::vector<std::tuple<int,int,int,int,int,short,short,int>>> DatabaseFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  const std::pair<std::vector<Service>, std::map<unsigned long long, int>> DatabaseFetcher::getServices(std::string applicationShortname)
   {
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> forwardConnections;
-    std::vector<std::tuple<int,int,int,int,int,short,short,int>> reverseConnections;
+    std::vector<Service> services;
+    std::map<unsigned long long, int> serviceIndexesById;
+    std::vector<std::string> datesVector;
+    
+    openConnection();
+    
+    std::cout << "Fetching services from database..." << std::endl;
+    std::string sqlQuery = "SELECT s.id, COALESCE(s.monday, FALSE), COALESCE(s.tuesday, FALSE), COALESCE(s.wednesday, FALSE), COALESCE(s.thursday, FALSE), COALESCE(s.friday, FALSE), COALESCE(s.saturday, FALSE), COALESCE(s.sunday, FALSE),"
+    " to_char(s.start_date, 'YYYYMMDD'), to_char(s.end_date, 'YYYYMMDD'),"
+    " COALESCE(array_to_string(ARRAY(SELECT to_char(d, 'YYYYMMDD') FROM unnest(s.only_dates) d), ','), ''),"
+    " COALESCE(array_to_string(ARRAY(SELECT to_char(d, 'YYYYMMDD') FROM unnest(s.except_dates) d), ','), '')"
+    " FROM " + applicationShortname + ".tr_services s "
+    " WHERE s.start_date IS NOT NULL AND s.end_date IS NOT NULL"
+    " ORDER BY s.id";
+    
+    std::cerr << sqlQuery << std::endl;
+    
+    if (isConnectionOpen())
+    {
+      
+      pqxx::nontransaction pgNonTransaction(*(getConnectionPtr()));
+      pqxx::result pgResult( pgNonTransaction.exec( sqlQuery ));
+      
+      for (pqxx::result::const_iterator c = pgResult.begin(); c != pgResult.end(); ++c) {
+        
+        // create a new service for each row:
+        Service * service = new Service();
+        // set service attributes from row:
+        service->id        = c[0].as<unsigned long long>();
+        service->monday    = c[1].as<bool>();
+        service->tuesday   = c[2].as<bool>();
+        service->wednesday = c[3].as<bool>();
+        service->thursday  = c[4].as<bool>();
+        service->friday    = c[5].as<bool>();
+        service->saturday  = c[6].as<bool>();
+        service->sunday    = c[7].as<bool>();
+        service->startDate = std::stoi(c[8].as<std::string>());
+        service->endDate   = std::stoi(c[9].as<std::string>());
+        for (int datesColumn = 10; datesColumn <= 11; datesColumn++)
+        {
+          std::vector<int> & dates = datesColumn == 10 ? service->onlyDates : service->exceptDates;
+          if (c[datesColumn].as<std::string>().size() > 0)
+          {
+            boost::split(datesVector, c[datesColumn].as<std::string>(), boost::is_any_of(","));
+            for (auto & date : datesVector)
+            {
+              dates.push_back(std::stoi(date));
+            }
+          }
+        }
+        
+        // append service:
+        services.push_back(*service);
+        serviceIndexesById[service->id] = services.size() - 1;
+        delete service;
+      }
+      
+      // save services and service indexes to binary cache file:
+      CacheFetcher::saveToCacheFile(applicationShortname, services, "services");
+      CacheFetcher::saveToCacheFile(applicationShortname, serviceIndexesById, "service_indexes");
+    
+    } else {
+      std::cout << "Can't open database" << std::endl;
+    }
+    
+    return std::make_pair(services, serviceIndexesById);
+    
+  }
+  
+  const std::pair<ConnectionTable, ConnectionTable> DatabaseFetcher::getConnections(std::string applicationShortname, std::map<unsigned long long, int> stopIndexesById, std::map<unsigned long long, int> tripIndexesById)
+  {
+    ConnectionTable forwardConnections;
+    ConnectionTable reverseConnections;
     
     openConnection();
     
@@ -258,9 +329,10 @@ namespace TrRouting
       std::cout << std::fixed;
       std::cout << std::setprecision(2);
 
+      forwardConnections.reserve(resultCount);
       for (pqxx::result::const_iterator c = pgResult.begin(); c != pgResult.end(); ++c) {
         
-        forwardConnections.push_back(std::make_tuple(stopIndexesById[c[5].as<unsigned long long>()], stopIndexesById[c[6].as<unsigned long long>()], c[3].as<int>(), c[4].as<int>(), tripIndexesById[c[0].as<unsigned long long>()], c[1].as<short>(), c[2].as<short>(), c[7].as<int>())); // departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
+        forwardConnections.push_back(stopIndexesById[c[5].as<unsigned long long>()], stopIndexesById[c[6].as<unsigned long long>()], c[3].as<int>(), c[4].as<int>(), tripIndexesById[c[0].as<unsigned long long>()], c[1].as<short>(), c[2].as<short>(), c[7].as<int>()); // departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
         //reverseConnections.push_back(std::make_tuple(stopIndexesById[c[6].as<unsigned long long>()], stopIndexesById[c[5].as<unsigned long long>()], MAX_INT - c[4].as<int>(), MAX_INT - c[3].as<int>(), tripIndexesById[c[0].as<unsigned long long>()], c[2].as<short>(), c[1].as<short>(), c[7].as<int>())); // departureStopIndex, arrivalStopIndex, departureTimeSeconds, arrivalTimeSeconds, tripIndex, canBoard, canUnboard, sequence in trip
         
         // show loading progress in percentage:
@@ -274,42 +346,46 @@ namespace TrRouting
       
       std::cout << "Sorting reverse connections..." << std::endl;
       //std::reverse(reverseConnections.begin(), reverseConnections.end());
-      reverseConnections = forwardConnections;
-      std::stable_sort(reverseConnections.begin(), reverseConnections.end(), [](std::tuple<int,int,int,int,int,short,short,int> connectionA, std::tuple<int,int,int,int,int,short,short,int> connectionB)
+      std::vector<int> reverseConnectionIndexes(forwardConnections.size());
+      std::iota(reverseConnectionIndexes.begin(), reverseConnectionIndexes.end(), 0);
+      std::stable_sort(reverseConnectionIndexes.begin(), reverseConnectionIndexes.end(), [&forwardConnections](int connectionIndexA, int connectionIndexB)
       {
-        // { STOP_DEP = 0, STOP_ARR = 1, TIME_DEP = 2, TIME_ARR = 3, TRIP = 4, CAN_BOARD = 5, CAN_UNBOARD = 6, SEQUENCE = 7 };
-        if (std::get<3>(connectionA) > std::get<3>(connectionB))
+        // sort by arrival time, trip and sequence, all descending:
+        if (forwardConnections.arrivalTimes[connectionIndexA] > forwardConnections.arrivalTimes[connectionIndexB])
         {
           return true;
         }
-        else if (std::get<3>(connectionA) < std::get<3>(connectionB))
+        else if (forwardConnections.arrivalTimes[connectionIndexA] < forwardConnections.arrivalTimes[connectionIndexB])
         {
           return false;
         }
-        if (std::get<4>(connectionA) > std::get<4>(connectionB)) // here we need to reverse sequence!
+        if (forwardConnections.tripIndexes[connectionIndexA] > forwardConnections.tripIndexes[connectionIndexB]) // here we need to reverse sequence!
         {
           return true;
         }
-        else if (std::get<4>(connectionA) < std::get<4>(connectionB))
+        else if (forwardConnections.tripIndexes[connectionIndexA] < forwardConnections.tripIndexes[connectionIndexB])
         {
           return false;
         }
-        if (std::get<7>(connectionA) > std::get<7>(connectionB)) // here we need to reverse sequence!
+        if (forwardConnections.sequences[connectionIndexA] > forwardConnections.sequences[connectionIndexB]) // here we need to reverse sequence!
         {
           return true;
         }
-        else if (std::get<7>(connectionA) < std::get<7>(connectionB))
+        else if (forwardConnections.sequences[connectionIndexA] < forwardConnections.sequences[connectionIndexB])
         {
           return false;
         }
         return false;
       });
+      reverseConnections = forwardConnections.select(reverseConnectionIndexes);
 
       // save connections to binary cache files:
       std::cout << "Saving forward connections to cache..." << std::endl;
-      CacheFetcher::saveToCacheFile(applicationShortname, forwardConnections, "connections_forward");
+      std::vector<ConnectionTuple> connectionTuples = forwardConnections.toTuples();
+      CacheFetcher::saveToCacheFile(applicationShortname, connectionTuples, "connections_forward");
       std::cout << "Saving reverse connections to cache..." << std::endl;
-      CacheFetcher::saveToCacheFile(applicationShortname, reverseConnections, "connections_reverse");
+      connectionTuples = reverseConnections.toTuples();
+      CacheFetcher::saveToCacheFile(applicationShortname, connectionTuples, "connections_reverse");
   
     } else {
       std::cout << "Can't open database" << std::endl;
@@ -390,7 +466,7 @@ namespace TrRouting
     return std::make_pair(footpaths, footpathsRanges);
   }
   
-  const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> DatabaseFetcher::getOdTrips(std::string applicationShortname, std::vector<Stop> stops, Parameters& params)
+  const std::pair<std::vector<OdTrip>, std::map<unsigned long long, int>> DatabaseFetcher::getOdTrips(std::string applicationShortname, const StopTable& stops, Parameters& params)
   {
     
     std::vector<OdTrip> odTrips;
@@ -422,6 +498,9 @@ namespace TrRouting
       
       unsigned long long odTripId;
       
+      StopsSpatialIndex stopsSpatialIndex(stops);
+      std::vector<std::vector<std::pair<int,int>>> accessAndEgressFootpaths;
+      
       for (pqxx::result::const_iterator c = pgResult.begin(); c != pgResult.end(); ++c) {
         
         // set trip attributes from row:
@@ -459,8 +538,9 @@ namespace TrRouting
         odTrip->cyclingTravelTimeSeconds = c[16].as<int>();
         odTrip->drivingTravelTimeSeconds = c[17].as<int>();
         
-        odTrip->accessFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoint(odTrip->origin,      stops, "walking", 1200, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
-        odTrip->egressFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoint(odTrip->destination, stops, "walking", 1200, params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+        accessAndEgressFootpaths = OsrmFetcher::getAccessibleStopsFootpathsFromPoints({odTrip->origin, odTrip->destination}, {1200, 1200}, stops, stopsSpatialIndex, "walking", params.walkingSpeedMetersPerSecond, params.osrmRoutingWalkingHost, params.osrmRoutingWalkingPort);
+        odTrip->accessFootpaths  = accessAndEgressFootpaths[0];
+        odTrip->egressFootpaths  = accessAndEgressFootpaths[1];
         
         // append trip:
         odTrips.push_back(*odTrip);
@@ -3,82 +3,330 @@
 namespace TrRouting
 {
   
-  std::vector<std::pair<int,int>> OsrmFetcher::getAccessibleStopsFootpathsFromPoint(const Point point, const std::vector<Stop> stops, std::string mode, int maxTravelTimeSeconds, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort)
+  namespace
   {
+    // idle keep-alive connections by "host:port":
+    std::mutex                                                                           osrmConnectionsMutex;
+    std::map<std::string, std::vector<std::unique_ptr<boost::asio::ip::tcp::iostream>>> osrmIdleConnections;
+    const int                                                                            maxIdleConnectionsPerHost {32};
     
-    std::vector<int>                birdDistanceAccessibleStopIndexes;
-    std::vector<std::pair<int,int>> accessibleStopsFootpaths;
-    
-    //std::cout << "mode = " << mode << " speed = " << defaultSpeedMetersPerSecond << " maxTravelTime = " << maxTravelTimeSeconds << " port = " << osrmPort << " host = " << osrmHost << " " << std::endl;
+    // read one http response (content-length, chunked or until connection close), false if the connection failed:
+    bool readHttpResponse(boost::asio::ip::tcp::iostream& connection, std::string& body, bool& keepAlive)
+    {
+      std::string line;
+      if (!std::getline(connection, line) || line.compare(0, 5, "HTTP/") != 0)
+      {
+        return false;
+      }
+      keepAlive = line.compare(0, 8, "HTTP/1.0") != 0;
+      
+      long long contentLength {-1};
+      bool      chunked {false};
+      while (std::getline(connection, line) && line != "\r" && line != "")
+      {
+        std::string header = boost::algorithm::to_lower_copy(line);
+        if (header.compare(0, 15, "content-length:") == 0)
+        {
+          contentLength = std::stoll(header.substr(15));
+        }
+        else if (header.compare(0, 18, "transfer-encoding:") == 0 && header.find("chunked") != std::string::npos)
+        {
+          chunked = true;
+        }
+        else if (header.compare(0, 11, "connection:") == 0)
+        {
+          keepAlive = header.find("close") == std::string::npos;
+        }
+      }
+      if (!connection)
+      {
+        return false;
+      }
+      
+      body.clear();
+      if (contentLength >= 0)
+      {
+        body.resize(contentLength);
+        connection.read(&body[0], contentLength);
+      }
+      else if (chunked)
+      {
+        long long chunkSize;
+        while (std::getline(connection, line))
+        {
+          chunkSize = std::stoll(line, nullptr, 16);
+          if (chunkSize == 0)
+          {
+            while (std::getline(connection, line) && line != "\r" && line != ""){} // ignore trailers
+            break;
+          }
+          size_t bodySize = body.size();
+          body.resize(bodySize + chunkSize);
+          connection.read(&body[bodySize], chunkSize);
+          std::getline(connection, line); // end of chunk
+        }
+      }
+      else
+      {
+        std::stringstream bodySs;
+        bodySs << connection.rdbuf();
+        body      = bodySs.str();
+        keepAlive = false;
+        return true;
+      }
+      return (bool)connection;
+    }
     
-    std::string queryString = "GET /table/v1/" + mode + "/" + std::to_string(point.longitude) +  "," + std::to_string(point.latitude);
+    void skipWhitespaces(const std::string& json, size_t& i)
+    {
+      while (i < json.size() && (json[i] == ' ' || json[i] == '\n' || json[i] == '\r' || json[i] == '\t'))
+      {
+        i++;
+      }
+    }
+  }
+  
+  std::string OsrmFetcher::httpGet(const std::string& path, std::string host, std::string port)
+  {
+    std::string connectionKey = host + ":" + port;
+    std::string body;
+    bool        keepAlive;
     
-    float lengthOfOneDegreeOfLongitude = 111412.84 * cos(point.latitude * M_PI / 180) -93.5 * cos (3 * point.latitude * M_PI / 180);
-    float lengthOfOneDegreeOflatitude  = 111132.92 - 559.82 * cos(2 * point.latitude * M_PI / 180) + 1.175 * cos(4 * point.latitude * M_PI / 180);
-    float maxDistanceMetersSquared     = (maxTravelTimeSeconds * defaultSpeedMetersPerSecond) * (maxTravelTimeSeconds * defaultSpeedMetersPerSecond);
-    float distanceMetersSquared;
-    float distanceXMeters;
-    float distanceYMeters;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+      std::unique_ptr<boost::asio::ip::tcp::iostream> connection;
+      {
+        std::lock_guard<std::mutex> lock(osrmConnectionsMutex);
+        std::vector<std::unique_ptr<boost::asio::ip::tcp::iostream>> & idleConnections = osrmIdleConnections[connectionKey];
+        if (idleConnections.size() > 0)
+        {
+          connection = std::move(idleConnections.back());
+          idleConnections.pop_back();
+        }
+      }
+      bool reusedConnection = (bool)connection;
+      if (!reusedConnection)
+      {
+        connection.reset(new boost::asio::ip::tcp::iostream());
+        connection->connect(host, port);
+        if (!*connection)
+        {
+          std::cerr << "could not connect to osrm at " << connectionKey << std::endl;
+          return "";
+        }
+      }
+      
+      *connection << "GET " << path << " HTTP/1.1\r\nHost: " << host << "\r\nConnection: keep-alive\r\n\r\n" << std::flush;
+      
+      if (*connection && readHttpResponse(*connection, body, keepAlive))
+      {
+        if (keepAlive)
+        {
+          std::lock_guard<std::mutex> lock(osrmConnectionsMutex);
+          std::vector<std::unique_ptr<boost::asio::ip::tcp::iostream>> & idleConnections = osrmIdleConnections[connectionKey];
+          if ((int)idleConnections.size() < maxIdleConnectionsPerHost)
+          {
+            idleConnections.push_back(std::move(connection));
+          }
+        }
+        return body;
+      }
+      
+      if (!reusedConnection) // a pooled connection may have been closed by osrm while idle, retry once with a new one
+      {
+        break;
+      }
+    }
+    return "";
+  }
+  
+  bool OsrmFetcher::parseDurations(const std::string& responseJson, std::vector<std::vector<double>>& durations)
+  {
+    durations.clear();
     
-    int i {0};
-    for (auto & stop : stops)
+    // find the "durations" key in the top level object, skipping strings (stop names, etc.) and nested values:
+    size_t i {0};
+    size_t keyStart;
+    int    depth {0};
+    bool   found {false};
+    while (i < responseJson.size() && !found)
     {
-      distanceXMeters       = (stop.point.longitude - point.longitude) * lengthOfOneDegreeOfLongitude;
-      distanceYMeters       = (stop.point.latitude  - point.latitude)  * lengthOfOneDegreeOflatitude ;
-      distanceMetersSquared = distanceXMeters * distanceXMeters + distanceYMeters * distanceYMeters;
-      if (distanceMetersSquared <= maxDistanceMetersSquared)
+      char c = responseJson[i];
+      if (c == '"')
       {
-        birdDistanceAccessibleStopIndexes.push_back(i);
-        queryString += ";" + std::to_string(stop.point.longitude) +  "," + std::to_string(stop.point.latitude);
+        keyStart = ++i;
+        while (i < responseJson.size() && responseJson[i] != '"')
+        {
+          i += responseJson[i] == '\\' ? 2 : 1;
+        }
+        if (i >= responseJson.size())
+        {
+          return false;
+        }
+        if (depth == 1 && responseJson.compare(keyStart, i - keyStart, "durations") == 0)
+        {
+          i++;
+          skipWhitespaces(responseJson, i);
+          found = i < responseJson.size() && responseJson[i] == ':';
+        }
+      }
+      else if (c == '{' || c == '[')
+      {
+        depth++;
+      }
+      else if (c == '}' || c == ']')
+      {
+        depth--;
       }
       i++;
     }
+    if (!found)
+    {
+      return false;
+    }
     
+    // durations: array of rows (one per source), each row an array of numbers or null:
+    const char * json = responseJson.c_str();
+    char * valueEnd;
+    skipWhitespaces(responseJson, i);
+    if (i >= responseJson.size() || json[i] != '[')
+    {
+      return false;
+    }
+    i++;
+    while (true)
+    {
+      skipWhitespaces(responseJson, i);
+      if (i >= responseJson.size())
+      {
+        return false;
+      }
+      if (json[i] == ']')
+      {
+        return true;
+      }
+      if (json[i] == ',')
+      {
+        i++;
+        continue;
+      }
+      if (json[i] != '[')
+      {
+        return false;
+      }
+      i++;
+      durations.push_back(std::vector<double>());
+      std::vector<double> & row = durations.back();
+      while (true)
+      {
+        skipWhitespaces(responseJson, i);
+        if (i >= responseJson.size())
+        {
+          return false;
+        }
+        if (json[i] == ']')
+        {
+          i++;
+          break;
+        }
+        if (json[i] == ',')
+        {
+          i++;
+        }
+        else if (responseJson.compare(i, 4, "null") == 0)
+        {
+          row.push_back(-1);
+          i += 4;
+        }
+        else
+        {
+          row.push_back(strtod(json + i, &valueEnd));
+          if (valueEnd == json + i)
+          {
+            return false;
+          }
+          i = valueEnd - json;
+        }
+      }
+    }
+  }
+  
+  std::vector<std::pair<int,int>> OsrmFetcher::getAccessibleStopsFootpathsFromPoint(const Point& point, const StopTable& stops, const StopsSpatialIndex& stopsSpatialIndex, std::string mode, int maxTravelTimeSeconds, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort)
+  {
+    return getAccessibleStopsFootpathsFromPoints(std::vector<Point>(1, point), std::vector<int>(1, maxTravelTimeSeconds), stops, stopsSpatialIndex, mode, defaultSpeedMetersPerSecond, osrmHost, osrmPort)[0];
+  }
+  
+  std::vector<std::vector<std::pair<int,int>>> OsrmFetcher::getAccessibleStopsFootpathsFromPoints(const std::vector<Point>& points, const std::vector<int>& maxTravelTimesSeconds, const StopTable& stops, const StopsSpatialIndex& stopsSpatialIndex, std::string mode, float defaultSpeedMetersPerSecond, std::string osrmHost, std::string osrmPort)
+  {
     
-    // call osrm on bird distance accessible stops for further filtering by network travel time:
-    boost::asio::ip::tcp::iostream s;
-    s.connect(osrmHost, osrmPort);
-    queryString += "?sources=0";
-    queryString += " HTTP/1.1\r\n\r\n";
-    
-   // std::cerr << queryString << std::endl;
-        
-    s << queryString;
-    
-    std::string header;
-    while (std::getline(s, header) && header != "\r"){} // ignore first line
-    
-    std::stringstream responseJsonSs;
-    responseJsonSs << s.rdbuf();
-    
-    boost::property_tree::ptree pt;
-    boost::property_tree::read_json(responseJsonSs, pt);
+    int pointsCount = points.size();
+    std::vector<std::vector<std::pair<int,int>>> accessibleStopsFootpaths(pointsCount);
+    std::vector<std::vector<int>>                birdDistanceAccessibleStopIndexes(pointsCount);
+    std::vector<int>                             destinationStopIndexes; // all bird distance accessible stops, sorted and unique
     
-    //std::cerr << responseJsonSs.str() << std::endl;
+    //std::cout << "mode = " << mode << " speed = " << defaultSpeedMetersPerSecond << " points = " << pointsCount << " port = " << osrmPort << " host = " << osrmHost << " " << std::endl;
     
-    using boost::property_tree::ptree;
+    // only look at stops in grid cells around each point:
+    int i {0};
+    for (auto & point : points)
+    {
+      birdDistanceAccessibleStopIndexes[i] = stopsSpatialIndex.getStopIndexesAround(point, maxTravelTimesSeconds[i] * defaultSpeedMetersPerSecond);
+      destinationStopIndexes.insert(destinationStopIndexes.end(), birdDistanceAccessibleStopIndexes[i].begin(), birdDistanceAccessibleStopIndexes[i].end());
+      i++;
+    }
+    std::sort(destinationStopIndexes.begin(), destinationStopIndexes.end());
+    destinationStopIndexes.erase(std::unique(destinationStopIndexes.begin(), destinationStopIndexes.end()), destinationStopIndexes.end());
+    if (destinationStopIndexes.size() == 0)
+    {
+      return accessibleStopsFootpaths;
+    }
     
-    //std::cout << "duration count = " << pt.count("durations") << std::endl;
+    // call osrm on bird distance accessible stops for further filtering by network travel time.
+    // coordinates: the points (sources), then the stops (destinations):
+    std::string queryPath = "/table/v1/" + mode + "/";
+    std::string sources;
+    std::string destinations;
+    for (i = 0; i < pointsCount; i++)
+    {
+      queryPath += (i > 0 ? ";" : "") + std::to_string(points[i].longitude) +  "," + std::to_string(points[i].latitude);
+      sources   += (i > 0 ? ";" : "") + std::to_string(i);
+    }
+    i = pointsCount;
+    for (auto & stopIndex : destinationStopIndexes)
+    {
+      queryPath    += ";" + std::to_string(stops.points[stopIndex].longitude) +  "," + std::to_string(stops.points[stopIndex].latitude);
+      destinations += (i > pointsCount ? ";" : "") + std::to_string(i);
+      i++;
+    }
+    queryPath += "?sources=" + sources + "&destinations=" + destinations;
     
-    i = -1;
+    //std::cerr << queryPath << std::endl;
     
-    if (pt.count("durations") == 1)
+    std::vector<std::vector<double>> durations;
+    if (!parseDurations(httpGet(queryPath, osrmHost, osrmPort), durations) || (int)durations.size() != pointsCount)
     {
-      ptree durations = pt.get_child("durations");
+      return accessibleStopsFootpaths;
+    }
     
-      int travelTimeSeconds;
-      
-      for (const auto& v : durations) {
-        for (const auto& v2 : v.second) {
-          if(i >= 0) // first value is duration with self, we must ignore it (i was initialized with -1)
-          {
-            travelTimeSeconds = (int)ceil(std::stod(v2.second.data()));
-            if (travelTimeSeconds <= maxTravelTimeSeconds)
-            {
-              accessibleStopsFootpaths.push_back(std::make_pair(birdDistanceAccessibleStopIndexes[i], travelTimeSeconds));
-            }
-          }
-          i++;
+    int travelTimeSeconds;
+    int destinationIndex;
+    for (i = 0; i < pointsCount; i++)
+    {
+      if (durations[i].size() != destinationStopIndexes.size())
+      {
+        continue;
+      }
+      for (auto & stopIndex : birdDistanceAccessibleStopIndexes[i])
+      {
+        destinationIndex = std::lower_bound(destinationStopIndexes.begin(), destinationStopIndexes.end(), stopIndex) - destinationStopIndexes.begin();
+        if (durations[i][destinationIndex] < 0) // null: no route
+        {
+          continue;
+        }
+        travelTimeSeconds = (int)ceil(durations[i][destinationIndex]);
+        if (travelTimeSeconds <= maxTravelTimesSeconds[i])
+        {
+          accessibleStopsFootpaths[i].push_back(std::make_pair(stopIndex, travelTimeSeconds));
         }
       }
     }